@@ -8,6 +8,14 @@ public class ITP : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput" });
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput", "Paper2D", "Niagara", "NetCore" });
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore", "IrisCore" });
+
+		// Defines UE_WITH_IRIS from the target's bUseIris; ITP actors use push-model properties so both paths work
+		SetupIrisSupport(Target);
+
+		// 1 = run the ITP kinematic core in Q16.16 fixed point for cross-platform deterministic replays
+		PublicDefinitions.Add("ITP_FIXED_POINT_KINEMATICS=0");
 	}
 }
@@ -3,5 +3,6 @@
 #include "ITP.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogITP);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, ITP, "ITP" );
- 
\ No newline at end of file
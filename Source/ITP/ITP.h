@@ -3,3 +3,8 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogITP, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("ITP"), STATGROUP_ITP, STATCAT_Advanced);
@@ -0,0 +1,129 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPActorPoolSubsystem.h"
+#include "ITP.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Actor Pool Prewarm"), STAT_ITPActorPoolPrewarm, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Actor Pool Misses"), STAT_ITPActorPoolMisses, STATGROUP_ITP);
+
+static int32 GITPPoolPrewarmPerFrame = 4;
+static FAutoConsoleVariableRef CVarITPPoolPrewarmPerFrame(
+	TEXT("ITP.Pool.PrewarmPerFrame"),
+	GITPPoolPrewarmPerFrame,
+	TEXT("Pooled actors spawned per frame while prewarming."));
+
+void UITPActorPoolSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ITPActorPoolPrewarm);
+
+	int32 Budget = GITPPoolPrewarmPerFrame;
+	for (auto It = PrewarmTargets.CreateIterator(); It && Budget > 0; ++It)
+	{
+		FITPActorPoolBucket& Bucket = Free.FindOrAdd(It->Key);
+		while (Bucket.Actors.Num() < It->Value && Budget > 0)
+		{
+			if (AActor* Actor = SpawnDormant(It->Key))
+			{
+				Bucket.Actors.Add(Actor);
+			}
+			--Budget;
+		}
+
+		if (Bucket.Actors.Num() >= It->Value)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+TStatId UITPActorPoolSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UITPActorPoolSubsystem, STATGROUP_ITP);
+}
+
+bool UITPActorPoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UITPActorPoolSubsystem::Prewarm(TSubclassOf<AActor> Class, int32 Count)
+{
+	if (Class && !IsWarm(Class, Count))
+	{
+		int32& Target = PrewarmTargets.FindOrAdd(Class.Get());
+		Target = FMath::Max(Target, Count);
+	}
+}
+
+bool UITPActorPoolSubsystem::IsWarm(TSubclassOf<AActor> Class, int32 Count) const
+{
+	const FITPActorPoolBucket* Bucket = Free.Find(Class.Get());
+	return Bucket && Bucket->Actors.Num() >= Count;
+}
+
+AActor* UITPActorPoolSubsystem::Acquire(TSubclassOf<AActor> Class, const FTransform& Transform)
+{
+	if (!Class)
+	{
+		return nullptr;
+	}
+
+	AActor* Actor = nullptr;
+	FITPActorPoolBucket* Bucket = Free.Find(Class.Get());
+	while (!Actor && Bucket && !Bucket->Actors.IsEmpty())
+	{
+		Actor = Bucket->Actors.Pop(false);
+		Actor = IsValid(Actor) ? Actor : nullptr;
+	}
+
+	if (!Actor)
+	{
+		INC_DWORD_STAT(STAT_ITPActorPoolMisses);
+		Actor = SpawnDormant(Class.Get());
+		if (!Actor)
+		{
+			return nullptr;
+		}
+	}
+
+	Actor->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+	SetDormant(Actor, false);
+	return Actor;
+}
+
+void UITPActorPoolSubsystem::Release(AActor* Actor)
+{
+	if (IsValid(Actor))
+	{
+		SetDormant(Actor, true);
+		Free.FindOrAdd(Actor->GetClass()).Actors.Add(Actor);
+	}
+}
+
+AActor* UITPActorPoolSubsystem::SpawnDormant(UClass* Class)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	AActor* Actor = GetWorld()->SpawnActor<AActor>(Class, FTransform::Identity, SpawnParams);
+	if (Actor)
+	{
+		SetDormant(Actor, true);
+	}
+	return Actor;
+}
+
+void UITPActorPoolSubsystem::SetDormant(AActor* Actor, bool bDormant)
+{
+	Actor->SetActorHiddenInGame(bDormant);
+	Actor->SetActorEnableCollision(!bDormant);
+	Actor->SetActorTickEnabled(!bDormant);
+
+	// A net dormant actor would keep showing clients its old state; send the change once
+	if (Actor->GetIsReplicated())
+	{
+		Actor->FlushNetDormancy();
+	}
+}
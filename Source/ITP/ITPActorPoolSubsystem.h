@@ -0,0 +1,53 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ITPActorPoolSubsystem.generated.h"
+
+/** Dormant actors of one class */
+USTRUCT()
+struct FITPActorPoolBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<TObjectPtr<AActor>> Actors;
+};
+
+/**
+ * Dormant actors kept ready for reuse, so gameplay never pays for spawning at a bad moment.
+ * Prewarm requests are spread over frames (ITP.Pool.PrewarmPerFrame). Pooled actors are hidden, without
+ * collision and not ticking until acquired.
+ */
+UCLASS()
+class ITP_API UITPActorPoolSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Makes sure at least Count dormant actors of Class exist, a few per frame */
+	void Prewarm(TSubclassOf<AActor> Class, int32 Count);
+
+	/** Whether Prewarm(Class, Count) has completed */
+	bool IsWarm(TSubclassOf<AActor> Class, int32 Count) const;
+
+	/** Takes a pooled actor, spawning one if the pool is empty */
+	AActor* Acquire(TSubclassOf<AActor> Class, const FTransform& Transform);
+
+	void Release(AActor* Actor);
+
+private:
+	AActor* SpawnDormant(UClass* Class);
+	static void SetDormant(AActor* Actor, bool bDormant);
+
+	UPROPERTY(Transient)
+	TMap<TObjectPtr<UClass>, FITPActorPoolBucket> Free;
+
+	TMap<TObjectPtr<UClass>, int32> PrewarmTargets;
+};
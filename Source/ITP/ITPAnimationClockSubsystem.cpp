@@ -0,0 +1,182 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPAnimationClockSubsystem.h"
+#include "ITP.h"
+#include "ITPFrameGovernorSubsystem.h"
+#include "ITPIdleSubsystem.h"
+#include "ITPMath2D.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "PaperFlipbook.h"
+#include "PaperFlipbookComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Animation Clock"), STAT_ITPAnimationClock, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sprites Advanced"), STAT_ITPSpritesAdvanced, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sprite Frames Changed"), STAT_ITPSpriteFramesChanged, STATGROUP_ITP);
+
+void UITPAnimationClockSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ITPAnimationClock);
+	FITPGovernorScope GovernorScope(GetWorld(), EITPGovernedSystem::AnimationClock);
+
+	// Under load the governor advances the clock every few frames, with the skipped frames' time added on
+	SkippedSeconds += DeltaTime;
+	const int32 Stride = 1 << UITPFrameGovernorSubsystem::GetKnobLevel(GetWorld(), EITPGovernorKnob::AnimationClockRate);
+	if (++FramesSinceAdvance < Stride)
+	{
+		return;
+	}
+	DeltaTime = SkippedSeconds;
+	SkippedSeconds = 0.f;
+	FramesSinceAdvance = 0;
+
+	int32 NumChanged = 0;
+	for (int32 Index = Components.Num() - 1; Index >= 0; --Index)
+	{
+		UPaperFlipbookComponent* Component = Components[Index].Get();
+		if (!Component)
+		{
+			RemoveAt(Index);
+			continue;
+		}
+
+		const float Length = Lengths[Index];
+		if (Length <= 0.f || !Component->GetFlipbook())
+		{
+			continue;
+		}
+
+		float Time = Times[Index] + DeltaTime * PlayRates[Index];
+		Time = Looping[Index] ? FMath::Fmod(Time, Length) : FMath::Min(Time, Length);
+		Times[Index] = Time;
+
+		// Most sprites hold a key frame for several game frames; skip the component entirely until it changes
+		const int32 KeyFrame = Component->GetFlipbook()->GetKeyFrameIndexAtTime(Time);
+		if (KeyFrame != KeyFrames[Index])
+		{
+			KeyFrames[Index] = KeyFrame;
+			Component->SetPlaybackPosition(Time, false);
+			++NumChanged;
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_ITPSpritesAdvanced, Components.Num());
+	INC_DWORD_STAT_BY(STAT_ITPSpriteFramesChanged, NumChanged);
+}
+
+TStatId UITPAnimationClockSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UITPAnimationClockSubsystem, STATGROUP_ITP);
+}
+
+bool UITPAnimationClockSubsystem::IsTickable() const
+{
+	return Super::IsTickable() && !UITPIdleSubsystem::IsSuspended(GetWorld());
+}
+
+bool UITPAnimationClockSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UITPAnimationClockSubsystem::Register(UPaperFlipbookComponent* Component)
+{
+	if (!Component || IndexOf.Contains(Component))
+	{
+		return;
+	}
+
+	Component->SetComponentTickEnabled(false);
+	Component->Stop();
+
+	IndexOf.Add(Component, Components.Num());
+	Components.Add(Component);
+	Keys.Add(Component);
+	Times.Add(Component->GetPlaybackPosition());
+	PlayRates.Add(Component->GetPlayRate());
+	Lengths.Add(Component->GetFlipbookLength());
+	KeyFrames.Add(INDEX_NONE);
+	Looping.Add(Component->IsLooping());
+}
+
+void UITPAnimationClockSubsystem::Unregister(UPaperFlipbookComponent* Component)
+{
+	if (const int32* Index = IndexOf.Find(Component))
+	{
+		RemoveAt(*Index);
+	}
+}
+
+void UITPAnimationClockSubsystem::Play(UPaperFlipbookComponent* Component, UPaperFlipbook* Flipbook, bool bLooping, float PlayRate)
+{
+	const int32* Index = IndexOf.Find(Component);
+	if (!Index || !Flipbook)
+	{
+		return;
+	}
+
+	if (Component->GetFlipbook() != Flipbook)
+	{
+		Component->SetFlipbook(Flipbook);
+		Times[*Index] = 0.f;
+		Lengths[*Index] = Flipbook->GetTotalDuration();
+		KeyFrames[*Index] = INDEX_NONE;
+	}
+
+	PlayRates[*Index] = PlayRate;
+	Looping[*Index] = bLooping;
+}
+
+void UITPAnimationClockSubsystem::RemoveAt(int32 Index)
+{
+	// Keys, not the weak pointers: a destroyed component's weak pointer no longer resolves to its key
+	IndexOf.Remove(Keys[Index]);
+
+	const int32 Last = Components.Num() - 1;
+	if (Index != Last)
+	{
+		IndexOf.Add(Keys[Last], Index);
+		Looping[Index] = Looping[Last];
+	}
+
+	Components.RemoveAtSwap(Index, 1, false);
+	Keys.RemoveAtSwap(Index, 1, false);
+	Times.RemoveAtSwap(Index, 1, false);
+	PlayRates.RemoveAtSwap(Index, 1, false);
+	Lengths.RemoveAtSwap(Index, 1, false);
+	KeyFrames.RemoveAtSwap(Index, 1, false);
+	Looping.RemoveAt(Last);
+}
+
+/** Spawns animated sprites around the first player so the clock's cost can be read from "stat ITP" */
+static FAutoConsoleCommandWithWorldAndArgs CmdITPAnimationBenchmark(
+	TEXT("ITP.Animation.Benchmark"),
+	TEXT("ITP.Animation.Benchmark <Count> <FlipbookPath>: spawns Count flipbook actors driven by the animation clock."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UITPAnimationClockSubsystem* Clock = World ? World->GetSubsystem<UITPAnimationClockSubsystem>() : nullptr;
+		UPaperFlipbook* Flipbook = Args.Num() > 1 ? LoadObject<UPaperFlipbook>(nullptr, *Args[1]) : nullptr;
+		if (!Clock || !Flipbook)
+		{
+			UE_LOG(LogITP, Warning, TEXT("ITP.Animation.Benchmark needs a game world and a valid flipbook path"));
+			return;
+		}
+
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000;
+		const int32 Columns = FMath::Max(FMath::CeilToInt32(FMath::Sqrt((float)Count)), 1);
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			AActor* Actor = World->SpawnActor<AActor>();
+			UPaperFlipbookComponent* Sprite = NewObject<UPaperFlipbookComponent>(Actor);
+			Actor->SetRootComponent(Sprite);
+			Sprite->SetFlipbook(Flipbook);
+			Sprite->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+			Sprite->RegisterComponent();
+			Sprite->SetWorldLocation(ITP2D::ToWorld(FVector2f(Index % Columns, Index / Columns) * ITP2D::DefaultTileSize));
+			Clock->Register(Sprite);
+
+			// Desynchronize so frame changes are spread over the run like in real play
+			Clock->Play(Sprite, Flipbook, true, FMath::FRandRange(0.8f, 1.2f));
+		}
+		UE_LOG(LogITP, Log, TEXT("Spawned %d benchmark sprites"), Count);
+	}));
@@ -0,0 +1,57 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "ITPAnimationClockSubsystem.generated.h"
+
+class UPaperFlipbook;
+class UPaperFlipbookComponent;
+
+/**
+ * Advances every registered flipbook component in one pass instead of each component ticking itself.
+ * Components are only touched when their key frame changes; the resulting render updates go out with the
+ * engine's end-of-frame batch. The frame governor can lower the clock's update rate under load.
+ */
+UCLASS()
+class ITP_API UITPAnimationClockSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Disables the component's own tick and drives it from the clock */
+	void Register(UPaperFlipbookComponent* Component);
+	void Unregister(UPaperFlipbookComponent* Component);
+
+	/** Switches Component to Flipbook, restarting it if it was playing a different one */
+	void Play(UPaperFlipbookComponent* Component, UPaperFlipbook* Flipbook, bool bLooping = true, float PlayRate = 1.f);
+
+	int32 GetNumRegistered() const { return Components.Num(); }
+
+private:
+	void RemoveAt(int32 Index);
+
+	/** Parallel arrays indexed through IndexOf */
+	TArray<TWeakObjectPtr<UPaperFlipbookComponent>> Components;
+
+	/** IndexOf key of each slot, kept so a slot whose component is gone can still be found and moved */
+	TArray<TObjectKey<UPaperFlipbookComponent>> Keys;
+	TArray<float> Times;
+	TArray<float> PlayRates;
+	TArray<float> Lengths;
+	TArray<int32> KeyFrames;
+	TBitArray<> Looping;
+
+	TMap<TObjectKey<UPaperFlipbookComponent>, int32> IndexOf;
+
+	/** Frames and time since the last advance, see EITPGovernorKnob::AnimationClockRate */
+	int32 FramesSinceAdvance = 0;
+	float SkippedSeconds = 0.f;
+};
@@ -0,0 +1,270 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPAnimationLODSubsystem.h"
+#include "ITP.h"
+#include "ITPFrameGovernorSubsystem.h"
+#include "ITPIdleSubsystem.h"
+#include "ITPCharacter.h"
+#include "ITPMath2D.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/App.h"
+#include "Rendering/SkeletalMeshRenderData.h"
+
+DECLARE_CYCLE_STAT(TEXT("Animation LOD"), STAT_ITPAnimationLOD, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bone Evaluations"), STAT_ITPBoneEvaluations, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Anim LOD Full"), STAT_ITPAnimLODFull, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Anim LOD Reduced"), STAT_ITPAnimLODReduced, STATGROUP_ITP);
+
+static float GITPAnimLODFullScreenSize = 0.2f;
+static FAutoConsoleVariableRef CVarITPAnimLODFullScreenSize(
+	TEXT("ITP.AnimLOD.FullScreenSize"),
+	GITPAnimLODFullScreenSize,
+	TEXT("Screen size (bounds radius over view half-width) at or above which NPC animation runs every frame."));
+
+static float GITPAnimLODHalfScreenSize = 0.08f;
+static FAutoConsoleVariableRef CVarITPAnimLODHalfScreenSize(
+	TEXT("ITP.AnimLOD.HalfScreenSize"),
+	GITPAnimLODHalfScreenSize,
+	TEXT("Screen size at or above which NPC animation runs every other frame."));
+
+static float GITPAnimLODQuarterScreenSize = 0.02f;
+static FAutoConsoleVariableRef CVarITPAnimLODQuarterScreenSize(
+	TEXT("ITP.AnimLOD.QuarterScreenSize"),
+	GITPAnimLODQuarterScreenSize,
+	TEXT("Screen size at or above which NPC animation runs every fourth frame. Smaller characters get the minimal tier."));
+
+static float GITPAnimLODBehindDistance = 1500.f;
+static FAutoConsoleVariableRef CVarITPAnimLODBehindDistance(
+	TEXT("ITP.AnimLOD.BehindDistance"),
+	GITPAnimLODBehindDistance,
+	TEXT("NPCs further than this behind the player along the scroll axis drop one animation tier."));
+
+static int32 GITPAnimLODGlideBoostFrames = 4;
+static FAutoConsoleVariableRef CVarITPAnimLODGlideBoostFrames(
+	TEXT("ITP.AnimLOD.GlideBoostFrames"),
+	GITPAnimLODGlideBoostFrames,
+	TEXT("Frames an NPC animates at full rate after starting or stopping a glide."));
+
+namespace ITPAnimationLOD
+{
+	/** Frames skipped between evaluations, per tier */
+	constexpr int32 FrameSkip[] = { 0, 1, 3, 7 };
+}
+
+void UITPAnimationLODSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ITPAnimationLOD);
+	FITPGovernorScope GovernorScope(GetWorld(), EITPGovernedSystem::AnimationLOD);
+
+	// A rendering world tiers by what its local players see; a server without a screen by where all players look
+	const bool bCanRender = CanRender();
+	TArray<FViewPoint, TInlineAllocator<4>> ViewPoints;
+	double PlayerScroll = TNumericLimits<double>::Max();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (!PlayerController || (bCanRender && !PlayerController->IsLocalController()))
+		{
+			continue;
+		}
+
+		FViewPoint& ViewPoint = ViewPoints.AddDefaulted_GetRef();
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewPoint.Location, ViewRotation);
+		if (const APlayerCameraManager* Camera = PlayerController->PlayerCameraManager)
+		{
+			ViewPoint.TanHalfFOV = FMath::Tan(FMath::DegreesToRadians(Camera->GetFOVAngle() * 0.5f));
+		}
+		if (const APawn* Pawn = PlayerController->GetPawn())
+		{
+			// Behind means behind every player, so compare against the rearmost one
+			PlayerScroll = FMath::Min(PlayerScroll, Pawn->GetActorLocation() | ITP2D::ScrollAxis);
+		}
+	}
+	if (ViewPoints.Num() == 0)
+	{
+		ViewPoints.AddDefaulted();
+	}
+	if (PlayerScroll == TNumericLimits<double>::Max())
+	{
+		PlayerScroll = TNumericLimits<double>::Lowest();
+	}
+
+	BoneEvaluations = 0;
+	int32 NumFull = 0;
+	for (int32 Index = Entries.Num() - 1; Index >= 0; --Index)
+	{
+		FEntry& Entry = Entries[Index];
+		AITPCharacter* Character = Entry.Character.Get();
+		USkeletalMeshComponent* Mesh = Character ? Character->GetMesh() : nullptr;
+		if (!Mesh)
+		{
+			Entries.RemoveAtSwap(Index, 1, false);
+			continue;
+		}
+
+		// The glide blend reads the glide flag on its next update; make sure that update isn't skipped
+		const bool bGliding = Character->IsGliding();
+		if (bGliding != Entry.bWasGliding)
+		{
+			Entry.bWasGliding = bGliding;
+			Entry.BoostFrames = GITPAnimLODGlideBoostFrames;
+		}
+
+		EITPAnimationLOD LOD = ComputeLOD(*Mesh, ViewPoints, PlayerScroll, bCanRender);
+		if (Entry.BoostFrames > 0)
+		{
+			--Entry.BoostFrames;
+			LOD = EITPAnimationLOD::Full;
+		}
+
+		if (LOD != Entry.LOD || !Mesh->AnimUpdateRateParams)
+		{
+			Entry.LOD = LOD;
+			ApplyLOD(*Mesh, LOD, bCanRender);
+		}
+		NumFull += LOD == EITPAnimationLOD::Full;
+
+		const FAnimUpdateRateParameters* Params = Mesh->AnimUpdateRateParams;
+		const FSkeletalMeshRenderData* RenderData = Mesh->GetSkeletalMeshRenderData();
+		const bool bEvaluates = (!Params || !Params->ShouldSkipEvaluation())
+			&& (Mesh->VisibilityBasedAnimTickOption != EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered || Mesh->WasRecentlyRendered());
+		if (bEvaluates && RenderData && RenderData->LODRenderData.IsValidIndex(Mesh->GetPredictedLODLevel()))
+		{
+			BoneEvaluations += RenderData->LODRenderData[Mesh->GetPredictedLODLevel()].RequiredBones.Num();
+		}
+	}
+
+	SET_DWORD_STAT(STAT_ITPBoneEvaluations, BoneEvaluations);
+	SET_DWORD_STAT(STAT_ITPAnimLODFull, NumFull);
+	SET_DWORD_STAT(STAT_ITPAnimLODReduced, Entries.Num() - NumFull);
+}
+
+TStatId UITPAnimationLODSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UITPAnimationLODSubsystem, STATGROUP_ITP);
+}
+
+bool UITPAnimationLODSubsystem::IsTickable() const
+{
+	return Super::IsTickable() && !UITPIdleSubsystem::IsSuspended(GetWorld());
+}
+
+bool UITPAnimationLODSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UITPAnimationLODSubsystem::Register(AITPCharacter* Character)
+{
+	USkeletalMeshComponent* Mesh = Character ? Character->GetMesh() : nullptr;
+	if (!Mesh || Entries.ContainsByPredicate([Character](const FEntry& Entry) { return Entry.Character == Character; }))
+	{
+		return;
+	}
+
+	Mesh->bEnableUpdateRateOptimizations = true;
+	Mesh->OnAnimUpdateRateParamsCreated.BindStatic(&UITPAnimationLODSubsystem::ConfigureUpdateRateParams);
+	if (Mesh->AnimUpdateRateParams)
+	{
+		ConfigureUpdateRateParams(Mesh->AnimUpdateRateParams);
+	}
+
+	FEntry& Entry = Entries.AddDefaulted_GetRef();
+	Entry.Character = Character;
+	Entry.bWasGliding = Character->IsGliding();
+	ApplyLOD(*Mesh, Entry.LOD, CanRender());
+}
+
+void UITPAnimationLODSubsystem::Unregister(AITPCharacter* Character)
+{
+	Entries.RemoveAllSwap([Character](const FEntry& Entry) { return Entry.Character == Character; });
+}
+
+bool UITPAnimationLODSubsystem::CanRender() const
+{
+	return FApp::CanEverRender() && GetWorld()->GetNetMode() != NM_DedicatedServer;
+}
+
+EITPAnimationLOD UITPAnimationLODSubsystem::ComputeLOD(const USkeletalMeshComponent& Mesh, TConstArrayView<FViewPoint> ViewPoints, double PlayerScroll, bool bCanRender) const
+{
+	// The largest the character appears to any view point
+	const FBoxSphereBounds& Bounds = Mesh.Bounds;
+	float ScreenSize = 0.f;
+	for (const FViewPoint& ViewPoint : ViewPoints)
+	{
+		const double Distance = FMath::Max(FVector::Dist(Bounds.Origin, ViewPoint.Location), 1.0);
+		ScreenSize = FMath::Max(ScreenSize, (float)(Bounds.SphereRadius / (Distance * ViewPoint.TanHalfFOV)));
+	}
+
+	int32 Tier = ScreenSize >= GITPAnimLODFullScreenSize ? 0
+		: ScreenSize >= GITPAnimLODHalfScreenSize ? 1
+		: ScreenSize >= GITPAnimLODQuarterScreenSize ? 2
+		: 3;
+
+	// Significance: characters the player has scrolled past are unlikely to be looked at again
+	if ((Bounds.Origin | ITP2D::ScrollAxis) < PlayerScroll - GITPAnimLODBehindDistance)
+	{
+		++Tier;
+	}
+	// The frame governor trades NPC animation quality for frame time
+	Tier += UITPFrameGovernorSubsystem::GetKnobLevel(GetWorld(), EITPGovernorKnob::Significance);
+
+	// Never true without a renderer, which would leave every character on the minimal tier
+	if (bCanRender && !Mesh.WasRecentlyRendered())
+	{
+		Tier = 3;
+	}
+
+	return (EITPAnimationLOD)FMath::Min(Tier, 3);
+}
+
+void UITPAnimationLODSubsystem::ApplyLOD(USkeletalMeshComponent& Mesh, EITPAnimationLOD LOD, bool bCanRender) const
+{
+	const int32 Tier = (int32)LOD;
+
+	// Frame skip follows the tier, not the render LOD, so meshes without extra LODs are throttled too
+	if (FAnimUpdateRateParameters* Params = Mesh.AnimUpdateRateParams)
+	{
+		Params->LODToFrameSkipMap.Reset();
+		for (int32 MeshLOD = 0; MeshLOD < FMath::Max(Mesh.GetNumLODs(), 1); ++MeshLOD)
+		{
+			Params->LODToFrameSkipMap.Add(MeshLOD, ITPAnimationLOD::FrameSkip[Tier]);
+		}
+	}
+
+	// Bone LOD: automatic at full rate, one mesh LOD per tier below that (SetForcedLOD is 1-based, 0 = automatic)
+	const int32 BoneLOD = LOD == EITPAnimationLOD::Full ? 0 : FMath::Min(Tier, Mesh.GetNumLODs() - 1) + 1;
+	if (Mesh.GetForcedLOD() != BoneLOD)
+	{
+		Mesh.SetForcedLOD(BoneLOD);
+	}
+
+	// Without a renderer nothing counts as rendered, so the pose keeps ticking and the frame skip alone throttles it
+	Mesh.VisibilityBasedAnimTickOption = LOD == EITPAnimationLOD::Minimal && bCanRender
+		? EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered
+		: EVisibilityBasedAnimTickOption::AlwaysTickPose;
+}
+
+void UITPAnimationLODSubsystem::ConfigureUpdateRateParams(FAnimUpdateRateParameters* Params)
+{
+	// Tiers are applied through the LOD map; interpolation keeps skipped frames (and the glide blend) smooth
+	Params->bShouldUseLODMap = true;
+	Params->bInterpolateSkippedFrames = true;
+	Params->MaxEvalRateForInterpolation = ITPAnimationLOD::FrameSkip[(int32)EITPAnimationLOD::Quarter] + 1;
+}
+
+/** Prints the bone evaluation count without needing a stats viewer, e.g. on a -nullrhi server */
+static FAutoConsoleCommandWithWorld CmdITPAnimLODReport(
+	TEXT("ITP.AnimLOD.Report"),
+	TEXT("Logs how many bones the registered NPC characters evaluated last frame."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UITPAnimationLODSubsystem* AnimationLOD = World ? World->GetSubsystem<UITPAnimationLODSubsystem>() : nullptr)
+		{
+			UE_LOG(LogITP, Log, TEXT("Bone evaluations last frame: %d"), AnimationLOD->GetBoneEvaluations());
+		}
+	}));
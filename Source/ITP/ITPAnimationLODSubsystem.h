@@ -0,0 +1,76 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ITPAnimationLODSubsystem.generated.h"
+
+class AITPCharacter;
+class USkeletalMeshComponent;
+struct FAnimUpdateRateParameters;
+
+/** Animation cost tiers, cheapest last */
+UENUM()
+enum class EITPAnimationLOD : uint8
+{
+	Full,
+	Half,
+	Quarter,
+	Minimal,
+};
+
+/**
+ * Animation LOD policy for background characters.
+ * Each frame, every registered character gets a tier from its screen size and significance (NPCs the player has
+ * already scrolled past matter less). The tier drives the update-rate optimization frame skip, bone LOD and
+ * whether the pose ticks at all off screen. Skipped frames are interpolated, and a glide start or stop forces a
+ * few full-rate frames so the blend into or out of the glide pose begins on time.
+ * Worlds that never render (dedicated servers, -nullrhi) have no screen: there the tier comes from the distance to
+ * the nearest player's view point and off-screen characters keep ticking their pose.
+ */
+UCLASS()
+class ITP_API UITPAnimationLODSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	void Register(AITPCharacter* Character);
+	void Unregister(AITPCharacter* Character);
+
+	/** Bones scheduled for evaluation this frame across all registered characters */
+	int32 GetBoneEvaluations() const { return BoneEvaluations; }
+
+private:
+	struct FEntry
+	{
+		TWeakObjectPtr<AITPCharacter> Character;
+		EITPAnimationLOD LOD = EITPAnimationLOD::Full;
+		bool bWasGliding = false;
+
+		/** Frames left at full rate after a glide state change */
+		int32 BoostFrames = 0;
+	};
+
+	struct FViewPoint
+	{
+		FVector Location = FVector::ZeroVector;
+		float TanHalfFOV = 1.f;
+	};
+
+	/** Whether this world draws anything, so WasRecentlyRendered means something */
+	bool CanRender() const;
+
+	EITPAnimationLOD ComputeLOD(const USkeletalMeshComponent& Mesh, TConstArrayView<FViewPoint> ViewPoints, double PlayerScroll, bool bCanRender) const;
+	void ApplyLOD(USkeletalMeshComponent& Mesh, EITPAnimationLOD LOD, bool bCanRender) const;
+
+	static void ConfigureUpdateRateParams(FAnimUpdateRateParameters* Params);
+
+	TArray<FEntry> Entries;
+	int32 BoneEvaluations = 0;
+};
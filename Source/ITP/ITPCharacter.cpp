@@ -1,19 +1,44 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "ITPCharacter.h"
+#include "ITP.h"
+#include "ITPChecksumSubsystem.h"
+#include "ITPEffectsSubsystem.h"
+#include "ITPFrameGovernorSubsystem.h"
+#include "ITPCollision.h"
+#include "ITPLagCompensationSubsystem.h"
+#include "ITPLevelStateSubsystem.h"
+#include "ITPMath2D.h"
+#include "ITPOriginSubsystem.h"
+#include "ITPTileMapActor.h"
 #include "Engine/LocalPlayer.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "GameFramework/Controller.h"
+#include "GameFramework/GameStateBase.h"
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
 #include "InputActionValue.h"
-#include "Kismet/KismetMathLibrary.h"
+#include "Engine/DamageEvents.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "Net/UnrealNetwork.h"
+#include "PhysicsEngine/PhysicsSettings.h"
 
 DEFINE_LOG_CATEGORY(LogTemplateCharacter);
 
+DECLARE_CYCLE_STAT(TEXT("Character Tick"), STAT_ITPCharacterTick, STATGROUP_ITP);
+
+static int32 GITPAsyncPhysicsMovement = 0;
+static FAutoConsoleVariableRef CVarITPAsyncPhysicsMovement(
+	TEXT("ITP.Movement.AsyncPhysics"),
+	GITPAsyncPhysicsMovement,
+	TEXT("1 = step ITP character kinematics (glide) on the Chaos async physics tick; the game thread only reads interpolated results.\n")
+	TEXT("Requires Tick Physics Async in the project physics settings. Combine with p.AsyncCharacterMovement=1 to move the CMC itself.\n")
+	TEXT("0 = step on the game thread at ITP.Movement.FixedStepHz (default)."),
+	ECVF_ReadOnly);
+
 //////////////////////////////////////////////////////////////////////////
 // AITPCharacter
 
@@ -40,6 +65,9 @@ AITPCharacter::AITPCharacter()
 	GetCharacterMovement()->BrakingDecelerationWalking = 2000.f;
 	GetCharacterMovement()->BrakingDecelerationFalling = 1500.0f;
 
+	// Proxy interpolation keys snapshots by the server time they were taken, so every update carries its stamp
+	GetCharacterMovement()->bNetworkAlwaysReplicateTransformUpdateTimestamp = true;
+
 	// Create a camera boom (pulls in towards the player if there is a collision)
 	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
 	CameraBoom->SetupAttachment(RootComponent);
@@ -53,6 +81,10 @@ AITPCharacter::AITPCharacter()
 
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named ThirdPersonCharacter (to avoid direct content references in C++)
+
+	// Glide kinematics can run on the async physics thread at the physics fixed rate
+	bUseAsyncPhysicsMovement = GITPAsyncPhysicsMovement != 0 && UPhysicsSettings::Get()->bTickPhysicsAsync;
+	bAsyncPhysicsTickEnabled = bUseAsyncPhysicsMovement;
 }
 
 void AITPCharacter::BeginPlay()
@@ -68,13 +100,74 @@ void AITPCharacter::BeginPlay()
 			Subsystem->AddMappingContext(DefaultMappingContext, 0);
 		}
 	}
+
+	if (UITPChecksumSubsystem* Checksums = GetWorld()->GetSubsystem<UITPChecksumSubsystem>())
+	{
+		Checksums->AddCharacter(this);
+	}
+
+	UpdateProxyMovementMode();
+
+	if (HasAuthority() && GetNetMode() != NM_Standalone)
+	{
+		if (UITPLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UITPLagCompensationSubsystem>())
+		{
+			const UCapsuleComponent* Capsule = GetCapsuleComponent();
+			LagCompensation->Register(this, FVector2f(Capsule->GetScaledCapsuleRadius(), Capsule->GetScaledCapsuleHalfHeight()));
+		}
+	}
+}
+
+void AITPCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UITPChecksumSubsystem* Checksums = GetWorld()->GetSubsystem<UITPChecksumSubsystem>())
+	{
+		Checksums->RemoveCharacter(this);
+	}
+
+	if (UITPLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UITPLagCompensationSubsystem>())
+	{
+		LagCompensation->Unregister(this);
+	}
+
+	// The trail is a manually released pool component; ending play mid-glide would otherwise strand it
+	if (UITPEffectsSubsystem* Effects = GetWorld()->GetSubsystem<UITPEffectsSubsystem>())
+	{
+		Effects->StopLooping(EITPEffect::GlideTrail, GetRootComponent());
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void AITPCharacter::Tick(float deltaSeconds)
 {
+	SCOPE_CYCLE_COUNTER(STAT_ITPCharacterTick);
+	FITPGovernorScope GovernorScope(GetWorld(), EITPGovernedSystem::Characters);
+
 	delta = deltaSeconds;
 
+	if (bUseAsyncPhysicsMovement)
+	{
+		GlideSimulation.AdvanceAsyncReadback(delta, UPhysicsSettings::Get()->AsyncFixedTimeStepSize);
+	}
+	else
+	{
+		GlideSimulation.AdvanceGameThread(delta, ITPKinematics::GetFixedDeltaSeconds());
+	}
+
 	DescendPlayer();
+
+	if (UsesProxyInterpolation())
+	{
+		PresentProxySnapshot();
+	}
+}
+
+void AITPCharacter::AsyncPhysicsTickActor(float DeltaTime, float SimTime)
+{
+	Super::AsyncPhysicsTickActor(DeltaTime, SimTime);
+
+	GlideSimulation.AsyncStep(DeltaTime);
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -115,19 +208,25 @@ void AITPCharacter::Move(const FInputActionValue& Value)
 		const FRotator YawRotation(0, Rotation.Yaw, 0);
 
 	
-		// get right vector 
-		const FVector RightDirection = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::Y);
+		// get right vector, flattened into the gameplay plane; with the camera looking along the scroll axis nothing is
+		// left of it, so keep the last direction instead of stopping
+		const FVector2f RightDirection = ITP2D::FromWorldDirection(FRotationMatrix(YawRotation).GetUnitAxis(EAxis::Y));
+		if (!RightDirection.IsNearlyZero(1.e-3f))
+		{
+			MoveRightDirection = RightDirection.GetSafeNormal();
+		}
 
 		// add movement 
-		AddMovementInput(RightDirection, MovementVector.X);
+		AddMovementInput(ITP2D::ToWorldDirection(MoveRightDirection), MovementVector.X);
 	}
 }
 
 void AITPCharacter::StartGliding()
 {
 	if (!bIsGliding && CanStartGliding()) {
-		CurrentVelocity = GetCharacterMovement()->Velocity;
+		CurrentVelocity = ITP2D::FromWorldDirection(GetCharacterMovement()->Velocity);
 		bIsGliding = true;
+		GlideSimulation.SetInput(true, CurrentVelocity.Y, descendingRate);
 
 		RecordOriginalSettings();
 
@@ -136,28 +235,338 @@ void AITPCharacter::StartGliding()
 		GetCharacterMovement()->BrakingDecelerationFalling = 350.f;
 		GetCharacterMovement()->MaxAcceleration = 1024;
 		GetCharacterMovement()->MaxWalkSpeed = 600;
+
+		if (UITPEffectsSubsystem* Effects = GetWorld()->GetSubsystem<UITPEffectsSubsystem>())
+		{
+			Effects->StartLooping(EITPEffect::GlideTrail, GetRootComponent());
+		}
+
+		SetReplicatedGlide(true);
 	}
 }
 
 
 void AITPCharacter::StopGliding()
 {
+	const bool bWasGliding = bIsGliding;
+	if (bWasGliding)
+	{
+		if (UITPEffectsSubsystem* Effects = GetWorld()->GetSubsystem<UITPEffectsSubsystem>())
+		{
+			Effects->StopLooping(EITPEffect::GlideTrail, GetRootComponent());
+		}
+	}
+
 	ApplyOriginalSettings();
 	bIsGliding = false;
+	GlideSimulation.SetInput(false, CurrentVelocity.Y, descendingRate);
+
+	if (bWasGliding)
+	{
+		SetReplicatedGlide(false);
+	}
+}
+
+void AITPCharacter::SetReplicatedGlide(bool bGliding)
+{
+	if (!HasAuthority())
+	{
+		if (IsLocallyControlled())
+		{
+			ServerSetGliding(bGliding);
+		}
+		return;
+	}
+
+	if (ReplicatedGlide.bGliding == bGliding)
+	{
+		return;
+	}
+
+	ReplicatedGlide.bGliding = bGliding;
+	ReplicatedGlide.StartVelocityY = CurrentVelocity.Y;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AITPCharacter, ReplicatedGlide, this);
+}
+
+void AITPCharacter::ServerSetGliding_Implementation(bool bGliding)
+{
+	if (bGliding)
+	{
+		StartGliding();
+	}
+	else
+	{
+		StopGliding();
+	}
+}
+
+void AITPCharacter::OnRep_ReplicatedGlide()
+{
+	if (ReplicatedGlide.bGliding == bIsGliding)
+	{
+		return;
+	}
+
+	// Movement itself arrives through the CMC; only the glide state that drives animation and effects is mirrored
+	bIsGliding = ReplicatedGlide.bGliding;
+	CurrentVelocity.Y = ReplicatedGlide.StartVelocityY;
+	GlideSimulation.SetInput(bIsGliding, CurrentVelocity.Y, descendingRate);
+
+	if (UITPEffectsSubsystem* Effects = GetWorld()->GetSubsystem<UITPEffectsSubsystem>())
+	{
+		if (bIsGliding)
+		{
+			Effects->StartLooping(EITPEffect::GlideTrail, GetRootComponent());
+		}
+		else
+		{
+			Effects->StopLooping(EITPEffect::GlideTrail, GetRootComponent());
+		}
+	}
+}
+
+bool AITPCharacter::UsesProxyInterpolation() const
+{
+	return ProxyInterpolation.bEnabled && GetLocalRole() == ROLE_SimulatedProxy;
+}
+
+void AITPCharacter::UpdateProxyMovementMode()
+{
+	// The snapshot buffer places proxies itself; CMC simulation and smoothing would fight it
+	const bool bInterpolate = UsesProxyInterpolation();
+	GetCharacterMovement()->SetComponentTickEnabled(!bInterpolate);
+	if (bInterpolate)
+	{
+		GetCharacterMovement()->NetworkSmoothingMode = ENetworkSmoothingMode::Disabled;
+	}
+	else
+	{
+		ProxySnapshots.Reset();
+	}
+}
+
+void AITPCharacter::PostNetReceiveRole()
+{
+	Super::PostNetReceiveRole();
+
+	UpdateProxyMovementMode();
+}
+
+void AITPCharacter::PostNetReceiveLocationAndRotation()
+{
+	if (!UsesProxyInterpolation())
+	{
+		Super::PostNetReceiveLocationAndRotation();
+		return;
+	}
+
+	const FRepMovement& Movement = GetReplicatedMovement();
+	SetActorRotation(Movement.Rotation);
+
+	FITPSnapshot Snapshot;
+	Snapshot.ServerTime = GetReplicatedServerLastTransformUpdateTimeStamp();
+	if (Snapshot.ServerTime <= ProxySnapshots.GetNewestTime())
+	{
+		// No new stamp came with this update (e.g. a Blueprint cleared the flag); fall back to the estimated server clock
+		const AGameStateBase* GameState = GetWorld()->GetGameState();
+		Snapshot.ServerTime = GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+	}
+	Snapshot.Location = Movement.Location;
+	Snapshot.Velocity = Movement.LinearVelocity;
+	Snapshot.bGliding = ReplicatedGlide.bGliding;
+
+	ProxySnapshots.Add(Snapshot, GetWorld()->GetTimeSeconds(), ProxyInterpolation);
+}
+
+void AITPCharacter::PresentProxySnapshot()
+{
+	FITPSnapshot Presented;
+	if (ProxySnapshots.Sample(GetWorld()->GetTimeSeconds(), descendingRate, ProxyInterpolation, Presented))
+	{
+		SetActorLocation(Presented.Location);
+		GetCharacterMovement()->Velocity = Presented.Velocity;
+	}
+}
+
+void AITPCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// The owner predicts its own glide
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	Params.Condition = COND_SkipOwner;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AITPCharacter, ReplicatedGlide, Params);
+
+	// Checked against ReplicatedMovement, which only simulated proxies receive
+	Params.Condition = COND_SimulatedOnly;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AITPCharacter, ReplicatedChecksum, Params);
+}
+
+void AITPCharacter::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	// Super has just gathered ReplicatedMovement, so the sample goes out in the same update as the state it covers
+	const UITPChecksumSubsystem* Checksums = GetWorld()->GetSubsystem<UITPChecksumSubsystem>();
+	if (Checksums && Checksums->GetNumSteps() >= ReplicatedChecksum.Step + Checksums->GetChecksumStride())
+	{
+		FITPGovernorScope GovernorScope(GetWorld(), EITPGovernedSystem::Checksums);
+		ReplicatedChecksum.Step = Checksums->GetNumSteps();
+		ReplicatedChecksum.Checksum = GetReplicatedStateChecksum();
+		MARK_PROPERTY_DIRTY_FROM_NAME(AITPCharacter, ReplicatedChecksum, this);
+	}
+}
+
+void AITPCharacter::PostNetReceive()
+{
+	Super::PostNetReceive();
+
+	// Only a new sample is checked; between samples the movement moves on while the sample stays behind
+	if (GetLocalRole() != ROLE_SimulatedProxy || ReplicatedChecksum.Step == LastVerifiedChecksumStep)
+	{
+		return;
+	}
+	LastVerifiedChecksumStep = ReplicatedChecksum.Step;
+
+	if (UITPChecksumSubsystem* Checksums = GetWorld()->GetSubsystem<UITPChecksumSubsystem>())
+	{
+		Checksums->VerifyRemoteSample(this, ReplicatedChecksum, GetReplicatedStateChecksum());
+	}
+}
+
+uint32 AITPCharacter::GetReplicatedStateChecksum() const
+{
+	return UITPChecksumSubsystem::HashReplicatedState(GetReplicatedMovement(), ReplicatedGlide.bGliding, ReplicatedGlide.StartVelocityY);
+}
+
+void AITPCharacter::Landed(const FHitResult& Hit)
+{
+	Super::Landed(Hit);
+
+	StompedThisFall.Reset();
+	ServerStompedThisFall.Reset();
+
+	if (UITPEffectsSubsystem* Effects = GetWorld()->GetSubsystem<UITPEffectsSubsystem>())
+	{
+		Effects->Spawn(EITPEffect::LandingDust, Hit.ImpactPoint, Hit.ImpactNormal.Rotation());
+	}
+}
+
+void AITPCharacter::NotifyActorBeginOverlap(AActor* OtherActor)
+{
+	Super::NotifyActorBeginOverlap(OtherActor);
+
+	if (ITPCollision::IsHazard(OtherActor))
+	{
+		ReportHazard(OtherActor);
+	}
+}
+
+void AITPCharacter::NotifyHit(UPrimitiveComponent* MyComp, AActor* Other, UPrimitiveComponent* OtherComp, bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit)
+{
+	Super::NotifyHit(MyComp, Other, OtherComp, bSelfMoved, HitLocation, HitNormal, NormalImpulse, Hit);
+
+	// Falling onto the top of another character; the CMC never lands on pawns, so this comes in as a hit
+	if (bSelfMoved && Cast<AITPCharacter>(Other) && GetCharacterMovement()->IsFalling() && (HitNormal | ITP2D::UpAxis) > 0.7)
+	{
+		ReportStomp(Other);
+	}
+
+	// Jumping into a tile from below knocks it out if it is breakable; the server owns level state
+	AITPTileMapActor* TileMap = Cast<AITPTileMapActor>(Other);
+	if (bSelfMoved && TileMap && HasAuthority() && (HitNormal | ITP2D::UpAxis) < -0.7)
+	{
+		if (UITPLevelStateSubsystem* LevelState = GetWorld()->GetSubsystem<UITPLevelStateSubsystem>())
+		{
+			LevelState->BreakTile(TileMap, TileMap->WorldToTile(Hit.ImpactPoint + ITP2D::UpAxis * (TileMap->TileSize * 0.5f)));
+		}
+	}
+}
+
+void AITPCharacter::ReportStomp(AActor* Victim)
+{
+	// Only the controlling machine reports; the server ignores its own copy of a remote player's hits
+	if (!IsLocallyControlled() || StompedThisFall.Contains(Victim))
+	{
+		return;
+	}
+	StompedThisFall.Add(Victim);
+
+	if (HasAuthority())
+	{
+		ServerReportStomp_Implementation(Victim, GetWorld()->GetTimeSeconds());
+	}
+	else
+	{
+		// An interpolated victim was drawn at its playout time, which already includes the interpolation delay
+		const AITPCharacter* VictimCharacter = Cast<AITPCharacter>(Victim);
+		const double ViewTime = VictimCharacter && VictimCharacter->UsesProxyInterpolation()
+			? VictimCharacter->GetProxySnapshots().GetPlayoutTime()
+			: UITPLagCompensationSubsystem::GetClientViewTime(this);
+		ServerReportStomp(Victim, ViewTime);
+	}
+}
+
+void AITPCharacter::ReportHazard(AActor* Hazard)
+{
+	if (!IsLocallyControlled())
+	{
+		return;
+	}
+
+	if (HasAuthority())
+	{
+		ServerReportHazard_Implementation(Hazard, GetWorld()->GetTimeSeconds());
+	}
+	else
+	{
+		ServerReportHazard(Hazard, UITPLagCompensationSubsystem::GetClientViewTime(this));
+	}
+}
+
+void AITPCharacter::ServerReportStomp_Implementation(AActor* Victim, double ViewTime)
+{
+	const UITPLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UITPLagCompensationSubsystem>();
+	if (!Victim || ServerStompedThisFall.Contains(Victim))
+	{
+		return;
+	}
+
+	if (LagCompensation && LagCompensation->ValidateStomp(this, Victim, ViewTime))
+	{
+		ServerStompedThisFall.Add(Victim);
+		Victim->TakeDamage(1.f, FDamageEvent(), GetController(), this);
+	}
+}
+
+void AITPCharacter::ServerReportHazard_Implementation(AActor* Hazard, double ViewTime)
+{
+	const UITPLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UITPLagCompensationSubsystem>();
+	if (Hazard && LagCompensation && LagCompensation->ValidateHazard(this, Hazard, ViewTime))
+	{
+		TakeDamage(1.f, FDamageEvent(), nullptr, Hazard);
+	}
 }
 
 bool AITPCharacter::CanStartGliding()
 {
 	FHitResult Hit;
 
-	FVector TraceStart = GetActorLocation();
-	FVector TraceEnd = GetActorLocation() + GetActorUpVector() * minimumHeight * -1.f;
+	const UITPOriginSubsystem* OriginSubsystem = GetWorld()->GetSubsystem<UITPOriginSubsystem>();
+	const ITP2D::FPlaneOrigin Origin = OriginSubsystem ? OriginSubsystem->GetOrigin() : ITP2D::FPlaneOrigin();
+
+	const FVector ActorLocation = GetActorLocation();
+	const FVector2f Start2D = ITP2D::FromWorld(ActorLocation, Origin);
+	const FVector2f End2D = Start2D + ITP2D::FromWorldDirection(GetActorUpVector()) * minimumHeight * -1.f;
+
+	FVector TraceStart = ITP2D::ToWorld(Start2D, ActorLocation.X, Origin);
+	FVector TraceEnd = ITP2D::ToWorld(End2D, ActorLocation.X, Origin);
 
 	FCollisionQueryParams QueryParams;
 
 	QueryParams.AddIgnoredActor(this);
-	TEnumAsByte<ECollisionChannel> TraceProperties = ECC_Visibility;
-	GetWorld()->LineTraceSingleByChannel(Hit, TraceStart, TraceEnd, TraceProperties, QueryParams);
+	ProbeCache.LineProbe(EITPProbe::Ground, GetWorld(), Hit, TraceStart, TraceEnd, QueryParams);
 	DrawDebugLine(GetWorld(), TraceStart, TraceEnd, Hit.bBlockingHit ? FColor::Blue : FColor::Red);
 
 	if (!Hit.bBlockingHit && GetCharacterMovement()->IsFalling()) return true;
@@ -176,10 +585,18 @@ void AITPCharacter::RecordOriginalSettings()
 
 void AITPCharacter::DescendPlayer()
 {
-	if (CurrentVelocity.Z != descendingRate * -1.f && bIsGliding) 
+	if (!bIsGliding)
+	{
+		return;
+	}
+
+	// The glide itself is stepped at a fixed rate in GlideSimulation; only apply its result here
+	const FITPGlideState GlideState = GlideSimulation.GetInterpolated();
+	CurrentVelocity.Y = ITPToFloat(GlideState.VelocityY);
+
+	if (GlideState.bForceVelocityY && GetLocalRole() != ROLE_SimulatedProxy)
 	{
-		CurrentVelocity.Z = UKismetMathLibrary::FInterpEaseInOut(CurrentVelocity.Z, descendingRate, delta, 3.f);
-		GetCharacterMovement()->Velocity.Z = descendingRate * -1.f;
+		GetCharacterMovement()->Velocity.Z = ITPToFloat(GlideState.ForcedVelocityY);
 	}
 }
 
@@ -191,3 +608,19 @@ void AITPCharacter::ApplyOriginalSettings()
 	GetCharacterMovement()->MaxAcceleration = originalAcceleration;
 	GetCharacterMovement()->AirControl = originalAirControl;
 }
+
+void AITPCharacter::AppendChecksum(FITPChecksumBuilder& Builder) const
+{
+	// A proxy's transform is smoothed locally; only the received state is the same on every machine
+	if (GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		Builder.Add(GetReplicatedStateChecksum());
+		return;
+	}
+
+	Builder.Add(GetActorLocation());
+	Builder.Add(GetActorQuat());
+	Builder.Add(GetCharacterMovement()->Velocity);
+	Builder.Add(CurrentVelocity);
+	Builder.Add(bIsGliding);
+}
@@ -5,6 +5,10 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 #include "Logging/LogMacros.h"
+#include "ITPChecksumSubsystem.h"
+#include "ITPKinematics.h"
+#include "ITPProbeCache.h"
+#include "ITPSnapshotBuffer.h"
 #include "ITPCharacter.generated.h"
 
 class USpringArmComponent;
@@ -15,6 +19,20 @@ struct FInputActionValue;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTemplateCharacter, Log, All);
 
+/** Glide state sent to other clients, so simulated proxies show the glide trail and animation */
+USTRUCT()
+struct FITPReplicatedGlide
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	bool bGliding = false;
+
+	/** Vertical plane velocity when the glide started; seeds the proxy's glide simulation */
+	UPROPERTY()
+	float StartVelocityY = 0.f;
+};
+
 UCLASS(config=Game)
 class AITPCharacter : public ACharacter
 {
@@ -51,7 +69,11 @@ class AITPCharacter : public ACharacter
 	/** Attributes for Gliding */
 	bool bIsGliding = false;
 
-	FVector CurrentVelocity;
+	/** Velocity in the gameplay plane (X = scroll axis, Y = up), see ITPMath2D.h */
+	FVector2f CurrentVelocity;
+
+	/** Last usable right direction in the plane, see Move */
+	FVector2f MoveRightDirection = FVector2f(1.f, 0.f);
 
 	float originalGravityScale;
 	float originalWalkingSpeed;
@@ -62,12 +84,69 @@ class AITPCharacter : public ACharacter
 	float minimumHeight = 50;
 	float delta;
 
+	/** Cached ground/wall/ceiling probe results, reused while the capsule barely moves */
+	FITPProbeCache ProbeCache;
+
+	/** Fixed-rate glide kinematics, stepped on the game thread or the Chaos async physics thread */
+	FITPFixedStepSimulation GlideSimulation;
+
+	/** Whether this character was created with ITP.Movement.AsyncPhysics enabled */
+	bool bUseAsyncPhysicsMovement = false;
+
+	/** Received movement of this character when it is a simulated proxy */
+	FITPSnapshotBuffer ProxySnapshots;
+
+	bool UsesProxyInterpolation() const;
+	void UpdateProxyMovementMode();
+	void PresentProxySnapshot();
+
+	/** Push-model: only marked dirty when a glide starts or stops, never compared per frame */
+	UPROPERTY(ReplicatedUsing = OnRep_ReplicatedGlide)
+	FITPReplicatedGlide ReplicatedGlide;
+
+	UFUNCTION()
+	void OnRep_ReplicatedGlide();
+
+	/** Server: checksum of ReplicatedMovement and ReplicatedGlide as they are sent, see UITPChecksumSubsystem */
+	UPROPERTY(Replicated)
+	FITPChecksumSample ReplicatedChecksum;
+
+	/** Client: server step of the last sample checked */
+	uint32 LastVerifiedChecksumStep = 0;
+
+	uint32 GetReplicatedStateChecksum() const;
+
+	/** The owning client glides locally and tells the server, which replicates it to everyone else */
+	UFUNCTION(Server, Reliable)
+	void ServerSetGliding(bool bGliding);
+
+	void SetReplicatedGlide(bool bGliding);
+
+	/** Stomps and hazard hits are judged by the server against where the client saw the other actor */
+	UFUNCTION(Server, Reliable)
+	void ServerReportStomp(AActor* Victim, double ViewTime);
+
+	UFUNCTION(Server, Reliable)
+	void ServerReportHazard(AActor* Hazard, double ViewTime);
+
+	void ReportStomp(AActor* Victim);
+	void ReportHazard(AActor* Hazard);
+
+	/** Victims already stomped since the last landing; NotifyHit fires on every frame of contact. Cleared in Landed */
+	TArray<TWeakObjectPtr<AActor>, TInlineAllocator<2>> StompedThisFall;
+
+	/** Server: the same per fall, so a resent or duplicated report never damages twice */
+	TArray<TWeakObjectPtr<AActor>, TInlineAllocator<2>> ServerStompedThisFall;
+
 
 public:
 	AITPCharacter();
 	
 
 protected:
+	/** How simulated proxies of this class are interpolated; subclasses and Blueprints tune it per character type */
+	UPROPERTY(EditDefaultsOnly, Category = Network)
+	FITPInterpolationSettings ProxyInterpolation;
 
 	/** Called for movement input */
 	void Move(const FInputActionValue& Value);
@@ -94,7 +173,36 @@ protected:
 
 	virtual void Tick(float deltaSeconds) override;
 
+	virtual void AsyncPhysicsTickActor(float DeltaTime, float SimTime) override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void Landed(const FHitResult& Hit) override;
+
+	virtual void NotifyActorBeginOverlap(AActor* OtherActor) override;
+
+	virtual void NotifyHit(UPrimitiveComponent* MyComp, AActor* Other, UPrimitiveComponent* OtherComp, bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit) override;
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	virtual void PostNetReceiveLocationAndRotation() override;
+
+	virtual void PostNetReceiveRole() override;
+
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+
+	virtual void PostNetReceive() override;
+
 public:
+	/** Feeds transform, velocities and glide state into the per-step simulation checksum; simulated proxies only add what they received **/
+	void AppendChecksum(FITPChecksumBuilder& Builder) const;
+	/** Whether the character is currently gliding **/
+	bool IsGliding() const { return bIsGliding; }
+	/** Returns the proxy interpolation buffer, e.g. to read its delay and jitter **/
+	const FITPSnapshotBuffer& GetProxySnapshots() const { return ProxySnapshots; }
+	/** Returns the probe cache, e.g. to read its hit rate **/
+	const FITPProbeCache& GetProbeCache() const { return ProbeCache; }
+	FITPProbeCache& GetProbeCache() { return ProbeCache; }
 	/** Returns CameraBoom subobject **/
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
 	/** Returns FollowCamera subobject **/
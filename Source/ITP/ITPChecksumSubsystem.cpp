@@ -0,0 +1,476 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPChecksumSubsystem.h"
+#include "ITPFrameGovernorSubsystem.h"
+#include "ITP.h"
+#include "ITPCharacter.h"
+#include "ITPKinematics.h"
+#include "ITPRandomSubsystem.h"
+#include "Algo/Sort.h"
+#include "Engine/GameInstance.h"
+#include "Engine/EngineTypes.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Checksum Step"), STAT_ITPChecksumStep, STATGROUP_ITP);
+
+static int32 GITPChecksumRecord = 0;
+static FAutoConsoleVariableRef CVarITPChecksumRecord(
+	TEXT("ITP.Checksum.Record"),
+	GITPChecksumRecord,
+	TEXT("1 = write per-step, per-system checksums to Saved/ITP/Checksums for ITP.Checksum.Bisect. Read when a world starts."),
+	ECVF_Default);
+
+namespace ITPChecksum
+{
+	static const FName CharactersSystem(TEXT("Characters"));
+	static const FName RandomSystem(TEXT("RNG"));
+
+	constexpr uint32 FileMagic = 0x43505449; // "ITPC"
+	constexpr uint32 FileVersion = 1;
+
+	enum ERecordTag : uint8
+	{
+		SystemName = 0,
+		Step = 1,
+	};
+
+	struct FStepRecord
+	{
+		uint32 Step = 0;
+		uint32 Combined = 0;
+		TArray<uint32> Systems;
+	};
+
+	static bool LoadRecording(const FString& Filename, TArray<FString>& OutSystemNames, TArray<FStepRecord>& OutSteps)
+	{
+		TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename));
+		if (!Reader)
+		{
+			UE_LOG(LogITP, Error, TEXT("Could not open checksum recording '%s'"), *Filename);
+			return false;
+		}
+
+		uint32 Magic = 0;
+		uint32 Version = 0;
+		*Reader << Magic << Version;
+		if (Magic != FileMagic || Version != FileVersion)
+		{
+			UE_LOG(LogITP, Error, TEXT("'%s' is not an ITP checksum recording"), *Filename);
+			return false;
+		}
+
+		while (!Reader->AtEnd() && !Reader->IsError())
+		{
+			uint8 Tag = 0;
+			*Reader << Tag;
+			if (Tag == SystemName)
+			{
+				FString Name;
+				*Reader << Name;
+				OutSystemNames.Add(MoveTemp(Name));
+			}
+			else if (Tag == Step)
+			{
+				FStepRecord& Record = OutSteps.AddDefaulted_GetRef();
+				*Reader << Record.Step << Record.Combined << Record.Systems;
+			}
+			else
+			{
+				UE_LOG(LogITP, Error, TEXT("Corrupt checksum recording '%s'"), *Filename);
+				return false;
+			}
+		}
+		return !Reader->IsError();
+	}
+
+	/** Rolling checksums never re-converge, so the first divergent step can be found by binary search */
+	static void Bisect(const TArray<FString>& Args)
+	{
+		if (Args.Num() < 2)
+		{
+			UE_LOG(LogITP, Display, TEXT("Usage: ITP.Checksum.Bisect <FileA> <FileB>"));
+			return;
+		}
+
+		TArray<FString> NamesA, NamesB;
+		TArray<FStepRecord> StepsA, StepsB;
+		if (!LoadRecording(Args[0], NamesA, StepsA) || !LoadRecording(Args[1], NamesB, StepsB))
+		{
+			return;
+		}
+
+		const int32 NumCommon = FMath::Min(StepsA.Num(), StepsB.Num());
+		if (NumCommon == 0 || StepsA[0].Step != StepsB[0].Step)
+		{
+			UE_LOG(LogITP, Warning, TEXT("Recordings do not start at the same step"));
+			return;
+		}
+
+		if (StepsA[NumCommon - 1].Combined == StepsB[NumCommon - 1].Combined)
+		{
+			UE_LOG(LogITP, Display, TEXT("No divergence in %d common steps"), NumCommon);
+			return;
+		}
+
+		int32 Low = 0;
+		int32 High = NumCommon - 1;
+		while (Low < High)
+		{
+			const int32 Mid = Low + (High - Low) / 2;
+			if (StepsA[Mid].Combined != StepsB[Mid].Combined)
+			{
+				High = Mid;
+			}
+			else
+			{
+				Low = Mid + 1;
+			}
+		}
+
+		const FStepRecord& A = StepsA[Low];
+		const FStepRecord& B = StepsB[Low];
+		UE_LOG(LogITP, Display, TEXT("First divergent step: %u"), A.Step);
+
+		const int32 NumSystems = FMath::Min(A.Systems.Num(), B.Systems.Num());
+		for (int32 Index = 0; Index < NumSystems; ++Index)
+		{
+			if (A.Systems[Index] != B.Systems[Index])
+			{
+				const FString& Name = NamesA.IsValidIndex(Index) ? NamesA[Index] : FString::Printf(TEXT("System%d"), Index);
+				UE_LOG(LogITP, Display, TEXT("  Divergent system: %s (%08x vs %08x)"), *Name, A.Systems[Index], B.Systems[Index]);
+			}
+		}
+		if (A.Systems.Num() != B.Systems.Num())
+		{
+			UE_LOG(LogITP, Display, TEXT("  Registered systems differ (%d vs %d)"), A.Systems.Num(), B.Systems.Num());
+		}
+	}
+
+	static FAutoConsoleCommand BisectCommand(
+		TEXT("ITP.Checksum.Bisect"),
+		TEXT("Finds the first step and system where two ITP checksum recordings diverge. Usage: ITP.Checksum.Bisect <FileA> <FileB>"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Bisect));
+
+	/** Steps per centimetre of the grid FRepMovement::NetSerialize rounds a vector to */
+	static double QuantizationScale(EVectorQuantization Level)
+	{
+		switch (Level)
+		{
+		case EVectorQuantization::RoundOneDecimal:
+			return 10.0;
+		case EVectorQuantization::RoundTwoDecimals:
+			return 100.0;
+		default:
+			return 1.0;
+		}
+	}
+
+	/**
+	 * Hashes Value as the whole grid steps NetSerialize sends it as. A value that already went over the wire lies on
+	 * the grid and rounds to the same steps, so the server's raw state and a client's received copy agree.
+	 * Integer steps also keep -0 and 0 apart from the hash.
+	 */
+	static void AddQuantized(FITPChecksumBuilder& Builder, const FVector& Value, EVectorQuantization Level)
+	{
+		const double Scale = QuantizationScale(Level);
+		Builder.Add((int64)FMath::RoundToDouble(Value.X * Scale));
+		Builder.Add((int64)FMath::RoundToDouble(Value.Y * Scale));
+		Builder.Add((int64)FMath::RoundToDouble(Value.Z * Scale));
+	}
+
+	/** What a client holds after receiving Movement: the same struct after one trip through its serializer */
+	static FRepMovement Transmit(const FRepMovement& Movement)
+	{
+		FBitWriter Writer(0, true);
+		bool bSuccess = true;
+		FRepMovement Sent = Movement;
+		Sent.NetSerialize(Writer, nullptr, bSuccess);
+
+		FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+		FRepMovement Received = Movement;
+		Received.NetSerialize(Reader, nullptr, bSuccess);
+		return Received;
+	}
+
+	/**
+	 * A server simulates one character for a few thousand steps and publishes a sample every few steps; two clients
+	 * join at different steps and check every sample against what they received. Both must verify without a
+	 * mismatch and agree on every step they share, and a one centimetre error must be caught. Clients hash what
+	 * went through the real serializer, which checks HashReplicatedState's rounding against NetSerialize.
+	 */
+	static void SelfTest()
+	{
+		constexpr uint32 NumServerSteps = 3000;
+		constexpr uint32 PublishInterval = 4;
+		const uint32 JoinSteps[2] = { 1, 1337 };
+
+		TMap<uint32, uint32> ClientHashes[2];
+		uint32 NumVerified[2] = { 0, 0 };
+		uint32 NumMismatches[2] = { 0, 0 };
+		bool bCaughtError = false;
+
+		FRepMovement Movement;
+		for (uint32 Step = 1; Step <= NumServerSteps; ++Step)
+		{
+			// Fractional values on purpose, so quantization has to agree on both sides
+			const double Time = Step / 60.0;
+			Movement.Location = FVector(0.0, 137.31 * Time + 1.0e6, 200.0 + 150.0 * FMath::Sin(Time * 3.0));
+			Movement.LinearVelocity = FVector(0.0, 137.31, 450.0 * FMath::Cos(Time * 3.0));
+			const bool bGliding = (Step / 300) % 2 == 1;
+			const float GlideStartVelocityY = bGliding ? -123.456f : 0.f;
+
+			if (Step % PublishInterval != 0)
+			{
+				continue;
+			}
+
+			const FITPChecksumSample Sample = { Step, UITPChecksumSubsystem::HashReplicatedState(Movement, bGliding, GlideStartVelocityY) };
+			const FRepMovement Received = Transmit(Movement);
+			for (int32 Client = 0; Client < 2; ++Client)
+			{
+				if (Step < JoinSteps[Client])
+				{
+					continue;
+				}
+
+				const uint32 Local = UITPChecksumSubsystem::HashReplicatedState(Received, bGliding, GlideStartVelocityY);
+				ClientHashes[Client].Add(Sample.Step, Local);
+				++NumVerified[Client];
+				NumMismatches[Client] += Local != Sample.Checksum ? 1 : 0;
+			}
+
+			if (Step == NumServerSteps / 2)
+			{
+				FRepMovement Corrupt = Received;
+				Corrupt.Location.Z += 1.0;
+				bCaughtError = UITPChecksumSubsystem::HashReplicatedState(Corrupt, bGliding, GlideStartVelocityY) != Sample.Checksum;
+			}
+		}
+
+		int32 NumDisagreements = 0;
+		for (const TPair<uint32, uint32>& Pair : ClientHashes[1])
+		{
+			const uint32* Other = ClientHashes[0].Find(Pair.Key);
+			NumDisagreements += !Other || *Other != Pair.Value ? 1 : 0;
+		}
+
+		const bool bPassed = NumVerified[0] > 0 && NumVerified[1] > 0 && NumMismatches[0] == 0 && NumMismatches[1] == 0
+			&& NumDisagreements == 0 && bCaughtError;
+		UE_LOG(LogITP, Display, TEXT("Checksum self test %s: clients joining at steps %u and %u verified %u and %u samples, %u and %u mismatches, %d disagreement(s) on shared steps, corrupted state %s"),
+			bPassed ? TEXT("passed") : TEXT("FAILED"),
+			JoinSteps[0], JoinSteps[1], NumVerified[0], NumVerified[1], NumMismatches[0], NumMismatches[1], NumDisagreements,
+			bCaughtError ? TEXT("detected") : TEXT("MISSED"));
+	}
+
+	static FAutoConsoleCommand SelfTestCommand(
+		TEXT("ITP.Checksum.SelfTest"),
+		TEXT("Simulates a server and two clients joining at different steps and checks that replicated checksums agree."),
+		FConsoleCommandDelegate::CreateStatic(&SelfTest));
+}
+
+void UITPChecksumSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	RegisterSystem(ITPChecksum::CharactersSystem, FITPChecksumGatherer::CreateUObject(this, &UITPChecksumSubsystem::GatherCharacters));
+
+	if (const UITPRandomSubsystem* Random = UGameInstance::GetSubsystem<UITPRandomSubsystem>(GetWorld()->GetGameInstance()))
+	{
+		RegisterSystem(ITPChecksum::RandomSystem, FITPChecksumGatherer::CreateUObject(Random, &UITPRandomSubsystem::AppendChecksum));
+	}
+
+	if (GITPChecksumRecord != 0)
+	{
+		OpenRecording();
+	}
+}
+
+void UITPChecksumSubsystem::Deinitialize()
+{
+	if (Recording)
+	{
+		Recording->Close();
+		Recording.Reset();
+	}
+
+	Super::Deinitialize();
+}
+
+void UITPChecksumSubsystem::Tick(float DeltaTime)
+{
+	FITPGovernorScope GovernorScope(GetWorld(), EITPGovernedSystem::Checksums);
+
+	const float FixedDeltaSeconds = ITPKinematics::GetFixedDeltaSeconds();
+
+	Accumulator += DeltaTime;
+	while (Accumulator >= FixedDeltaSeconds)
+	{
+		StepChecksums();
+		Accumulator -= FixedDeltaSeconds;
+	}
+}
+
+TStatId UITPChecksumSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UITPChecksumSubsystem, STATGROUP_Tickables);
+}
+
+bool UITPChecksumSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UITPChecksumSubsystem::RegisterSystem(FName SystemName, FITPChecksumGatherer Gatherer)
+{
+	for (FSystem& System : Systems)
+	{
+		if (System.Name == SystemName)
+		{
+			System.Gatherer = MoveTemp(Gatherer);
+			return;
+		}
+	}
+
+	Systems.Add({ SystemName, MoveTemp(Gatherer), 0 });
+
+	if (Recording)
+	{
+		uint8 Tag = ITPChecksum::SystemName;
+		FString Name = SystemName.ToString();
+		*Recording << Tag << Name;
+	}
+}
+
+void UITPChecksumSubsystem::UnregisterSystem(FName SystemName)
+{
+	// Slots are kept so system indices in recordings stay stable
+	for (FSystem& System : Systems)
+	{
+		if (System.Name == SystemName)
+		{
+			System.Gatherer.Unbind();
+		}
+	}
+}
+
+void UITPChecksumSubsystem::AddCharacter(AITPCharacter* Character)
+{
+	Characters.AddUnique(Character);
+}
+
+void UITPChecksumSubsystem::RemoveCharacter(AITPCharacter* Character)
+{
+	Characters.Remove(Character);
+}
+
+uint32 UITPChecksumSubsystem::GetChecksumStride() const
+{
+	return 1u << UITPFrameGovernorSubsystem::GetKnobLevel(GetWorld(), EITPGovernorKnob::ChecksumStride);
+}
+
+uint32 UITPChecksumSubsystem::HashReplicatedState(const FRepMovement& Movement, bool bGliding, float GlideStartVelocityY)
+{
+	// Runs from every character's PreReplication and PostNetReceive, so no serializer round trip here
+	FITPChecksumBuilder Builder;
+	ITPChecksum::AddQuantized(Builder, Movement.Location, Movement.LocationQuantizationLevel);
+	ITPChecksum::AddQuantized(Builder, Movement.LinearVelocity, Movement.VelocityQuantizationLevel);
+	Builder.Add(bGliding);
+	Builder.Add(GlideStartVelocityY);
+	return Builder.Crc;
+}
+
+void UITPChecksumSubsystem::VerifyRemoteSample(const AActor* Source, const FITPChecksumSample& Sample, uint32 LocalChecksum)
+{
+	++NumVerified;
+	if (LocalChecksum != Sample.Checksum)
+	{
+		++NumMismatches;
+		UE_LOG(LogITP, Warning, TEXT("Replicated state mismatch for %s at server step %u: local %08x, authority %08x"), *GetNameSafe(Source), Sample.Step, LocalChecksum, Sample.Checksum);
+	}
+}
+
+void UITPChecksumSubsystem::StepChecksums()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ITPChecksumStep);
+
+	++NumSteps;
+	if (!Recording && NumSteps % GetChecksumStride() != 0)
+	{
+		return;
+	}
+
+	for (FSystem& System : Systems)
+	{
+		FITPChecksumBuilder Builder;
+		Builder.Crc = System.Rolling;
+		System.Gatherer.ExecuteIfBound(Builder);
+		System.Rolling = Builder.Crc;
+
+		CombinedChecksum = FCrc::MemCrc32(&System.Rolling, sizeof(System.Rolling), CombinedChecksum);
+	}
+
+	if (Recording)
+	{
+		uint8 Tag = ITPChecksum::Step;
+		TArray<uint32> Rolling;
+		Rolling.Reserve(Systems.Num());
+		for (const FSystem& System : Systems)
+		{
+			Rolling.Add(System.Rolling);
+		}
+		*Recording << Tag << NumSteps << CombinedChecksum << Rolling;
+	}
+}
+
+void UITPChecksumSubsystem::GatherCharacters(FITPChecksumBuilder& Builder)
+{
+	// Player ids are assigned by the server and replicated; names only break ties, e.g. between level-placed NPCs
+	Characters.RemoveAll([](const TWeakObjectPtr<AITPCharacter>& Character) { return !Character.IsValid(); });
+	Algo::Sort(Characters, [](const TWeakObjectPtr<AITPCharacter>& A, const TWeakObjectPtr<AITPCharacter>& B)
+	{
+		const APlayerState* PlayerStateA = A->GetPlayerState();
+		const APlayerState* PlayerStateB = B->GetPlayerState();
+		const int32 IdA = PlayerStateA ? PlayerStateA->GetPlayerId() : MAX_int32;
+		const int32 IdB = PlayerStateB ? PlayerStateB->GetPlayerId() : MAX_int32;
+		return IdA != IdB ? IdA < IdB : A->GetFName().LexicalLess(B->GetFName());
+	});
+
+	for (const TWeakObjectPtr<AITPCharacter>& Character : Characters)
+	{
+		if (Character.IsValid())
+		{
+			Character->AppendChecksum(Builder);
+		}
+	}
+}
+
+void UITPChecksumSubsystem::OpenRecording()
+{
+	const FString Filename = FPaths::ProjectSavedDir() / TEXT("ITP/Checksums") / FString::Printf(TEXT("%s_%s.itpsum"), *GetWorld()->GetMapName(), *FDateTime::Now().ToString());
+	Recording.Reset(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Recording)
+	{
+		UE_LOG(LogITP, Warning, TEXT("Could not create checksum recording '%s'"), *Filename);
+		return;
+	}
+
+	uint32 Magic = ITPChecksum::FileMagic;
+	uint32 Version = ITPChecksum::FileVersion;
+	*Recording << Magic << Version;
+
+	for (const FSystem& System : Systems)
+	{
+		uint8 Tag = ITPChecksum::SystemName;
+		FString Name = System.Name.ToString();
+		*Recording << Tag << Name;
+	}
+
+	UE_LOG(LogITP, Log, TEXT("Recording simulation checksums to '%s'"), *Filename);
+}
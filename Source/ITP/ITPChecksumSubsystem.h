@@ -0,0 +1,120 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/Crc.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ITPChecksumSubsystem.generated.h"
+
+class AITPCharacter;
+class FArchive;
+struct FRepMovement;
+
+/** Accumulates raw state bits into a CRC. Only feed it padding-free values. */
+struct FITPChecksumBuilder
+{
+	uint32 Crc = 0;
+
+	template<typename T>
+	void Add(const T& Value)
+	{
+		static_assert(TIsArithmetic<T>::Value || TIsEnum<T>::Value, "Hash individual fields to avoid struct padding");
+		Crc = FCrc::MemCrc32(&Value, sizeof(T), Crc);
+	}
+
+	void Add(const FVector& Value) { Add(Value.X); Add(Value.Y); Add(Value.Z); }
+	void Add(const FQuat& Value) { Add(Value.X); Add(Value.Y); Add(Value.Z); Add(Value.W); }
+	void Add(const FVector2f& Value) { Add(Value.X); Add(Value.Y); }
+};
+
+DECLARE_DELEGATE_OneParam(FITPChecksumGatherer, FITPChecksumBuilder&);
+
+/** Checksum of replicated state, stamped with the server step it was taken at */
+USTRUCT()
+struct FITPChecksumSample
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint32 Step = 0;
+
+	UPROPERTY()
+	uint32 Checksum = 0;
+};
+
+/**
+ * Rolling per-step checksums of ITP simulation state, one per system plus a combined value.
+ * Built-in systems are "Characters" and "RNG" (run seed and shared stream counters).
+ * With ITP.Checksum.Record=1 every step is written to Saved/ITP/Checksums so two runs can be compared with
+ * "ITP.Checksum.Bisect <FileA> <FileB>".
+ * Networked sessions and replays do not compare rolling values, since each machine starts counting when it joins.
+ * Instead every character replicates a checksum of its own replicated state stamped with the server step
+ * (AITPCharacter::PreReplication), and clients check it against the state that arrived in the same update.
+ */
+UCLASS()
+class UITPChecksumSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Adds a named system. Systems are hashed in registration order, so register them deterministically. */
+	void RegisterSystem(FName SystemName, FITPChecksumGatherer Gatherer);
+	void UnregisterSystem(FName SystemName);
+
+	void AddCharacter(AITPCharacter* Character);
+	void RemoveCharacter(AITPCharacter* Character);
+
+	/** Fixed steps simulated in this world; replicated samples carry the server's value */
+	uint32 GetNumSteps() const { return NumSteps; }
+
+	/**
+	 * Fixed steps between two checksums, set by the frame governor's ChecksumStride knob. Applies to the rolling
+	 * checksums (except while recording, so recordings stay comparable) and to each character's replicated samples.
+	 */
+	uint32 GetChecksumStride() const;
+
+	/**
+	 * Checksum of a character's replicated movement and glide. Location and velocity are hashed as the grid steps
+	 * of FRepMovement's quantization levels, so the server's value and a client's copy of what it received hash the same.
+	 */
+	static uint32 HashReplicatedState(const FRepMovement& Movement, bool bGliding, float GlideStartVelocityY);
+
+	/** Client: compares a replicated sample against the hash of the state that arrived with it */
+	void VerifyRemoteSample(const AActor* Source, const FITPChecksumSample& Sample, uint32 LocalChecksum);
+
+	uint32 GetNumVerified() const { return NumVerified; }
+	uint32 GetNumMismatches() const { return NumMismatches; }
+
+private:
+	void StepChecksums();
+	void GatherCharacters(FITPChecksumBuilder& Builder);
+
+	void OpenRecording();
+
+	struct FSystem
+	{
+		FName Name;
+		FITPChecksumGatherer Gatherer;
+		uint32 Rolling = 0;
+	};
+	TArray<FSystem> Systems;
+
+	/** Sorted by player id, then name, before each step so iteration order matches across runs and machines */
+	TArray<TWeakObjectPtr<AITPCharacter>> Characters;
+
+	uint32 NumSteps = 0;
+	uint32 CombinedChecksum = 0;
+	float Accumulator = 0.f;
+
+	uint32 NumVerified = 0;
+	uint32 NumMismatches = 0;
+
+	TUniquePtr<FArchive> Recording;
+};
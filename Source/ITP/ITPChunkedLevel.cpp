@@ -0,0 +1,104 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPChunkedLevel.h"
+#include "ITP.h"
+#include "Algo/BinarySearch.h"
+#include "EditorFramework/AssetImportData.h"
+#include "Hash/CityHash.h"
+#include "Misc/Compression.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace ITPChunkedLevel
+{
+	static bool CoordLess(const FIntPoint& A, const FIntPoint& B)
+	{
+		return A.Y != B.Y ? A.Y < B.Y : A.X < B.X;
+	}
+}
+
+int32 UITPChunkedLevel::FindChunk(const FIntPoint& Coord) const
+{
+	const int32 Index = Algo::LowerBoundBy(Chunks, Coord, &FITPCookedChunk::Coord, &ITPChunkedLevel::CoordLess);
+	return Chunks.IsValidIndex(Index) && Chunks[Index].Coord == Coord ? Index : INDEX_NONE;
+}
+
+bool UITPChunkedLevel::LoadChunk(int32 Index, FITPLevelChunk& OutChunk) const
+{
+	const FITPCookedChunk& Cooked = Chunks[Index];
+	if (!UncompressChunk(Cooked, OutChunk) || OutChunk.Tiles.Num() != LayerNames.Num() * FITPLevelChunk::TilesPerLayer)
+	{
+		UE_LOG(LogITP, Error, TEXT("%s: chunk (%d, %d) failed to decompress"), *GetName(), Cooked.Coord.X, Cooked.Coord.Y);
+		return false;
+	}
+	return true;
+}
+
+bool UITPChunkedLevel::UncompressChunk(const FITPCookedChunk& Cooked, FITPLevelChunk& OutChunk)
+{
+	// The size comes from the asset or file, so it is checked before it decides an allocation
+	if (Cooked.UncompressedSize < FITPLevelChunk::MinSerializedSize || Cooked.UncompressedSize > FITPLevelChunk::MaxSerializedSize || Cooked.CompressedData.Num() == 0)
+	{
+		return false;
+	}
+
+	TArray<uint8> Uncompressed;
+	Uncompressed.SetNumUninitialized(Cooked.UncompressedSize);
+	if (!FCompression::UncompressMemory(NAME_LZ4, Uncompressed.GetData(), Cooked.UncompressedSize, Cooked.CompressedData.GetData(), Cooked.CompressedData.Num()))
+	{
+		return false;
+	}
+
+	// A valid chunk is whole layers and uses up exactly the bytes it claimed
+	FMemoryReader Reader(Uncompressed);
+	Reader << OutChunk;
+	return !Reader.IsError() && Reader.Tell() == Uncompressed.Num() && OutChunk.Tiles.Num() % FITPLevelChunk::TilesPerLayer == 0;
+}
+
+bool UITPChunkedLevel::CookChunk(FITPLevelChunk& Chunk, FITPCookedChunk& OutCooked)
+{
+	TArray<uint8> Uncompressed;
+	FMemoryWriter Writer(Uncompressed);
+	Writer << Chunk;
+
+	if (Uncompressed.Num() > FITPLevelChunk::MaxSerializedSize)
+	{
+		return false;
+	}
+
+	int32 CompressedSize = FCompression::CompressMemoryBound(NAME_LZ4, Uncompressed.Num());
+	OutCooked.CompressedData.SetNumUninitialized(CompressedSize);
+	if (!FCompression::CompressMemory(NAME_LZ4, OutCooked.CompressedData.GetData(), CompressedSize, Uncompressed.GetData(), Uncompressed.Num()))
+	{
+		OutCooked.CompressedData.Reset();
+		return false;
+	}
+	OutCooked.CompressedData.SetNum(CompressedSize);
+
+	OutCooked.Coord = Chunk.Coord;
+	OutCooked.SourceHash = CityHash64(reinterpret_cast<const char*>(Uncompressed.GetData()), Uncompressed.Num());
+	OutCooked.UncompressedSize = Uncompressed.Num();
+	return true;
+}
+
+#if WITH_EDITOR
+void UITPChunkedLevel::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	if (!HasAnyFlags(RF_ClassDefaultObject))
+	{
+		AssetImportData = NewObject<UAssetImportData>(this, TEXT("AssetImportData"));
+	}
+}
+
+void UITPChunkedLevel::GetAssetRegistryTags(TArray<FAssetRegistryTag>& OutTags) const
+{
+	if (AssetImportData)
+	{
+		OutTags.Add(FAssetRegistryTag(SourceFileTagName(), AssetImportData->GetSourceData().ToJson(), FAssetRegistryTag::TT_Hidden));
+	}
+
+	Super::GetAssetRegistryTags(OutTags);
+}
+#endif
@@ -0,0 +1,144 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "ITPMath2D.h"
+#include "ITPChunkedLevel.generated.h"
+
+class UAssetImportData;
+
+/** Entities a cooked level can spawn */
+UENUM()
+enum class EITPSpawnType : uint8
+{
+	PlayerStart,
+	Coin,
+	Enemy,
+	Checkpoint,
+	Other,
+};
+
+/** One spawn table row */
+struct FITPSpawnEntry
+{
+	EITPSpawnType Type = EITPSpawnType::Other;
+
+	/** Id from the source map, stable across re-imports */
+	int32 SourceId = 0;
+
+	/** Plane location, see ITPMath2D.h */
+	FVector2f Location = FVector2f::ZeroVector;
+
+	/** Source "name" or "class" used to pick the spawned archetype */
+	FName Archetype;
+
+	friend FArchive& operator<<(FArchive& Ar, FITPSpawnEntry& Entry)
+	{
+		Ar << Entry.Type << Entry.SourceId << Entry.Location << Entry.Archetype;
+		return Ar;
+	}
+};
+
+/** Decompressed chunk: ChunkSize x ChunkSize tiles per layer, plus the chunk's spawn table sorted by type */
+struct FITPLevelChunk
+{
+	/** Tiles per chunk side */
+	static constexpr int32 ChunkSize = 32;
+	static constexpr int32 TilesPerLayer = ChunkSize * ChunkSize;
+
+	/** Serialized size bounds: coord and both array counts, up to far more layers and spawns than a level uses */
+	static constexpr int32 MinSerializedSize = sizeof(FIntPoint) + 2 * sizeof(int32);
+	static constexpr int32 MaxSerializedSize = 16 * 1024 * 1024;
+
+	FIntPoint Coord = FIntPoint::ZeroValue;
+
+	/** Layer-major tile ids, 0 is empty. Index with GetTileIndex. */
+	TArray<uint16> Tiles;
+
+	TArray<FITPSpawnEntry> Spawns;
+
+	static FORCEINLINE int32 GetTileIndex(int32 Layer, int32 LocalX, int32 LocalY)
+	{
+		return Layer * TilesPerLayer + LocalY * ChunkSize + LocalX;
+	}
+
+	static FORCEINLINE FIntPoint TileToChunk(const FIntPoint& Tile)
+	{
+		const auto FloorDiv = [](int32 Value) { return Value >= 0 ? Value / ChunkSize : (Value - ChunkSize + 1) / ChunkSize; };
+		return FIntPoint(FloorDiv(Tile.X), FloorDiv(Tile.Y));
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, FITPLevelChunk& Chunk)
+	{
+		Ar << Chunk.Coord << Chunk.Tiles << Chunk.Spawns;
+		return Ar;
+	}
+};
+
+/** Chunk as stored in the asset: LZ4 compressed FITPLevelChunk */
+USTRUCT()
+struct FITPCookedChunk
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FIntPoint Coord = FIntPoint::ZeroValue;
+
+	/** Hash of the source content this chunk was cooked from, used to skip unchanged chunks on re-import */
+	UPROPERTY()
+	uint64 SourceHash = 0;
+
+	UPROPERTY()
+	int32 UncompressedSize = 0;
+
+	UPROPERTY()
+	TArray<uint8> CompressedData;
+};
+
+/**
+ * ITP chunked binary level. Produced by the Tiled importer in the ITPEditor module; chunks are decompressed on demand.
+ */
+UCLASS()
+class ITP_API UITPChunkedLevel : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	/** Level size in tiles */
+	UPROPERTY(VisibleAnywhere, Category = Level)
+	FIntPoint SizeInTiles = FIntPoint::ZeroValue;
+
+	UPROPERTY(VisibleAnywhere, Category = Level)
+	float TileSize = ITP2D::DefaultTileSize;
+
+	UPROPERTY(VisibleAnywhere, Category = Level)
+	TArray<FName> LayerNames;
+
+	/** Sorted by Coord.Y then Coord.X; empty chunks are omitted */
+	UPROPERTY()
+	TArray<FITPCookedChunk> Chunks;
+
+	int32 FindChunk(const FIntPoint& Coord) const;
+
+	/** Decompresses chunk Index into OutChunk. Returns false if the data is corrupt. */
+	bool LoadChunk(int32 Index, FITPLevelChunk& OutChunk) const;
+
+	/** Decompresses a chunk that did not come from an asset, e.g. one read from an ITPLevelFile */
+	static bool UncompressChunk(const FITPCookedChunk& Cooked, FITPLevelChunk& OutChunk);
+
+	/** Serializes and compresses Chunk into OutCooked; SourceHash is the hash of the serialized, uncompressed chunk. False if compression failed. */
+	static bool CookChunk(FITPLevelChunk& Chunk, FITPCookedChunk& OutCooked);
+
+#if WITH_EDITORONLY_DATA
+	/** Source map path for re-import */
+	UPROPERTY(VisibleAnywhere, Instanced, Category = ImportSettings)
+	TObjectPtr<UAssetImportData> AssetImportData;
+#endif
+
+#if WITH_EDITOR
+	virtual void PostInitProperties() override;
+	virtual void GetAssetRegistryTags(TArray<FAssetRegistryTag>& OutTags) const override;
+#endif
+};
@@ -0,0 +1,87 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPCoin.h"
+#include "ITPCharacter.h"
+#include "ITPCollision.h"
+#include "ITPEffectsSubsystem.h"
+#include "ITPLevelStateSubsystem.h"
+#include "Components/SphereComponent.h"
+#include "Components/StaticMeshComponent.h"
+
+AITPCoin::AITPCoin()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	// Replicated for spawner coins only; DORM_Initial keeps placed ones off the wire entirely
+	bReplicates = true;
+	NetDormancy = DORM_Initial;
+
+	Trigger = CreateDefaultSubobject<USphereComponent>(TEXT("Trigger"));
+	Trigger->InitSphereRadius(40.f);
+	Trigger->SetCollisionProfileName(ITPCollision::PickupProfile);
+	RootComponent = Trigger;
+
+	Mesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Mesh"));
+	Mesh->SetupAttachment(Trigger);
+	Mesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+}
+
+void AITPCoin::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// DORM_Initial only applies to coins placed in the level; spawned ones replicate once, then sleep.
+	// Movement replicates so a pooled coin shows up where it was acquired, which the pool's dormancy flush sends.
+	if (HasAuthority() && !IsNetStartupActor())
+	{
+		SetReplicatingMovement(true);
+		SetNetDormancy(DORM_DormantAll);
+	}
+}
+
+void AITPCoin::Collect(bool bPlayEffect)
+{
+	if (bCollected)
+	{
+		return;
+	}
+	bCollected = true;
+
+	UITPEffectsSubsystem* Effects = GetWorld()->GetSubsystem<UITPEffectsSubsystem>();
+	if (bPlayEffect && Effects && GetNetMode() != NM_DedicatedServer)
+	{
+		Effects->Spawn(EITPEffect::CoinPickup, GetActorLocation());
+	}
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+}
+
+void AITPCoin::NotifyActorBeginOverlap(AActor* OtherActor)
+{
+	Super::NotifyActorBeginOverlap(OtherActor);
+
+	if (bCollected || !Cast<AITPCharacter>(OtherActor))
+	{
+		return;
+	}
+
+	Collect(true);
+
+	// Coins without an id belong to a spawner, which respawns them once they are gone. Clients only hide
+	// theirs; the authority's destroy closes the channel.
+	if (LevelStateId == INDEX_NONE)
+	{
+		if (HasAuthority())
+		{
+			Destroy();
+		}
+	}
+	else if (GetNetMode() != NM_Client)
+	{
+		if (UITPLevelStateSubsystem* LevelState = GetWorld()->GetSubsystem<UITPLevelStateSubsystem>())
+		{
+			LevelState->CollectEntity(LevelStateId);
+		}
+	}
+}
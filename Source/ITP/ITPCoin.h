@@ -0,0 +1,45 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ITPCoin.generated.h"
+
+class USphereComponent;
+class UStaticMeshComponent;
+
+/**
+ * Collectible coin. Disappears on overlap with an ITP character and plays the pickup effect.
+ * Coins placed in the level stay dormant for good and are tracked by UITPLevelStateSubsystem. Coins a spawner
+ * creates replicate once, then sleep until the authority destroys them on pickup.
+ */
+UCLASS()
+class AITPCoin : public AActor
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, Category = Coin)
+	TObjectPtr<USphereComponent> Trigger;
+
+	UPROPERTY(VisibleAnywhere, Category = Coin)
+	TObjectPtr<UStaticMeshComponent> Mesh;
+
+public:
+	AITPCoin();
+
+	/** Hides the coin for good; the effect is skipped when catching up from a level state snapshot */
+	void Collect(bool bPlayEffect);
+	bool IsCollected() const { return bCollected; }
+
+	/** Entity id in the level state, INDEX_NONE for coins not placed in the level */
+	void SetLevelStateId(int32 Id) { LevelStateId = Id; }
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void NotifyActorBeginOverlap(AActor* OtherActor) override;
+
+private:
+	int32 LevelStateId = INDEX_NONE;
+	bool bCollected = false;
+};
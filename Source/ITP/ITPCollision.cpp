@@ -0,0 +1,147 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPCollision.h"
+#include "ITP.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/OverlapResult.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Ground Probe"), STAT_ITPGroundProbe, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ground Probe Queries"), STAT_ITPGroundProbeQueries, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ground Probe Hits"), STAT_ITPGroundProbeHits, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ground Probe Narrow Phase Tests"), STAT_ITPGroundProbeNarrowPhase, STATGROUP_ITP);
+
+static int32 GITPLegacyVisibilityProbes = 0;
+static FAutoConsoleVariableRef CVarITPLegacyVisibilityProbes(
+	TEXT("ITP.Collision.LegacyVisibilityProbes"),
+	GITPLegacyVisibilityProbes,
+	TEXT("1 = ground probes trace ECC_Visibility against every visible primitive (pre ITP_Ground behaviour).\n")
+	TEXT("0 = ground probes only test ITP_Ground object types (default)."),
+	ECVF_Cheat);
+
+static int32 GITPProbeWorldStatic = 1;
+static FAutoConsoleVariableRef CVarITPProbeWorldStatic(
+	TEXT("ITP.Collision.ProbeWorldStatic"),
+	GITPProbeWorldStatic,
+	TEXT("1 = ground probes also hit WorldStatic, for level content not yet switched to the ITPGround profile (default).\n")
+	TEXT("0 = ITP_Ground only, once every floor uses ITPGround."));
+
+static int32 GITPCountNarrowPhase = 0;
+static FAutoConsoleVariableRef CVarITPCountNarrowPhase(
+	TEXT("ITP.Collision.CountNarrowPhase"),
+	GITPCountNarrowPhase,
+	TEXT("1 = count the primitives each ground probe has to test exactly (an extra overlap query per probe; for measurement only)."));
+
+/** Totals since the last ITP.Collision.Report reset, per probe path */
+struct FITPProbeTotals
+{
+	uint64 Queries = 0;
+	uint64 Hits = 0;
+	uint64 NarrowPhaseTests = 0;
+	uint64 CountedQueries = 0;
+};
+static FITPProbeTotals GITPProbeTotals[2];
+
+namespace ITPCollision
+{
+	const FName GroundProfile(TEXT("ITPGround"));
+	const FName HazardProfile(TEXT("ITPHazard"));
+	const FName PickupProfile(TEXT("ITPPickup"));
+
+	bool IsHazard(const AActor* Actor)
+	{
+		const UPrimitiveComponent* Root = Actor ? Cast<UPrimitiveComponent>(Actor->GetRootComponent()) : nullptr;
+		return Root && Root->GetCollisionObjectType() == ECC_ITP_Hazard;
+	}
+
+	FCollisionObjectQueryParams GroundProbeObjects()
+	{
+		FCollisionObjectQueryParams ObjectParams;
+		ObjectParams.AddObjectTypesToQuery(ECC_ITP_Ground);
+		if (GITPProbeWorldStatic != 0)
+		{
+			ObjectParams.AddObjectTypesToQuery(ECC_WorldStatic);
+		}
+		return ObjectParams;
+	}
+
+	bool IsProbedByGround(const UPrimitiveComponent* Primitive)
+	{
+		if (!Primitive || !Primitive->IsQueryCollisionEnabled())
+		{
+			return false;
+		}
+		if (GITPLegacyVisibilityProbes != 0)
+		{
+			return Primitive->GetCollisionResponseToChannel(ECC_Visibility) == ECR_Block;
+		}
+		const ECollisionChannel ObjectType = Primitive->GetCollisionObjectType();
+		return ObjectType == ECC_ITP_Ground || (GITPProbeWorldStatic != 0 && ObjectType == ECC_WorldStatic);
+	}
+
+	bool LineProbeGround(const UWorld* World, FHitResult& OutHit, const FVector& Start, const FVector& End, const FCollisionQueryParams& Params)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ITPGroundProbe);
+		INC_DWORD_STAT(STAT_ITPGroundProbeQueries);
+
+		const bool bLegacy = GITPLegacyVisibilityProbes != 0;
+		const bool bHit = bLegacy
+			? World->LineTraceSingleByChannel(OutHit, Start, End, ECC_Visibility, Params)
+			: World->LineTraceSingleByObjectType(OutHit, Start, End, GroundProbeObjects(), Params);
+
+		FITPProbeTotals& Totals = GITPProbeTotals[bLegacy ? 1 : 0];
+		++Totals.Queries;
+		if (bHit)
+		{
+			INC_DWORD_STAT(STAT_ITPGroundProbeHits);
+			++Totals.Hits;
+		}
+
+		// Every primitive overlapping the segment's box passes the broad phase and gets an exact ray test
+		if (GITPCountNarrowPhase != 0)
+		{
+			const FBox SegmentBox = FBox(Start, Start) + End;
+			const FCollisionShape Box = FCollisionShape::MakeBox(SegmentBox.GetExtent());
+			TArray<FOverlapResult> Candidates;
+			if (bLegacy)
+			{
+				World->OverlapMultiByChannel(Candidates, SegmentBox.GetCenter(), FQuat::Identity, ECC_Visibility, Box, Params);
+			}
+			else
+			{
+				World->OverlapMultiByObjectType(Candidates, SegmentBox.GetCenter(), FQuat::Identity, GroundProbeObjects(), Box, Params);
+			}
+			INC_DWORD_STAT_BY(STAT_ITPGroundProbeNarrowPhase, Candidates.Num());
+			Totals.NarrowPhaseTests += Candidates.Num();
+			++Totals.CountedQueries;
+		}
+		return bHit;
+	}
+}
+
+static FAutoConsoleCommand CmdITPCollisionReport(
+	TEXT("ITP.Collision.Report"),
+	TEXT("ITP.Collision.Report [reset]: ground probe queries, hit rate and narrow phase tests per probe, for the ITP_Ground path and the\n")
+	TEXT("legacy visibility path. Play the same stretch once with ITP.Collision.LegacyVisibilityProbes 0 and once with 1 to compare;\n")
+	TEXT("narrow phase tests are only counted while ITP.Collision.CountNarrowPhase is 1."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+		{
+			GITPProbeTotals[0] = FITPProbeTotals();
+			GITPProbeTotals[1] = FITPProbeTotals();
+			return;
+		}
+
+		for (int32 Path = 0; Path < 2; ++Path)
+		{
+			const FITPProbeTotals& Totals = GITPProbeTotals[Path];
+			UE_LOG(LogITP, Log, TEXT("Ground probes (%s): %llu queries, %.1f%% hit, %s narrow phase tests per probe"),
+				Path == 0 ? TEXT("ITP_Ground") : TEXT("visibility"),
+				Totals.Queries,
+				Totals.Queries > 0 ? 100.0 * Totals.Hits / Totals.Queries : 0.0,
+				Totals.CountedQueries > 0 ? *FString::Printf(TEXT("%.2f"), (double)Totals.NarrowPhaseTests / Totals.CountedQueries) : TEXT("n/a"));
+		}
+	}));
@@ -0,0 +1,40 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "CollisionQueryParams.h"
+
+class AActor;
+class UPrimitiveComponent;
+class UWorld;
+
+/** Project object channels, declared in Config/DefaultEngine.ini under [/Script/Engine.CollisionProfile] */
+#define ECC_ITP_Ground	ECC_GameTraceChannel1
+#define ECC_ITP_Hazard	ECC_GameTraceChannel2
+#define ECC_ITP_Pickup	ECC_GameTraceChannel3
+
+namespace ITPCollision
+{
+	/** Collision profiles level content should use instead of BlockAll / OverlapAll */
+	extern const FName GroundProfile;
+	extern const FName HazardProfile;
+	extern const FName PickupProfile;
+
+	/** Whether Actor's root is an ITP_Hazard, i.e. it damages characters that overlap it */
+	bool IsHazard(const AActor* Actor);
+
+	/** Object types a ground or glide probe is allowed to hit: ITP_Ground, plus WorldStatic while ITP.Collision.ProbeWorldStatic is set */
+	FCollisionObjectQueryParams GroundProbeObjects();
+
+	/** Whether LineProbeGround can hit Primitive on the current probe path */
+	bool IsProbedByGround(const UPrimitiveComponent* Primitive);
+
+	/**
+	 * Single line probe against walkable ground.
+	 * Only GroundProbeObjects() are tested unless ITP.Collision.LegacyVisibilityProbes is set,
+	 * in which case the old ECC_Visibility trace is used so both paths can be compared with "stat ITP".
+	 */
+	bool LineProbeGround(const UWorld* World, FHitResult& OutHit, const FVector& Start, const FVector& End, const FCollisionQueryParams& Params);
+}
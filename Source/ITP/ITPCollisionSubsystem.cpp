@@ -0,0 +1,118 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPCollisionSubsystem.h"
+#include "ITPCollision.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/Pawn.h"
+
+void UITPCollisionSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	ActorDestroyedHandle = GetWorld()->AddOnActorDestroyedHandler(FOnActorDestroyed::FDelegate::CreateUObject(this, &UITPCollisionSubsystem::HandleActorDestroyed));
+}
+
+void UITPCollisionSubsystem::Deinitialize()
+{
+	GetWorld()->RemoveOnActorDestroyedHandler(ActorDestroyedHandle);
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+
+	Super::Deinitialize();
+}
+
+void UITPCollisionSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	for (ULevel* Level : InWorld.GetLevels())
+	{
+		HandleLevelAdded(Level, &InWorld);
+	}
+
+	ActorSpawnedHandle = InWorld.AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UITPCollisionSubsystem::WatchMovableGeometry));
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UITPCollisionSubsystem::HandleLevelAdded);
+}
+
+void UITPCollisionSubsystem::InvalidateProbes(const FBox& Region)
+{
+	++Generation;
+	Invalidations[Generation % MaxInvalidations] = { Region, Generation };
+}
+
+bool UITPCollisionSubsystem::IsRegionDirtySince(uint32 SinceGeneration, const FBox& Bounds) const
+{
+	if (SinceGeneration == Generation)
+	{
+		return false;
+	}
+
+	// The cache is older than anything we still remember
+	if (Generation - SinceGeneration >= MaxInvalidations)
+	{
+		return true;
+	}
+
+	for (uint32 Gen = SinceGeneration + 1; Gen <= Generation; ++Gen)
+	{
+		if (Invalidations[Gen % MaxInvalidations].Region.Intersect(Bounds))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void UITPCollisionSubsystem::HandleActorDestroyed(AActor* Actor)
+{
+	for (const UActorComponent* Component : Actor->GetComponents())
+	{
+		const UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Component);
+		if (ITPCollision::IsProbedByGround(Primitive))
+		{
+			InvalidateProbes(Primitive->Bounds.GetBox());
+		}
+	}
+}
+
+void UITPCollisionSubsystem::HandleLevelAdded(ULevel* Level, UWorld* InWorld)
+{
+	if (Level && InWorld == GetWorld())
+	{
+		for (AActor* Actor : Level->Actors)
+		{
+			WatchMovableGeometry(Actor);
+		}
+	}
+}
+
+void UITPCollisionSubsystem::WatchMovableGeometry(AActor* Actor)
+{
+	// Characters probe each other only through stomps, which never go through the cache
+	if (!Actor || Actor->IsA<APawn>())
+	{
+		return;
+	}
+
+	for (UActorComponent* Component : Actor->GetComponents())
+	{
+		UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Component);
+		if (Primitive && Primitive->Mobility == EComponentMobility::Movable && Primitive->IsQueryCollisionEnabled())
+		{
+			Primitive->TransformUpdated.AddUObject(this, &UITPCollisionSubsystem::HandleGeometryMoved);
+		}
+	}
+}
+
+void UITPCollisionSubsystem::HandleGeometryMoved(USceneComponent* Component, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	// Checked per move rather than when binding, so switching probe paths at runtime stays correct
+	const UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Component);
+	if (ITPCollision::IsProbedByGround(Primitive))
+	{
+		InvalidateProbes(Primitive->Bounds.GetBox());
+	}
+}
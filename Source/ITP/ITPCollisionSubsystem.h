@@ -0,0 +1,59 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ITPCollisionSubsystem.generated.h"
+
+class ULevel;
+
+/**
+ * Tracks changes to ITP_Ground geometry so cached probe results can be dropped.
+ * Breakable blocks and other runtime geometry call InvalidateProbes with their bounds;
+ * destroyed actors with ground collision are picked up automatically, and so is every move of a movable
+ * primitive the probes can hit, since a cached miss would not see a platform sliding under it.
+ */
+UCLASS()
+class UITPCollisionSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Marks every cached probe overlapping Region as stale */
+	void InvalidateProbes(const FBox& Region);
+
+	/** Current invalidation generation, stored by caches alongside their results */
+	uint32 GetGeneration() const { return Generation; }
+
+	/** True if anything overlapping Bounds was invalidated after SinceGeneration */
+	bool IsRegionDirtySince(uint32 SinceGeneration, const FBox& Bounds) const;
+
+private:
+	void HandleActorDestroyed(AActor* Actor);
+	void HandleLevelAdded(ULevel* Level, UWorld* InWorld);
+
+	/** Invalidates the probes around Actor's movable primitives whenever they move */
+	void WatchMovableGeometry(AActor* Actor);
+	void HandleGeometryMoved(USceneComponent* Component, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	struct FInvalidation
+	{
+		FBox Region;
+		uint32 Generation;
+	};
+
+	/** Ring of recent invalidations. Caches older than the ring are treated as dirty. */
+	static constexpr int32 MaxInvalidations = 64;
+	FInvalidation Invalidations[MaxInvalidations];
+	uint32 Generation = 0;
+
+	FDelegateHandle ActorDestroyedHandle;
+	FDelegateHandle ActorSpawnedHandle;
+	FDelegateHandle LevelAddedHandle;
+};
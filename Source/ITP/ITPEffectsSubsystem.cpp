@@ -0,0 +1,217 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPEffectsSubsystem.h"
+#include "ITP.h"
+#include "ITPFrameGovernorSubsystem.h"
+#include "ITPIdleSubsystem.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "NiagaraComponent.h"
+#include "NiagaraFunctionLibrary.h"
+#include "NiagaraSystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Effects Flush"), STAT_ITPEffectsFlush, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Effects Requested"), STAT_ITPEffectsRequested, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Effects Spawned"), STAT_ITPEffectsSpawned, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Effects Culled"), STAT_ITPEffectsCulled, STATGROUP_ITP);
+
+void UITPEffectsSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// Loaded up front so the first coin of a run doesn't hitch on a sync load
+	LoadedSystems.SetNum((int32)EITPEffect::Num);
+	for (const TPair<EITPEffect, FITPEffectConfig>& Pair : Effects)
+	{
+		if (Pair.Key < EITPEffect::Num)
+		{
+			LoadedSystems[(int32)Pair.Key] = Pair.Value.System.LoadSynchronous();
+		}
+	}
+}
+
+void UITPEffectsSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ITPEffectsFlush);
+	FITPGovernorScope GovernorScope(GetWorld(), EITPGovernedSystem::Effects);
+
+	// Looping effects whose owner went away without a stop
+	for (auto It = Looping.CreateIterator(); It; ++It)
+	{
+		const bool bOwnerGone = !It->Key.Key.ResolveObjectPtr();
+		if (bOwnerGone && It->Value.IsValid())
+		{
+			It->Value->Deactivate();
+			It->Value->ReleaseToPool();
+		}
+		if (bOwnerGone || !It->Value.IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	if (Pending.IsEmpty())
+	{
+		return;
+	}
+
+	FVector ViewLocation = FVector::ZeroVector;
+	if (const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController())
+	{
+		if (PlayerController->PlayerCameraManager)
+		{
+			ViewLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+		}
+	}
+
+	TArray<FRequest> Requests = MoveTemp(Pending);
+	Pending.Reset();
+
+	// One batch per effect type
+	Requests.Sort([](const FRequest& A, const FRequest& B) { return A.Effect < B.Effect; });
+	int32 Begin = 0;
+	while (Begin < Requests.Num())
+	{
+		int32 End = Begin + 1;
+		while (End < Requests.Num() && Requests[End].Effect == Requests[Begin].Effect)
+		{
+			++End;
+		}
+
+		TArray<FRequest> Batch(Requests.GetData() + Begin, End - Begin);
+		Flush(Batch, Requests[Begin].Effect, ViewLocation);
+		Begin = End;
+	}
+}
+
+TStatId UITPEffectsSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UITPEffectsSubsystem, STATGROUP_ITP);
+}
+
+bool UITPEffectsSubsystem::IsTickable() const
+{
+	return Super::IsTickable() && !UITPIdleSubsystem::IsSuspended(GetWorld());
+}
+
+bool UITPEffectsSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UITPEffectsSubsystem::Spawn(EITPEffect Effect, const FVector& Location, const FRotator& Rotation)
+{
+	// Nobody is watching while idle, and the queue isn't flushed
+	if (UITPIdleSubsystem::IsSuspended(GetWorld()))
+	{
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_ITPEffectsRequested);
+	Pending.Add({Effect, Location, Rotation, nullptr});
+}
+
+void UITPEffectsSubsystem::StartLooping(EITPEffect Effect, USceneComponent* Owner)
+{
+	if (Owner && !UITPIdleSubsystem::IsSuspended(GetWorld()))
+	{
+		INC_DWORD_STAT(STAT_ITPEffectsRequested);
+		Pending.Add({Effect, Owner->GetComponentLocation(), FRotator::ZeroRotator, Owner});
+	}
+}
+
+void UITPEffectsSubsystem::StopLooping(EITPEffect Effect, USceneComponent* Owner)
+{
+	if (!Owner)
+	{
+		return;
+	}
+
+	// Applied right away rather than queued: callers such as EndPlay may not outlive the next flush.
+	// A start still queued for the owner is cancelled, and the freed budget is available to this frame's flush.
+	Pending.RemoveAll([Effect, Owner](const FRequest& Request) { return Request.Effect == Effect && Request.Owner == Owner; });
+
+	TWeakObjectPtr<UNiagaraComponent> Component;
+	if (Looping.RemoveAndCopyValue({Owner, Effect}, Component) && Component.IsValid())
+	{
+		Component->Deactivate();
+		Component->ReleaseToPool();
+	}
+}
+
+void UITPEffectsSubsystem::Flush(TArray<FRequest>& Requests, EITPEffect Effect, const FVector& ViewLocation)
+{
+	const FITPEffectConfig* Config = Effects.Find(Effect);
+	UNiagaraSystem* System = Config && Effect < EITPEffect::Num ? LoadedSystems[(int32)Effect].Get() : nullptr;
+	if (!System)
+	{
+		INC_DWORD_STAT_BY(STAT_ITPEffectsCulled, Requests.Num());
+		return;
+	}
+
+	// Budgets shrink when the frame governor turns the effects knob
+	const float Scale = UITPFrameGovernorSubsystem::GetKnobScale(GetWorld(), EITPGovernorKnob::Effects);
+
+	// Distance cull, then keep the requests nearest the view within what the budget allows
+	const double CullDistanceSquared = FMath::Square((double)Config->CullDistance * Scale);
+	for (FRequest& Request : Requests)
+	{
+		Request.DistanceSquared = FVector::DistSquared(Request.Location, ViewLocation);
+	}
+	const int32 NumBefore = Requests.Num();
+	if (Config->CullDistance > 0.f)
+	{
+		Requests.RemoveAllSwap([CullDistanceSquared](const FRequest& Request) { return Request.DistanceSquared > CullDistanceSquared; }, false);
+	}
+
+	const int32 Budget = FMath::Min(FMath::CeilToInt32(Config->MaxPerFrame * Scale), FMath::CeilToInt32(Config->MaxActive * Scale) - CountActive(Effect));
+	if (Requests.Num() > Budget)
+	{
+		Requests.Sort([](const FRequest& A, const FRequest& B) { return A.DistanceSquared < B.DistanceSquared; });
+		Requests.SetNum(FMath::Max(Budget, 0), false);
+	}
+	INC_DWORD_STAT_BY(STAT_ITPEffectsCulled, NumBefore - Requests.Num());
+
+	for (const FRequest& Request : Requests)
+	{
+		UNiagaraComponent* Component = nullptr;
+		if (USceneComponent* Owner = Request.Owner.Get())
+		{
+			TWeakObjectPtr<UNiagaraComponent>& Running = Looping.FindOrAdd({Owner, Effect});
+			if (Running.IsValid())
+			{
+				continue;
+			}
+
+			// Looping instances go back to the pool on StopLooping
+			Component = UNiagaraFunctionLibrary::SpawnSystemAttached(System, Owner, NAME_None, FVector::ZeroVector, FRotator::ZeroRotator,
+				EAttachLocation::SnapToTarget, false, true, ENCPoolMethod::ManualRelease);
+			Running = Component;
+		}
+		else if (!Request.Owner.IsExplicitlyNull())
+		{
+			// Owner went away before the flush
+			continue;
+		}
+		else
+		{
+			Component = UNiagaraFunctionLibrary::SpawnSystemAtLocation(GetWorld(), System, Request.Location, Request.Rotation,
+				FVector::OneVector, false, true, ENCPoolMethod::AutoRelease);
+		}
+
+		if (Component)
+		{
+			// Pooled components come back for the same system, so they may already be tracked
+			Active[(int32)Effect].AddUnique(Component);
+			INC_DWORD_STAT(STAT_ITPEffectsSpawned);
+		}
+	}
+}
+
+int32 UITPEffectsSubsystem::CountActive(EITPEffect Effect)
+{
+	TArray<TWeakObjectPtr<UNiagaraComponent>>& Instances = Active[(int32)Effect];
+	Instances.RemoveAllSwap([](const TWeakObjectPtr<UNiagaraComponent>& Component) { return !Component.IsValid() || !Component->IsActive(); }, false);
+	return Instances.Num();
+}
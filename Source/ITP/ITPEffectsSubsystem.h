@@ -0,0 +1,101 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "ITPEffectsSubsystem.generated.h"
+
+class UNiagaraComponent;
+class UNiagaraSystem;
+class USceneComponent;
+
+/** Gameplay effects routed through UITPEffectsSubsystem */
+UENUM()
+enum class EITPEffect : uint8
+{
+	GlideTrail,
+	LandingDust,
+	CoinPickup,
+	Num UMETA(Hidden),
+};
+
+/** Asset and budget for one effect */
+USTRUCT()
+struct FITPEffectConfig
+{
+	GENERATED_BODY()
+
+	UPROPERTY(config)
+	TSoftObjectPtr<UNiagaraSystem> System;
+
+	/** Instances alive at once; further requests are dropped, furthest from the view first */
+	UPROPERTY(config)
+	int32 MaxActive = 16;
+
+	/** New instances started per frame */
+	UPROPERTY(config)
+	int32 MaxPerFrame = 4;
+
+	/** Requests further than this from the view are dropped, 0 = never */
+	UPROPERTY(config)
+	float CullDistance = 5000.f;
+};
+
+/**
+ * Spawns gameplay effects from pooled Niagara components.
+ * Requests are queued and handled once per frame: each effect's requests are culled by distance, ranked by
+ * distance to the view and cut to the effect's budget before anything is spawned. One-shot effects auto-release
+ * to the Niagara component pool; looping effects (glide trail) are released when stopped
+ * or, failing that, once their owner is gone.
+ */
+UCLASS(config = Game)
+class ITP_API UITPEffectsSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Queues a one-shot effect */
+	void Spawn(EITPEffect Effect, const FVector& Location, const FRotator& Rotation = FRotator::ZeroRotator);
+
+	/** Queues a looping effect attached to Owner, replacing any Effect already running on it */
+	void StartLooping(EITPEffect Effect, USceneComponent* Owner);
+
+	/** Releases Owner's Effect immediately and drops its queued start, if any */
+	void StopLooping(EITPEffect Effect, USceneComponent* Owner);
+
+private:
+	struct FRequest
+	{
+		EITPEffect Effect;
+		FVector Location;
+		FRotator Rotation;
+		TWeakObjectPtr<USceneComponent> Owner;
+		double DistanceSquared = 0.0;
+	};
+
+	void Flush(TArray<FRequest>& Requests, EITPEffect Effect, const FVector& ViewLocation);
+	int32 CountActive(EITPEffect Effect);
+
+	/** Set in DefaultGame.ini under [/Script/ITP.ITPEffectsSubsystem] */
+	UPROPERTY(config)
+	TMap<EITPEffect, FITPEffectConfig> Effects;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UNiagaraSystem>> LoadedSystems;
+
+	TArray<FRequest> Pending;
+
+	/** Spawned instances per effect, to enforce MaxActive */
+	TArray<TWeakObjectPtr<UNiagaraComponent>> Active[(int32)EITPEffect::Num];
+
+	/** Running looping effects by owner */
+	TMap<TPair<TObjectKey<USceneComponent>, EITPEffect>, TWeakObjectPtr<UNiagaraComponent>> Looping;
+};
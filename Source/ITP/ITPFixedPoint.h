@@ -0,0 +1,58 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Q16.16 fixed point scalar for the deterministic kinematics mode.
+ * All arithmetic is integer, so results are bit-identical across compilers and CPUs.
+ * Range is +-32768 with 1/65536 resolution, enough for velocities and accelerations in cm/s.
+ */
+struct FITPFixed
+{
+	static constexpr int32 FractionBits = 16;
+	static constexpr int32 One = 1 << FractionBits;
+
+	int32 Raw = 0;
+
+	static constexpr FITPFixed FromRaw(int32 InRaw) { FITPFixed Result; Result.Raw = InRaw; return Result; }
+	static constexpr FITPFixed FromInt(int32 Value) { return FromRaw(Value * One); }
+
+	/** Only use at the engine boundary; scaling by a power of two and rounding is exact and deterministic */
+	static FITPFixed FromFloat(float Value) { return FromRaw((int32)FMath::RoundToInt32(Value * (float)One)); }
+	float ToFloat() const { return (float)Raw / (float)One; }
+
+	constexpr FITPFixed operator-() const { return FromRaw(-Raw); }
+	constexpr FITPFixed operator+(FITPFixed Other) const { return FromRaw(Raw + Other.Raw); }
+	constexpr FITPFixed operator-(FITPFixed Other) const { return FromRaw(Raw - Other.Raw); }
+	constexpr FITPFixed operator*(FITPFixed Other) const { return FromRaw((int32)(((int64)Raw * (int64)Other.Raw) >> FractionBits)); }
+	/** Scales by multiplying, since left shifting a negative value is undefined before C++20 */
+	constexpr FITPFixed operator/(FITPFixed Other) const { return FromRaw((int32)(((int64)Raw * (int64)One) / (int64)Other.Raw)); }
+
+	FITPFixed& operator+=(FITPFixed Other) { Raw += Other.Raw; return *this; }
+	FITPFixed& operator-=(FITPFixed Other) { Raw -= Other.Raw; return *this; }
+	FITPFixed& operator*=(FITPFixed Other) { return *this = *this * Other; }
+
+	constexpr bool operator==(FITPFixed Other) const { return Raw == Other.Raw; }
+	constexpr bool operator!=(FITPFixed Other) const { return Raw != Other.Raw; }
+	constexpr bool operator<(FITPFixed Other) const { return Raw < Other.Raw; }
+	constexpr bool operator>(FITPFixed Other) const { return Raw > Other.Raw; }
+	constexpr bool operator<=(FITPFixed Other) const { return Raw <= Other.Raw; }
+	constexpr bool operator>=(FITPFixed Other) const { return Raw >= Other.Raw; }
+};
+
+/** Conversions usable with either scalar type of the kinematic core */
+template<typename T> T ITPFromFloat(float Value);
+template<> FORCEINLINE float ITPFromFloat<float>(float Value) { return Value; }
+template<> FORCEINLINE FITPFixed ITPFromFloat<FITPFixed>(float Value) { return FITPFixed::FromFloat(Value); }
+
+FORCEINLINE float ITPToFloat(float Value) { return Value; }
+FORCEINLINE float ITPToFloat(FITPFixed Value) { return Value.ToFloat(); }
+
+/** Scalar of the ITP kinematic core, selected by ITP_FIXED_POINT_KINEMATICS in ITP.Build.cs */
+#if ITP_FIXED_POINT_KINEMATICS
+using FITPScalar = FITPFixed;
+#else
+using FITPScalar = float;
+#endif
@@ -0,0 +1,228 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPFrameGovernorSubsystem.h"
+#include "ITP.h"
+#include "Engine/World.h"
+#include "HAL/PlatformTime.h"
+#include "UnrealEngine.h"
+
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Governor Frame Ms"), STAT_ITPGovernorFrameMs, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Governor Significance Level"), STAT_ITPGovernorSignificance, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Governor Effects Level"), STAT_ITPGovernorEffects, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Governor Checksum Stride Level"), STAT_ITPGovernorChecksumStride, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Governor Animation Clock Level"), STAT_ITPGovernorAnimationClock, STATGROUP_ITP);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Governor Knob Changes"), STAT_ITPGovernorKnobChanges, STATGROUP_ITP);
+DECLARE_CYCLE_STAT(TEXT("Governor Synthetic Load"), STAT_ITPGovernorSyntheticLoad, STATGROUP_ITP);
+
+static float GITPGovernorTargetMs = 0.f;
+static FAutoConsoleVariableRef CVarITPGovernorTargetMs(
+	TEXT("ITP.Governor.TargetMs"),
+	GITPGovernorTargetMs,
+	TEXT("Game thread frame time the governor tries to hold, in ms. 0 = disabled, all knobs at full quality."));
+
+static float GITPGovernorHysteresis = 0.15f;
+static FAutoConsoleVariableRef CVarITPGovernorHysteresis(
+	TEXT("ITP.Governor.Hysteresis"),
+	GITPGovernorHysteresis,
+	TEXT("Fraction below the target the frame time must stay before quality is restored."));
+
+static int32 GITPGovernorCooldownFrames = 30;
+static FAutoConsoleVariableRef CVarITPGovernorCooldownFrames(
+	TEXT("ITP.Governor.CooldownFrames"),
+	GITPGovernorCooldownFrames,
+	TEXT("Frames after a knob change during which no further change is made."));
+
+static float GITPGovernorSyntheticLoadMs = 0.f;
+static FAutoConsoleVariableRef CVarITPGovernorSyntheticLoadMs(
+	TEXT("ITP.Governor.SyntheticLoadMs"),
+	GITPGovernorSyntheticLoadMs,
+	TEXT("Busy-waits this long per frame, booked as effects cost and scaled by the effects knob, so the governor can be exercised headless."));
+
+namespace ITPGovernor
+{
+	/** Frames the condition must hold before acting; restoring is deliberately slower than degrading */
+	constexpr int32 OverFramesToRaise = 10;
+	constexpr int32 UnderFramesToLower = 60;
+
+	constexpr float Smoothing = 0.1f;
+
+	static EITPGovernorKnob GetKnob(EITPGovernedSystem System)
+	{
+		switch (System)
+		{
+		case EITPGovernedSystem::AnimationLOD:
+			return EITPGovernorKnob::Significance;
+		case EITPGovernedSystem::Effects:
+			return EITPGovernorKnob::Effects;
+		case EITPGovernedSystem::Checksums:
+			return EITPGovernorKnob::ChecksumStride;
+		case EITPGovernedSystem::AnimationClock:
+			return EITPGovernorKnob::AnimationClockRate;
+		default:
+			return EITPGovernorKnob::Num;
+		}
+	}
+}
+
+void UITPFrameGovernorSubsystem::Tick(float DeltaTime)
+{
+	SpinSyntheticLoad();
+
+	// Costs gathered since the last governor tick, i.e. over one frame
+	for (int32 Index = 0; Index < (int32)EITPGovernedSystem::Num; ++Index)
+	{
+		const float CostMs = FPlatformTime::ToMilliseconds64(FrameCycles[Index]);
+		SmoothedCostMs[Index] = FMath::Lerp(SmoothedCostMs[Index], CostMs, ITPGovernor::Smoothing);
+		FrameCycles[Index] = 0;
+	}
+
+	const float FrameMs = GGameThreadTime > 0 ? FPlatformTime::ToMilliseconds(GGameThreadTime) : DeltaTime * 1000.f;
+	SmoothedFrameMs = SmoothedFrameMs > 0.f ? FMath::Lerp(SmoothedFrameMs, FrameMs, ITPGovernor::Smoothing) : FrameMs;
+	SET_FLOAT_STAT(STAT_ITPGovernorFrameMs, SmoothedFrameMs);
+
+	if (GITPGovernorTargetMs <= 0.f)
+	{
+		while (!Raised.IsEmpty())
+		{
+			const EITPGovernorKnob Knob = Raised.Pop();
+			SetKnob(Knob, 0);
+		}
+		return;
+	}
+
+	OverFrames = SmoothedFrameMs > GITPGovernorTargetMs ? OverFrames + 1 : 0;
+	UnderFrames = SmoothedFrameMs < GITPGovernorTargetMs * (1.f - GITPGovernorHysteresis) ? UnderFrames + 1 : 0;
+	if (CooldownFrames > 0)
+	{
+		--CooldownFrames;
+		return;
+	}
+
+	if (OverFrames >= ITPGovernor::OverFramesToRaise)
+	{
+		// Degrade whatever costs the most among the systems that can still give something up
+		EITPGovernorKnob Knob = EITPGovernorKnob::Num;
+		float HighestCost = -1.f;
+		for (int32 Index = 0; Index < (int32)EITPGovernedSystem::Num; ++Index)
+		{
+			const EITPGovernorKnob Candidate = ITPGovernor::GetKnob((EITPGovernedSystem)Index);
+			if (Candidate != EITPGovernorKnob::Num && KnobLevels[(int32)Candidate] < MaxKnobLevel && SmoothedCostMs[Index] > HighestCost)
+			{
+				Knob = Candidate;
+				HighestCost = SmoothedCostMs[Index];
+			}
+		}
+
+		if (Knob != EITPGovernorKnob::Num)
+		{
+			Raised.Add(Knob);
+			SetKnob(Knob, KnobLevels[(int32)Knob] + 1);
+		}
+	}
+	else if (UnderFrames >= ITPGovernor::UnderFramesToLower && !Raised.IsEmpty())
+	{
+		const EITPGovernorKnob Knob = Raised.Pop();
+		SetKnob(Knob, KnobLevels[(int32)Knob] - 1);
+	}
+}
+
+TStatId UITPFrameGovernorSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UITPFrameGovernorSubsystem, STATGROUP_ITP);
+}
+
+bool UITPFrameGovernorSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+int32 UITPFrameGovernorSubsystem::GetKnobLevel(const UWorld* World, EITPGovernorKnob Knob)
+{
+	const UITPFrameGovernorSubsystem* Governor = World ? World->GetSubsystem<UITPFrameGovernorSubsystem>() : nullptr;
+	return Governor ? Governor->GetKnobLevel(Knob) : 0;
+}
+
+float UITPFrameGovernorSubsystem::GetKnobScale(const UWorld* World, EITPGovernorKnob Knob)
+{
+	return 1.f - 0.25f * GetKnobLevel(World, Knob);
+}
+
+void UITPFrameGovernorSubsystem::SetKnob(EITPGovernorKnob Knob, int32 Level)
+{
+	const int32 OldLevel = KnobLevels[(int32)Knob];
+	KnobLevels[(int32)Knob] = FMath::Clamp(Level, 0, MaxKnobLevel);
+	if (KnobLevels[(int32)Knob] == OldLevel)
+	{
+		return;
+	}
+
+	CooldownFrames = GITPGovernorCooldownFrames;
+	OverFrames = 0;
+	UnderFrames = 0;
+
+	INC_DWORD_STAT(STAT_ITPGovernorKnobChanges);
+	SET_DWORD_STAT(STAT_ITPGovernorSignificance, KnobLevels[(int32)EITPGovernorKnob::Significance]);
+	SET_DWORD_STAT(STAT_ITPGovernorEffects, KnobLevels[(int32)EITPGovernorKnob::Effects]);
+	SET_DWORD_STAT(STAT_ITPGovernorChecksumStride, KnobLevels[(int32)EITPGovernorKnob::ChecksumStride]);
+	SET_DWORD_STAT(STAT_ITPGovernorAnimationClock, KnobLevels[(int32)EITPGovernorKnob::AnimationClockRate]);
+
+	static const TCHAR* KnobNames[] = { TEXT("Significance"), TEXT("Effects"), TEXT("ChecksumStride"), TEXT("AnimationClockRate") };
+	static_assert(UE_ARRAY_COUNT(KnobNames) == (int32)EITPGovernorKnob::Num, "Name every governor knob");
+	UE_LOG(LogITP, Log, TEXT("Governor: %s %d -> %d (frame %.2f ms, target %.2f ms)"),
+		KnobNames[(int32)Knob], OldLevel, KnobLevels[(int32)Knob], SmoothedFrameMs, GITPGovernorTargetMs);
+}
+
+void UITPFrameGovernorSubsystem::SpinSyntheticLoad()
+{
+	if (GITPGovernorSyntheticLoadMs <= 0.f)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ITPGovernorSyntheticLoad);
+	FITPGovernorScope Scope(GetWorld(), EITPGovernedSystem::Effects);
+
+	// Behaves like an effects workload: cheaper as the effects knob is turned
+	const double EndSeconds = FPlatformTime::Seconds() + GITPGovernorSyntheticLoadMs * GetKnobScale(GetWorld(), EITPGovernorKnob::Effects) / 1000.0;
+	while (FPlatformTime::Seconds() < EndSeconds)
+	{
+		FPlatformProcess::Yield();
+	}
+}
+
+FITPGovernorScope::FITPGovernorScope(const UWorld* World, EITPGovernedSystem InSystem)
+	: Governor(World ? World->GetSubsystem<UITPFrameGovernorSubsystem>() : nullptr)
+	, System(InSystem)
+	, StartCycles(Governor ? FPlatformTime::Cycles64() : 0)
+{
+}
+
+FITPGovernorScope::~FITPGovernorScope()
+{
+	if (Governor)
+	{
+		Governor->AddCost(System, FPlatformTime::Cycles64() - StartCycles);
+	}
+}
+
+static FAutoConsoleCommandWithWorld CmdITPGovernorReport(
+	TEXT("ITP.Governor.Report"),
+	TEXT("Logs the governor's smoothed frame time, per-system costs and knob levels."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		const UITPFrameGovernorSubsystem* Governor = World ? World->GetSubsystem<UITPFrameGovernorSubsystem>() : nullptr;
+		if (!Governor)
+		{
+			return;
+		}
+
+		UE_LOG(LogITP, Log, TEXT("Governor: frame %.2f ms, target %.2f ms"), Governor->GetSmoothedFrameMs(), GITPGovernorTargetMs);
+		static const TCHAR* SystemNames[] = { TEXT("Characters"), TEXT("Checksums"), TEXT("AnimationClock"), TEXT("AnimationLOD"), TEXT("Effects") };
+		for (int32 Index = 0; Index < (int32)EITPGovernedSystem::Num; ++Index)
+		{
+			UE_LOG(LogITP, Log, TEXT("  %-16s %.3f ms"), SystemNames[Index], Governor->GetSmoothedCostMs((EITPGovernedSystem)Index));
+		}
+		UE_LOG(LogITP, Log, TEXT("  Knobs: significance %d, effects %d, checksum stride %d, animation clock %d"),
+			Governor->GetKnobLevel(EITPGovernorKnob::Significance), Governor->GetKnobLevel(EITPGovernorKnob::Effects),
+			Governor->GetKnobLevel(EITPGovernorKnob::ChecksumStride), Governor->GetKnobLevel(EITPGovernorKnob::AnimationClockRate));
+	}));
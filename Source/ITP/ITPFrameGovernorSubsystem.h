@@ -0,0 +1,93 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ITPFrameGovernorSubsystem.generated.h"
+
+/** ITP systems whose game thread cost the governor measures */
+enum class EITPGovernedSystem : uint8
+{
+	Characters,
+	Checksums,
+	AnimationClock,
+	AnimationLOD,
+	Effects,
+	Num,
+};
+
+/** Quality knobs the governor turns, each from 0 (full quality) to MaxKnobLevel */
+enum class EITPGovernorKnob : uint8
+{
+	/** Pushes NPC animation one LOD tier coarser per level */
+	Significance,
+	/** Scales effect budgets and cull distances down by a quarter per level */
+	Effects,
+	/** Doubles the fixed steps between checksums per level, local and replicated */
+	ChecksumStride,
+	/** Doubles the frames between flipbook clock advances per level */
+	AnimationClockRate,
+	Num,
+};
+
+/**
+ * Holds the game thread near ITP.Governor.TargetMs by degrading the most expensive system first.
+ * Systems report their cost through FITPGovernorScope. When the smoothed frame time stays above target, the knob
+ * of the costliest system that still has headroom is raised; once it stays comfortably below target (by
+ * ITP.Governor.Hysteresis) the most recently raised knob is lowered again. Every change is followed by a cooldown
+ * so one adjustment can take effect before the next.
+ */
+UCLASS()
+class ITP_API UITPFrameGovernorSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static constexpr int32 MaxKnobLevel = 3;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	void AddCost(EITPGovernedSystem System, uint64 Cycles) { FrameCycles[(int32)System] += Cycles; }
+
+	int32 GetKnobLevel(EITPGovernorKnob Knob) const { return KnobLevels[(int32)Knob]; }
+
+	/** Knob level for World's governor, 0 when there is none */
+	static int32 GetKnobLevel(const UWorld* World, EITPGovernorKnob Knob);
+
+	/** 1 at level 0 down to 0.25 at MaxKnobLevel */
+	static float GetKnobScale(const UWorld* World, EITPGovernorKnob Knob);
+
+	float GetSmoothedFrameMs() const { return SmoothedFrameMs; }
+	float GetSmoothedCostMs(EITPGovernedSystem System) const { return SmoothedCostMs[(int32)System]; }
+
+private:
+	void SetKnob(EITPGovernorKnob Knob, int32 Level);
+	void SpinSyntheticLoad();
+
+	uint64 FrameCycles[(int32)EITPGovernedSystem::Num] = {};
+	float SmoothedCostMs[(int32)EITPGovernedSystem::Num] = {};
+	int32 KnobLevels[(int32)EITPGovernorKnob::Num] = {};
+
+	/** Raised knobs, most recent last; lowered in reverse order */
+	TArray<EITPGovernorKnob> Raised;
+
+	float SmoothedFrameMs = 0.f;
+	int32 OverFrames = 0;
+	int32 UnderFrames = 0;
+	int32 CooldownFrames = 0;
+};
+
+/** Attributes the game thread time of a scope to an ITP system */
+struct FITPGovernorScope
+{
+	FITPGovernorScope(const UWorld* World, EITPGovernedSystem InSystem);
+	~FITPGovernorScope();
+
+private:
+	UITPFrameGovernorSubsystem* Governor;
+	EITPGovernedSystem System;
+	uint64 StartCycles;
+};
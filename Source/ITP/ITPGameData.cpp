@@ -0,0 +1,107 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPGameData.h"
+#include "ITP.h"
+#include "UObject/ObjectSaveContext.h"
+
+#if WITH_EDITOR
+namespace ITPGameData
+{
+	/** Fixed handle rows first, in handle order, then every other row in table order */
+	template<typename RowType, int32 NumFixed>
+	bool BuildDense(const UDataTable* Table, const TCHAR* const (&FixedNames)[NumFixed], TArray<RowType>& OutRows, TArray<FName>& OutNames, const UObject* Owner)
+	{
+		OutRows.Reset();
+		OutNames.Reset();
+
+		if (!Table)
+		{
+			UE_LOG(LogITP, Error, TEXT("%s: source table for %s is not set"), *Owner->GetPathName(), *RowType::StaticStruct()->GetName());
+			return false;
+		}
+
+		if (Table->GetRowStruct() != RowType::StaticStruct())
+		{
+			UE_LOG(LogITP, Error, TEXT("%s: %s does not use %s rows"), *Owner->GetPathName(), *Table->GetPathName(), *RowType::StaticStruct()->GetName());
+			return false;
+		}
+
+		bool bSuccess = true;
+		for (const TCHAR* FixedName : FixedNames)
+		{
+			const FName RowName(FixedName);
+			const RowType* Row = Table->FindRow<RowType>(RowName, TEXT("ITP game data cook"), false);
+			if (!Row)
+			{
+				UE_LOG(LogITP, Error, TEXT("%s: %s is missing row '%s' required by its compile-time handle"), *Owner->GetPathName(), *Table->GetPathName(), FixedName);
+				bSuccess = false;
+				OutRows.AddDefaulted();
+			}
+			else
+			{
+				OutRows.Add(*Row);
+			}
+			OutNames.Add(RowName);
+		}
+
+		Table->ForeachRow<RowType>(TEXT("ITP game data cook"), [&OutRows, &OutNames](const FName& RowName, const RowType& Row)
+		{
+			if (!OutNames.Contains(RowName))
+			{
+				OutRows.Add(Row);
+				OutNames.Add(RowName);
+			}
+		});
+
+		if (OutRows.Num() >= MAX_uint16)
+		{
+			UE_LOG(LogITP, Error, TEXT("%s: %s has too many rows for 16 bit handles"), *Owner->GetPathName(), *Table->GetPathName());
+			bSuccess = false;
+		}
+		return bSuccess;
+	}
+}
+
+void UITPGameData::PreSave(FObjectPreSaveContext SaveContext)
+{
+	Super::PreSave(SaveContext);
+
+	// A failed rebuild logs errors, which fails the cook
+	Rebuild();
+}
+
+bool UITPGameData::Rebuild()
+{
+	bool bSuccess = ITPGameData::BuildDense(EnemyTable, ITPEnemies::FixedNames, Enemies, EnemyNames, this);
+	bSuccess &= ITPGameData::BuildDense(PowerUpTable, ITPPowerUps::FixedNames, PowerUps, PowerUpNames, this);
+	bSuccess &= ITPGameData::BuildDense(TileTable, ITPTiles::FixedNames, Tiles, TileNames, this);
+
+	int32 MaxTileId = 0;
+	for (const FITPTileRow& Tile : Tiles)
+	{
+		MaxTileId = FMath::Max(MaxTileId, Tile.TileId);
+	}
+
+	TileIdToRow.Init(ITPTiles::Empty.Index, FMath::Min(MaxTileId + 1, (int32)MAX_uint16));
+	for (int32 RowIndex = 0; RowIndex < Tiles.Num(); ++RowIndex)
+	{
+		if (TileIdToRow.IsValidIndex(Tiles[RowIndex].TileId))
+		{
+			TileIdToRow[Tiles[RowIndex].TileId] = (uint16)RowIndex;
+		}
+	}
+
+	return bSuccess;
+}
+#endif
+
+void UITPGameDataSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Data = GameDataAsset.LoadSynchronous();
+	if (!Data)
+	{
+		UE_LOG(LogITP, Warning, TEXT("No ITP game data asset configured in [/Script/ITP.ITPGameDataSubsystem]"));
+	}
+}
@@ -0,0 +1,215 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Engine/DataTable.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "ITPGameData.generated.h"
+
+/**
+ * Rows every ITP data table must contain, in handle order. Code refers to them through the constants below
+ * (ITPEnemies::Walker, ...), so a misspelt row is a compile error and a missing row fails the cook.
+ * Tables may contain more rows; those get handles after the fixed ones and are found with FindEnemy, FindPowerUp or FindTile.
+ */
+#define ITP_ENEMY_ROWS(X) X(Walker) X(Flyer) X(Spiker)
+#define ITP_POWERUP_ROWS(X) X(Mushroom) X(Feather) X(Star)
+#define ITP_TILE_ROWS(X) X(Empty) X(Ground) X(Brick) X(Breakable) X(Spikes)
+
+USTRUCT(BlueprintType)
+struct FITPEnemyRow : public FTableRowBase
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Enemy)
+	TSoftClassPtr<AActor> ActorClass;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Enemy)
+	float MoveSpeed = 150.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Enemy)
+	int32 Health = 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Enemy)
+	bool bStompable = true;
+};
+
+USTRUCT(BlueprintType)
+struct FITPPowerUpRow : public FTableRowBase
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = PowerUp)
+	TSoftClassPtr<AActor> ActorClass;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = PowerUp)
+	float Duration = 0.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = PowerUp)
+	int32 ScoreValue = 100;
+};
+
+USTRUCT(BlueprintType)
+struct FITPTileRow : public FTableRowBase
+{
+	GENERATED_BODY()
+
+	/** Tile id in cooked level chunks (the Tiled gid) */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Tile)
+	int32 TileId = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Tile)
+	bool bSolid = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Tile)
+	bool bBreakable = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Tile)
+	bool bHazard = false;
+};
+
+/** Dense index into one cooked table. Typed so enemy handles cannot index the tile array. */
+template<typename RowType>
+struct TITPHandle
+{
+	uint16 Index = MAX_uint16;
+
+	constexpr TITPHandle() = default;
+	constexpr explicit TITPHandle(uint16 InIndex) : Index(InIndex) {}
+
+	constexpr bool IsValid() const { return Index != MAX_uint16; }
+	constexpr bool operator==(TITPHandle Other) const { return Index == Other.Index; }
+	constexpr bool operator!=(TITPHandle Other) const { return Index != Other.Index; }
+};
+
+#define ITP_DECLARE_ROW_INDEX(Name) Name,
+#define ITP_DECLARE_ROW_NAME(Name) TEXT(#Name),
+
+#define ITP_DECLARE_HANDLES(Namespace, Rows) \
+	namespace Namespace \
+	{ \
+		enum class EIndex : uint16 { Rows(ITP_DECLARE_ROW_INDEX) Num }; \
+		inline constexpr int32 NumFixed = (int32)EIndex::Num; \
+		inline const TCHAR* const FixedNames[] = { Rows(ITP_DECLARE_ROW_NAME) }; \
+	}
+
+ITP_DECLARE_HANDLES(ITPEnemies, ITP_ENEMY_ROWS)
+ITP_DECLARE_HANDLES(ITPPowerUps, ITP_POWERUP_ROWS)
+ITP_DECLARE_HANDLES(ITPTiles, ITP_TILE_ROWS)
+
+#define ITP_DECLARE_ENEMY_HANDLE(Name) inline constexpr TITPHandle<FITPEnemyRow> Name((uint16)EIndex::Name);
+#define ITP_DECLARE_POWERUP_HANDLE(Name) inline constexpr TITPHandle<FITPPowerUpRow> Name((uint16)EIndex::Name);
+#define ITP_DECLARE_TILE_HANDLE(Name) inline constexpr TITPHandle<FITPTileRow> Name((uint16)EIndex::Name);
+
+namespace ITPEnemies { ITP_ENEMY_ROWS(ITP_DECLARE_ENEMY_HANDLE) }
+namespace ITPPowerUps { ITP_POWERUP_ROWS(ITP_DECLARE_POWERUP_HANDLE) }
+namespace ITPTiles { ITP_TILE_ROWS(ITP_DECLARE_TILE_HANDLE) }
+
+/**
+ * Cooked form of the ITP data tables: plain arrays indexed by TITPHandle.
+ * Rebuilt from the source tables whenever the asset is saved (and therefore when it is cooked).
+ */
+UCLASS()
+class ITP_API UITPGameData : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	/** Invalid handles, and any handle into an asset whose Rebuild failed, get a default row */
+	FORCEINLINE const FITPEnemyRow& Get(TITPHandle<FITPEnemyRow> Handle) const { return GetRow(Enemies, Handle.Index); }
+	FORCEINLINE const FITPPowerUpRow& Get(TITPHandle<FITPPowerUpRow> Handle) const { return GetRow(PowerUps, Handle.Index); }
+	FORCEINLINE const FITPTileRow& Get(TITPHandle<FITPTileRow> Handle) const { return GetRow(Tiles, Handle.Index); }
+
+	/** Tile row for a tile id from a level chunk; ids without a row map to ITPTiles::Empty */
+	FORCEINLINE const FITPTileRow& GetTileById(uint16 TileId) const
+	{
+		return GetRow(Tiles, TileIdToRow.IsValidIndex(TileId) ? TileIdToRow[TileId] : ITPTiles::Empty.Index);
+	}
+
+	/** Whether TileId is empty or has its own row, for validating untrusted level data */
+	FORCEINLINE bool IsKnownTileId(uint16 TileId) const
+	{
+		return TileId == 0 || (TileIdToRow.IsValidIndex(TileId) && Tiles.IsValidIndex(TileIdToRow[TileId]) && Tiles[TileIdToRow[TileId]].TileId == TileId);
+	}
+
+	/** Name lookup for rows without a compile-time handle; invalid if there is no such row. Not for hot paths. */
+	TITPHandle<FITPEnemyRow> FindEnemy(FName RowName) const { return FindHandle<FITPEnemyRow>(EnemyNames, RowName); }
+	TITPHandle<FITPPowerUpRow> FindPowerUp(FName RowName) const { return FindHandle<FITPPowerUpRow>(PowerUpNames, RowName); }
+	TITPHandle<FITPTileRow> FindTile(FName RowName) const { return FindHandle<FITPTileRow>(TileNames, RowName); }
+
+#if WITH_EDITOR
+	virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+
+	/** Rebuilds the dense arrays. Returns false (and logs) if a fixed handle row is missing. */
+	bool Rebuild();
+#endif
+
+#if WITH_EDITORONLY_DATA
+	UPROPERTY(EditAnywhere, Category = Source, meta = (RequiredAssetDataTags = "RowStructure=/Script/ITP.ITPEnemyRow"))
+	TObjectPtr<UDataTable> EnemyTable;
+
+	UPROPERTY(EditAnywhere, Category = Source, meta = (RequiredAssetDataTags = "RowStructure=/Script/ITP.ITPPowerUpRow"))
+	TObjectPtr<UDataTable> PowerUpTable;
+
+	UPROPERTY(EditAnywhere, Category = Source, meta = (RequiredAssetDataTags = "RowStructure=/Script/ITP.ITPTileRow"))
+	TObjectPtr<UDataTable> TileTable;
+#endif
+
+private:
+	template<typename RowType>
+	static FORCEINLINE const RowType& GetRow(const TArray<RowType>& Rows, int32 Index)
+	{
+		static const RowType DefaultRow;
+		return Rows.IsValidIndex(Index) ? Rows[Index] : DefaultRow;
+	}
+
+	template<typename RowType>
+	static TITPHandle<RowType> FindHandle(const TArray<FName>& Names, FName RowName)
+	{
+		const int32 Index = Names.IndexOfByKey(RowName);
+		return Index != INDEX_NONE ? TITPHandle<RowType>((uint16)Index) : TITPHandle<RowType>();
+	}
+
+	UPROPERTY()
+	TArray<FITPEnemyRow> Enemies;
+
+	UPROPERTY()
+	TArray<FITPPowerUpRow> PowerUps;
+
+	UPROPERTY()
+	TArray<FITPTileRow> Tiles;
+
+	UPROPERTY()
+	TArray<FName> EnemyNames;
+
+	UPROPERTY()
+	TArray<FName> PowerUpNames;
+
+	UPROPERTY()
+	TArray<FName> TileNames;
+
+	/** Dense tile id -> row index table */
+	UPROPERTY()
+	TArray<uint16> TileIdToRow;
+};
+
+/** Loads the cooked game data once and hands it out to gameplay code */
+UCLASS(config = Game)
+class ITP_API UITPGameDataSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	const UITPGameData* GetData() const { return Data.Get(); }
+
+private:
+	/** Set in DefaultGame.ini under [/Script/ITP.ITPGameDataSubsystem] */
+	UPROPERTY(config)
+	TSoftObjectPtr<UITPGameData> GameDataAsset;
+
+	UPROPERTY()
+	TObjectPtr<UITPGameData> Data;
+};
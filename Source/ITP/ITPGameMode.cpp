@@ -2,6 +2,12 @@
 
 #include "ITPGameMode.h"
 #include "ITPCharacter.h"
+#include "ITPGameState.h"
+#include "ITPLevelStateSubsystem.h"
+#include "ITPPlayerController.h"
+#include "ITPRandomSubsystem.h"
+#include "Engine/GameInstance.h"
+#include "Kismet/GameplayStatics.h"
 #include "UObject/ConstructorHelpers.h"
 
 AITPGameMode::AITPGameMode()
@@ -12,4 +18,48 @@ AITPGameMode::AITPGameMode()
 	{
 		DefaultPawnClass = PlayerPawnBPClass.Class;
 	}
+
+	GameStateClass = AITPGameState::StaticClass();
+	PlayerControllerClass = AITPPlayerController::StaticClass();
+}
+
+void AITPGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	UITPRandomSubsystem* Random = UGameInstance::GetSubsystem<UITPRandomSubsystem>(GetGameInstance());
+	if (!Random)
+	{
+		return;
+	}
+
+	const FString SeedOption = UGameplayStatics::ParseOption(Options, TEXT("RunSeed"));
+	const FString LoadOption = UGameplayStatics::ParseOption(Options, TEXT("LoadRun"));
+
+	if (!SeedOption.IsEmpty())
+	{
+		Random->StartRun(FCString::Strtoui64(*SeedOption, nullptr, 10));
+	}
+	else if (LoadOption.IsEmpty() || !Random->LoadRun(LoadOption))
+	{
+		Random->StartNewRun();
+	}
+
+	// The game state is spawned before InitGame runs, so it only learns the seed now
+	if (AITPGameState* ITPGameState = GetGameState<AITPGameState>())
+	{
+		ITPGameState->SetRunSeed(Random->GetRunSeed());
+	}
+}
+
+void AITPGameMode::PostLogin(APlayerController* NewPlayer)
+{
+	Super::PostLogin(NewPlayer);
+
+	AITPPlayerController* PlayerController = Cast<AITPPlayerController>(NewPlayer);
+	UITPLevelStateSubsystem* LevelState = GetWorld()->GetSubsystem<UITPLevelStateSubsystem>();
+	if (PlayerController && LevelState && !PlayerController->IsLocalController())
+	{
+		LevelState->SendSnapshot(PlayerController);
+	}
 }
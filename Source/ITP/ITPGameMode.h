@@ -13,6 +13,12 @@ class AITPGameMode : public AGameModeBase
 
 public:
 	AITPGameMode();
+
+	/** Picks the run seed from ?RunSeed=, ?LoadRun=<Slot>, or a fresh roll */
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+
+	/** Sends the joining player the level state: broken tiles and collected coins */
+	virtual void PostLogin(APlayerController* NewPlayer) override;
 };
 
 
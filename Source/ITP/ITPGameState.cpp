@@ -0,0 +1,31 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPGameState.h"
+#include "ITPRandomSubsystem.h"
+#include "Engine/GameInstance.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "Net/UnrealNetwork.h"
+
+void AITPGameState::SetRunSeed(uint64 InRunSeed)
+{
+	RunSeed = InRunSeed;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AITPGameState, RunSeed, this);
+}
+
+void AITPGameState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// Push-model: marked dirty where it is written, so the server never diffs it per connection
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AITPGameState, RunSeed, Params);
+}
+
+void AITPGameState::OnRep_RunSeed()
+{
+	if (UITPRandomSubsystem* Random = UGameInstance::GetSubsystem<UITPRandomSubsystem>(GetGameInstance()))
+	{
+		Random->StartRun(RunSeed);
+	}
+}
@@ -0,0 +1,27 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameStateBase.h"
+#include "ITPGameState.generated.h"
+
+UCLASS()
+class AITPGameState : public AGameStateBase
+{
+	GENERATED_BODY()
+
+public:
+	/** Server: set by AITPGameMode once InitGame has picked the seed */
+	void SetRunSeed(uint64 InRunSeed);
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+private:
+	/** Seed of the current run, so clients and replays generate the same content */
+	UPROPERTY(ReplicatedUsing = OnRep_RunSeed)
+	uint64 RunSeed = 0;
+
+	UFUNCTION()
+	void OnRep_RunSeed();
+};
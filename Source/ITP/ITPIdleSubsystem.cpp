@@ -0,0 +1,176 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPIdleSubsystem.h"
+#include "ITP.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "Framework/Application/SlateApplication.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Idle"), STAT_ITPIdle, STATGROUP_ITP);
+
+static float GITPIdleMaxFPS = 30.f;
+static FAutoConsoleVariableRef CVarITPIdleMaxFPS(
+	TEXT("ITP.Idle.MaxFPS"),
+	GITPIdleMaxFPS,
+	TEXT("Frame rate cap while a menu is open or the window is unfocused."));
+
+static int32 GITPIdleWhenUnfocused = 1;
+static FAutoConsoleVariableRef CVarITPIdleWhenUnfocused(
+	TEXT("ITP.Idle.WhenUnfocused"),
+	GITPIdleWhenUnfocused,
+	TEXT("1 = enter idle mode while the game window is in the background."));
+
+static FString GITPIdleStreamingCVars = TEXT("s.AsyncLoadingTimeLimit=1,s.PriorityAsyncLoadingExtraTime=0,r.Streaming.FramesForFullUpdate=15");
+static FAutoConsoleVariableRef CVarITPIdleStreamingCVars(
+	TEXT("ITP.Idle.StreamingCVars"),
+	GITPIdleStreamingCVars,
+	TEXT("Comma separated name=value console variables applied while idle to keep background streaming from competing for the frame."));
+
+const FName UITPIdleSubsystem::MenuReason(TEXT("Menu"));
+const FName UITPIdleSubsystem::UnfocusedReason(TEXT("Unfocused"));
+
+void UITPIdleSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (FSlateApplication::IsInitialized())
+	{
+		ActivationHandle = FSlateApplication::Get().OnApplicationActivationStateChanged().AddUObject(this, &UITPIdleSubsystem::OnActivationChanged);
+	}
+
+	SampleHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UITPIdleSubsystem::SampleCPU), 1.f);
+}
+
+void UITPIdleSubsystem::Deinitialize()
+{
+	if (IsIdle())
+	{
+		LeaveIdle();
+	}
+
+	if (FSlateApplication::IsInitialized())
+	{
+		FSlateApplication::Get().OnApplicationActivationStateChanged().Remove(ActivationHandle);
+	}
+	FTSTicker::GetCoreTicker().RemoveTicker(SampleHandle);
+
+	Super::Deinitialize();
+}
+
+void UITPIdleSubsystem::PushIdleReason(FName Reason)
+{
+	++Reasons.FindOrAdd(Reason);
+	if (ReasonCount++ == 0)
+	{
+		EnterIdle();
+	}
+}
+
+void UITPIdleSubsystem::PopIdleReason(FName Reason)
+{
+	int32* Count = Reasons.Find(Reason);
+	if (!Count)
+	{
+		return;
+	}
+
+	if (--*Count == 0)
+	{
+		Reasons.Remove(Reason);
+	}
+	if (--ReasonCount == 0)
+	{
+		LeaveIdle();
+	}
+}
+
+bool UITPIdleSubsystem::IsSuspended(const UWorld* World)
+{
+	const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+	const UITPIdleSubsystem* Idle = GameInstance ? GameInstance->GetSubsystem<UITPIdleSubsystem>() : nullptr;
+	return Idle && Idle->IsIdle();
+}
+
+void UITPIdleSubsystem::EnterIdle()
+{
+	UE_LOG(LogITP, Log, TEXT("Entering idle mode (active CPU %.1f%%)"), ActiveCPUPercent);
+	SET_DWORD_STAT(STAT_ITPIdle, 1);
+
+	SavedMaxFPS = GEngine->GetMaxFPS();
+	GEngine->SetMaxFPS(SavedMaxFPS > 0.f ? FMath::Min(SavedMaxFPS, GITPIdleMaxFPS) : GITPIdleMaxFPS);
+
+	TArray<FString> Assignments;
+	GITPIdleStreamingCVars.ParseIntoArray(Assignments, TEXT(","));
+	for (const FString& Assignment : Assignments)
+	{
+		FString Name, Value;
+		if (Assignment.TrimStartAndEnd().Split(TEXT("="), &Name, &Value))
+		{
+			if (IConsoleVariable* CVar = IConsoleManager::Get().FindConsoleVariable(*Name))
+			{
+				SavedCVars.Add(Name, CVar->GetString());
+				CVar->Set(*Value, ECVF_SetByCode);
+			}
+		}
+	}
+}
+
+void UITPIdleSubsystem::LeaveIdle()
+{
+	GEngine->SetMaxFPS(SavedMaxFPS);
+
+	for (const TPair<FString, FString>& Pair : SavedCVars)
+	{
+		if (IConsoleVariable* CVar = IConsoleManager::Get().FindConsoleVariable(*Pair.Key))
+		{
+			CVar->Set(*Pair.Value, ECVF_SetByCode);
+		}
+	}
+	SavedCVars.Reset();
+
+	SET_DWORD_STAT(STAT_ITPIdle, 0);
+	UE_LOG(LogITP, Log, TEXT("Leaving idle mode (idle CPU %.1f%%)"), IdleCPUPercent);
+}
+
+void UITPIdleSubsystem::OnActivationChanged(bool bActive)
+{
+	if (!GITPIdleWhenUnfocused)
+	{
+		return;
+	}
+
+	const bool bHeld = Reasons.Contains(UnfocusedReason);
+	if (!bActive && !bHeld)
+	{
+		PushIdleReason(UnfocusedReason);
+	}
+	else if (bActive && bHeld)
+	{
+		PopIdleReason(UnfocusedReason);
+	}
+}
+
+bool UITPIdleSubsystem::SampleCPU(float DeltaTime)
+{
+	// Attributed to whichever mode the game is in when sampled
+	const float CPUPercent = FPlatformTime::GetCPUTime().CPUTimePctRelative;
+	float& Average = IsIdle() ? IdleCPUPercent : ActiveCPUPercent;
+	Average = Average > 0.f ? FMath::Lerp(Average, CPUPercent, 0.2f) : CPUPercent;
+	return true;
+}
+
+static FAutoConsoleCommandWithWorld CmdITPIdleReport(
+	TEXT("ITP.Idle.Report"),
+	TEXT("Logs smoothed CPU usage measured while idle (menus, unfocused) and while playing."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+		if (const UITPIdleSubsystem* Idle = GameInstance ? GameInstance->GetSubsystem<UITPIdleSubsystem>() : nullptr)
+		{
+			UE_LOG(LogITP, Log, TEXT("CPU: %.1f%% active, %.1f%% idle (currently %s)"),
+				Idle->GetActiveCPUPercent(), Idle->GetIdleCPUPercent(), Idle->IsIdle() ? TEXT("idle") : TEXT("active"));
+		}
+	}));
@@ -0,0 +1,63 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "ITPIdleSubsystem.generated.h"
+
+/**
+ * Idle policy for menus and an unfocused window.
+ * While any idle reason is held the frame rate is capped, cosmetic ITP subsystems stop ticking (see IsSuspended)
+ * and async loading and texture streaming get a smaller share of each frame. Everything is restored in the same
+ * call that drops the last reason, so gameplay is back at full rate on the next frame.
+ */
+UCLASS()
+class ITP_API UITPIdleSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static const FName MenuReason;
+	static const FName UnfocusedReason;
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Reasons nest by count, e.g. a menu opened from another menu */
+	UFUNCTION(BlueprintCallable, Category = Idle)
+	void PushIdleReason(FName Reason);
+
+	UFUNCTION(BlueprintCallable, Category = Idle)
+	void PopIdleReason(FName Reason);
+
+	UFUNCTION(BlueprintPure, Category = Idle)
+	bool IsIdle() const { return ReasonCount > 0; }
+
+	/** True when ITP subsystems in World's game instance should skip their tick */
+	static bool IsSuspended(const UWorld* World);
+
+	/** Smoothed process CPU usage in percent of one core, while idle and while active */
+	float GetIdleCPUPercent() const { return IdleCPUPercent; }
+	float GetActiveCPUPercent() const { return ActiveCPUPercent; }
+
+private:
+	void EnterIdle();
+	void LeaveIdle();
+	void OnActivationChanged(bool bActive);
+	bool SampleCPU(float DeltaTime);
+
+	TMap<FName, int32> Reasons;
+	int32 ReasonCount = 0;
+
+	/** Values replaced while idle, restored on leave */
+	float SavedMaxFPS = 0.f;
+	TMap<FString, FString> SavedCVars;
+
+	FDelegateHandle ActivationHandle;
+	FTSTicker::FDelegateHandle SampleHandle;
+
+	float IdleCPUPercent = 0.f;
+	float ActiveCPUPercent = 0.f;
+};
@@ -0,0 +1,331 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPKinematics.h"
+#include "ITP.h"
+#include "ITPChecksumSubsystem.h"
+#include "ITPMover.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Misc/ScopeLock.h"
+
+static float GITPFixedStepHz = 60.f;
+static FAutoConsoleVariableRef CVarITPFixedStepHz(
+	TEXT("ITP.Movement.FixedStepHz"),
+	GITPFixedStepHz,
+	TEXT("Rate of the game thread fixed step for ITP simulation (character kinematics when async physics is off, checksums)."),
+	ECVF_Default);
+
+namespace ITPKinematics
+{
+	float GetFixedDeltaSeconds()
+	{
+		return 1.f / FMath::Max(GITPFixedStepHz, 1.f);
+	}
+
+	void StepGlide(FITPGlideState& State, FITPScalar DescendingRate, FITPScalar DeltaSeconds)
+	{
+		State.bForceVelocityY = false;
+
+		if (State.VelocityY != -DescendingRate && State.bIsGliding)
+		{
+			State.VelocityY = EaseInOut3(State.VelocityY, DescendingRate, DeltaSeconds);
+			State.bForceVelocityY = true;
+			State.ForcedVelocityY = -DescendingRate;
+		}
+	}
+
+	FITPGlideState Interpolate(const FITPGlideState& From, const FITPGlideState& To, float Alpha)
+	{
+		// Presentation only, so blending through float is fine in fixed point mode
+		FITPGlideState Result = To;
+		Result.VelocityY = ITPFromFloat<FITPScalar>(FMath::Lerp(ITPToFloat(From.VelocityY), ITPToFloat(To.VelocityY), Alpha));
+		return Result;
+	}
+}
+
+void FITPFixedStepSimulation::SetInput(bool bIsGliding, float EntryVelocityY, float DescendingRate)
+{
+	FScopeLock ScopeLock(&Lock);
+	Input.bIsGliding = bIsGliding;
+	Input.EntryVelocityY = ITPFromFloat<FITPScalar>(EntryVelocityY);
+	Input.DescendingRate = ITPFromFloat<FITPScalar>(DescendingRate);
+	++Input.Serial;
+}
+
+void FITPFixedStepSimulation::AdvanceGameThread(float DeltaSeconds, float FixedDeltaSeconds)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	Accumulator += DeltaSeconds;
+	while (Accumulator >= FixedDeltaSeconds)
+	{
+		Step_AssumesLocked(FixedDeltaSeconds);
+		Accumulator -= FixedDeltaSeconds;
+	}
+	Alpha = Accumulator / FixedDeltaSeconds;
+}
+
+void FITPFixedStepSimulation::AdvanceAsyncReadback(float DeltaSeconds, float FixedDeltaSeconds)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (NumSteps != LastSeenStep)
+	{
+		LastSeenStep = NumSteps;
+		Accumulator = 0.f;
+	}
+	Accumulator += DeltaSeconds;
+	Alpha = FMath::Min(Accumulator / FixedDeltaSeconds, 1.f);
+}
+
+FITPGlideState FITPFixedStepSimulation::GetInterpolated() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return ITPKinematics::Interpolate(PrevResult.Glide, CurrResult.Glide, Alpha);
+}
+
+void FITPFixedStepSimulation::AsyncStep(float FixedDeltaSeconds)
+{
+	FScopeLock ScopeLock(&Lock);
+	Step_AssumesLocked(FixedDeltaSeconds);
+}
+
+void FITPFixedStepSimulation::Step_AssumesLocked(float FixedDeltaSeconds)
+{
+	if (ConsumedInputSerial != Input.Serial)
+	{
+		if (Input.bIsGliding && !SimState.Glide.bIsGliding)
+		{
+			SimState.Glide.VelocityY = Input.EntryVelocityY;
+		}
+		SimState.Glide.bIsGliding = Input.bIsGliding;
+		ConsumedInputSerial = Input.Serial;
+	}
+
+	FITPMoverParams Params;
+	Params.DescendingRate = Input.DescendingRate;
+	FITPPlayerMover::Step(SimState, Params, FITPMoverContext(), ITPFromFloat<FITPScalar>(FixedDeltaSeconds));
+
+	PrevResult = CurrResult;
+	CurrResult = SimState;
+	++NumSteps;
+}
+
+/**
+ * Runs Count headless glide simulations for Frames render frames at FrameHz, once with the fixed-step driver on the
+ * game thread, once with the async readback (steps timed separately, as the physics thread would run them) and once
+ * with the old per-frame step, and logs the game thread ms per frame of each. The glide velocity after one second at
+ * 30 and 144 Hz is logged too: the fixed-step paths must agree across frame rates, the per-frame path does not.
+ */
+static FAutoConsoleCommand CmdITPMovementBenchmark(
+	TEXT("ITP.Movement.Benchmark"),
+	TEXT("ITP.Movement.Benchmark [Count=200] [Frames=1000] [FrameHz=144]: game thread cost of fixed-step vs per-frame glide kinematics for Count headless characters."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 Count = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 200;
+		const int32 Frames = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 1000;
+		const float FrameHz = Args.Num() > 2 ? FMath::Max(FCString::Atof(*Args[2]), 1.f) : 144.f;
+		const float FixedDeltaSeconds = ITPKinematics::GetFixedDeltaSeconds();
+		constexpr float DescendingRate = 300.f;
+
+		// Frame times jitter by +-20% around FrameHz, as a real frame loop does
+		FRandomStream Random(Count);
+		TArray<float> FrameTimes;
+		for (int32 Frame = 0; Frame < Frames; ++Frame)
+		{
+			FrameTimes.Add(Random.FRandRange(0.8f, 1.2f) / FrameHz);
+		}
+
+		// Characters glide in and out at staggered frames, so SetInput and entry velocities are part of the cost
+		const auto UpdateInput = [Count](TArray<FITPFixedStepSimulation>& Simulations, int32 Frame)
+		{
+			for (int32 Index = Frame % 60; Index < Count; Index += 60)
+			{
+				Simulations[Index].SetInput((Frame / 60 + Index) % 2 == 0, -200.f - Index % 400, DescendingRate);
+			}
+		};
+
+		uint64 FixedCycles = 0;
+		uint64 ReadbackCycles = 0;
+		uint64 AsyncStepCycles = 0;
+		uint64 PerFrameCycles = 0;
+		float Sink = 0.f;
+		{
+			TArray<FITPFixedStepSimulation> Simulations;
+			Simulations.SetNum(Count);
+			for (int32 Frame = 0; Frame < Frames; ++Frame)
+			{
+				UpdateInput(Simulations, Frame);
+				const uint64 StartCycles = FPlatformTime::Cycles64();
+				for (FITPFixedStepSimulation& Simulation : Simulations)
+				{
+					Simulation.AdvanceGameThread(FrameTimes[Frame], FixedDeltaSeconds);
+					Sink += ITPToFloat(Simulation.GetInterpolated().VelocityY);
+				}
+				FixedCycles += FPlatformTime::Cycles64() - StartCycles;
+			}
+		}
+		{
+			TArray<FITPFixedStepSimulation> Simulations;
+			Simulations.SetNum(Count);
+			float Accumulator = 0.f;
+			for (int32 Frame = 0; Frame < Frames; ++Frame)
+			{
+				UpdateInput(Simulations, Frame);
+
+				// Stands in for the async physics tick; its cost leaves the game thread
+				const uint64 StepStartCycles = FPlatformTime::Cycles64();
+				for (Accumulator += FrameTimes[Frame]; Accumulator >= FixedDeltaSeconds; Accumulator -= FixedDeltaSeconds)
+				{
+					for (FITPFixedStepSimulation& Simulation : Simulations)
+					{
+						Simulation.AsyncStep(FixedDeltaSeconds);
+					}
+				}
+				AsyncStepCycles += FPlatformTime::Cycles64() - StepStartCycles;
+
+				const uint64 StartCycles = FPlatformTime::Cycles64();
+				for (FITPFixedStepSimulation& Simulation : Simulations)
+				{
+					Simulation.AdvanceAsyncReadback(FrameTimes[Frame], FixedDeltaSeconds);
+					Sink += ITPToFloat(Simulation.GetInterpolated().VelocityY);
+				}
+				ReadbackCycles += FPlatformTime::Cycles64() - StartCycles;
+			}
+		}
+		{
+			TArray<FITPGlideState> States;
+			States.SetNum(Count);
+			for (int32 Frame = 0; Frame < Frames; ++Frame)
+			{
+				for (int32 Index = Frame % 60; Index < Count; Index += 60)
+				{
+					States[Index].bIsGliding = (Frame / 60 + Index) % 2 == 0;
+					States[Index].VelocityY = ITPFromFloat<FITPScalar>(-200.f - Index % 400);
+				}
+				const uint64 StartCycles = FPlatformTime::Cycles64();
+				for (FITPGlideState& State : States)
+				{
+					ITPKinematics::StepGlide(State, ITPFromFloat<FITPScalar>(DescendingRate), ITPFromFloat<FITPScalar>(FrameTimes[Frame]));
+					Sink += ITPToFloat(State.VelocityY);
+				}
+				PerFrameCycles += FPlatformTime::Cycles64() - StartCycles;
+			}
+		}
+
+		// One second of gliding from the same entry velocity at two frame rates
+		float FixedVelocity[2];
+		float PerFrameVelocity[2];
+		const float TestHz[2] = { 30.f, 144.f };
+		for (int32 Rate = 0; Rate < 2; ++Rate)
+		{
+			FITPFixedStepSimulation Simulation;
+			Simulation.SetInput(true, -200.f, DescendingRate);
+			FITPGlideState State;
+			State.bIsGliding = true;
+			State.VelocityY = ITPFromFloat<FITPScalar>(-200.f);
+			for (int32 Frame = 0; Frame < (int32)TestHz[Rate]; ++Frame)
+			{
+				Simulation.AdvanceGameThread(1.f / TestHz[Rate], FixedDeltaSeconds);
+				ITPKinematics::StepGlide(State, ITPFromFloat<FITPScalar>(DescendingRate), ITPFromFloat<FITPScalar>(1.f / TestHz[Rate]));
+			}
+			FixedVelocity[Rate] = ITPToFloat(Simulation.GetInterpolated().VelocityY);
+			PerFrameVelocity[Rate] = ITPToFloat(State.VelocityY);
+		}
+
+		const auto MsPerFrame = [Frames](uint64 Cycles) { return FPlatformTime::ToMilliseconds64(Cycles) / Frames; };
+		UE_LOG(LogITP, Log, TEXT("Glide kinematics, %d characters, %d frames at %.0f Hz, fixed step %.0f Hz: game thread ms/frame fixed step %.4f, async readback %.4f (+%.4f on the physics thread), per frame %.4f"),
+			Count, Frames, FrameHz, 1.f / FixedDeltaSeconds, MsPerFrame(FixedCycles), MsPerFrame(ReadbackCycles), MsPerFrame(AsyncStepCycles), MsPerFrame(PerFrameCycles));
+		UE_LOG(LogITP, Log, TEXT("Glide velocity after 1 s at 30 / 144 Hz: fixed step %.2f / %.2f, per frame %.2f / %.2f (checksum %.1f)"),
+			FixedVelocity[0], FixedVelocity[1], PerFrameVelocity[0], PerFrameVelocity[1], Sink);
+	}));
+
+namespace ITPKinematicsTest
+{
+	static void AddScalar(FITPChecksumBuilder& Builder, float Value) { Builder.Add(Value); }
+	static void AddScalar(FITPChecksumBuilder& Builder, FITPFixed Value) { Builder.Add(Value.Raw); }
+
+	/** Gravity, air control and the eased glide descent in T, as one fixed step of the kinematic core does them */
+	template<typename T>
+	static T StepScalars(T& VelocityX, T& VelocityY, T Input, T DeltaSeconds)
+	{
+		VelocityY = ITPKinematics::ApplyGravity(VelocityY, ITPFromFloat<T>(-980.f), ITPFromFloat<T>(1.f), DeltaSeconds);
+		VelocityX = ITPKinematics::ApplyAirControl(VelocityX, Input, ITPFromFloat<T>(500.f), ITPFromFloat<T>(2048.f), ITPFromFloat<T>(0.35f), DeltaSeconds);
+		VelocityY = ITPKinematics::EaseInOut3(VelocityY, ITPFromFloat<T>(300.f), DeltaSeconds);
+
+		// Jump again before the fall leaves the fixed point range
+		if (VelocityY < ITPFromFloat<T>(-2000.f))
+		{
+			VelocityY = ITPKinematics::Jump(VelocityY, ITPFromFloat<T>(700.f));
+		}
+		return VelocityX + VelocityY;
+	}
+
+	template<typename T>
+	static double TimeScalars(int32 Steps, T& OutSink)
+	{
+		T VelocityX = ITPFromFloat<T>(0.f);
+		T VelocityY = ITPFromFloat<T>(0.f);
+		T Sink = ITPFromFloat<T>(0.f);
+		const T DeltaSeconds = ITPFromFloat<T>(1.f / 60.f);
+
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		for (int32 Step = 0; Step < Steps; ++Step)
+		{
+			Sink = StepScalars(VelocityX, VelocityY, ITPFromFloat<T>(Step % 120 < 60 ? 1.f : -1.f), DeltaSeconds);
+		}
+		OutSink = Sink;
+		return FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles) * 1.0e6 / Steps;
+	}
+
+	/**
+	 * Steps a scripted run (alternating input, jumps, glides in and out) through the kinematic core in the build's
+	 * scalar and logs a checksum of every state. With ITP_FIXED_POINT_KINEMATICS=1 the checksum must be identical on
+	 * every compiler and CPU; compare the logged value across builds. Also times the core's scalar helpers in float
+	 * and in FITPFixed, whichever mode the build uses, for the cost of the fixed point mode.
+	 */
+	static void SelfTest(const TArray<FString>& Args)
+	{
+		const int32 Steps = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100000;
+		using FScriptedMover = TITPMover<FITPConstantGravity, FITPCharacterGlide, FITPNoCollision>;
+
+		FITPMoverParams Params;
+		FITPMoverState State;
+		FITPChecksumBuilder Builder;
+		const FITPScalar DeltaSeconds = ITPFromFloat<FITPScalar>(1.f / 60.f);
+		for (int32 Step = 0; Step < Steps; ++Step)
+		{
+			State.InputX = ITPFromFloat<FITPScalar>(Step % 240 < 120 ? 1.f : -0.5f);
+			if (Step % 180 == 0)
+			{
+				State.VelocityY = ITPKinematics::Jump(State.VelocityY, Params.JumpVelocity);
+			}
+			State.Glide.bIsGliding = Step % 180 >= 60 && Step % 180 < 150;
+
+			FScriptedMover::Step(State, Params, FITPMoverContext(), DeltaSeconds);
+
+			Builder.Add(State.Position.X);
+			Builder.Add(State.Position.Y);
+			AddScalar(Builder, State.VelocityX);
+			AddScalar(Builder, State.VelocityY);
+			AddScalar(Builder, State.Glide.VelocityY);
+		}
+
+		float FloatSink;
+		FITPFixed FixedSink;
+		const double FloatNs = TimeScalars<float>(Steps, FloatSink);
+		const double FixedNs = TimeScalars<FITPFixed>(Steps, FixedSink);
+
+		UE_LOG(LogITP, Display, TEXT("Kinematics self test (%s scalar): %d steps, checksum %08x, final position (%.3f, %.3f)"),
+			ITP_FIXED_POINT_KINEMATICS ? TEXT("fixed point") : TEXT("float"), Steps, Builder.Crc, State.Position.X, State.Position.Y);
+		UE_LOG(LogITP, Display, TEXT("Kinematic scalar step: %.2f ns float, %.2f ns fixed point (sinks %.1f, %.1f)"),
+			FloatNs, FixedNs, FloatSink, FixedSink.ToFloat());
+	}
+
+	static FAutoConsoleCommand SelfTestCommand(
+		TEXT("ITP.Movement.SelfTest"),
+		TEXT("ITP.Movement.SelfTest [Steps=100000]: steps a scripted run through the kinematic core and logs its checksum, to compare across compilers and\n")
+		TEXT("platforms with ITP_FIXED_POINT_KINEMATICS=1, and times the core's scalar math in float and in fixed point."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&SelfTest));
+}
@@ -0,0 +1,163 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "ITPFixedPoint.h"
+
+/** ITP-owned glide state in the gameplay plane (see ITPMath2D.h), advanced in fixed steps independent of the render frame time */
+struct FITPGlideState
+{
+	FITPScalar VelocityY = ITPFromFloat<FITPScalar>(0.f);
+	bool bIsGliding = false;
+
+	/** Vertical (plane Y) velocity the movement component is held at while gliding */
+	bool bForceVelocityY = false;
+	FITPScalar ForcedVelocityY = ITPFromFloat<FITPScalar>(0.f);
+};
+
+/** Full kinematic state of an ITP mover in the gameplay plane, stepped by TITPMover (see ITPMover.h) */
+struct FITPMoverState
+{
+	FVector2f Position = FVector2f::ZeroVector;
+	FITPScalar VelocityX = ITPFromFloat<FITPScalar>(0.f);
+	FITPScalar VelocityY = ITPFromFloat<FITPScalar>(0.f);
+
+	/** Horizontal input in [-1, 1] */
+	FITPScalar InputX = ITPFromFloat<FITPScalar>(0.f);
+
+	bool bGrounded = false;
+	FITPGlideState Glide;
+};
+
+/** Tuning shared by all movers. Defaults match the AITPCharacter movement component setup. */
+struct FITPMoverParams
+{
+	FITPScalar GravityY = ITPFromFloat<FITPScalar>(-980.f);
+	FITPScalar GravityScale = ITPFromFloat<FITPScalar>(1.f);
+	FITPScalar JumpVelocity = ITPFromFloat<FITPScalar>(700.f);
+	FITPScalar MaxSpeed = ITPFromFloat<FITPScalar>(500.f);
+	FITPScalar MaxAcceleration = ITPFromFloat<FITPScalar>(2048.f);
+	FITPScalar AirControl = ITPFromFloat<FITPScalar>(0.35f);
+	FITPScalar DescendingRate = ITPFromFloat<FITPScalar>(300.f);
+};
+
+/**
+ * Kinematic core. Templated on the scalar so the same code runs in float or, with
+ * ITP_FIXED_POINT_KINEMATICS, in FITPFixed for bit-identical results across platforms.
+ */
+namespace ITPKinematics
+{
+	/** Game thread fixed step of ITP simulation (ITP.Movement.FixedStepHz) */
+	float GetFixedDeltaSeconds();
+
+	/** FMath::InterpEaseInOut with exponent 3, written without pow so it is exact in fixed point */
+	template<typename T>
+	T EaseInOut3(T A, T B, T Alpha)
+	{
+		const T One = ITPFromFloat<T>(1.f);
+		const T Half = ITPFromFloat<T>(0.5f);
+		const T Two = ITPFromFloat<T>(2.f);
+
+		T Blend;
+		if (Alpha < Half)
+		{
+			const T X = Two * Alpha;
+			Blend = Half * X * X * X;
+		}
+		else
+		{
+			const T X = Two * (One - Alpha);
+			Blend = One - Half * X * X * X;
+		}
+		return A + (B - A) * Blend;
+	}
+
+	template<typename T>
+	T ApplyGravity(T VelocityY, T GravityY, T GravityScale, T DeltaSeconds)
+	{
+		return VelocityY + GravityY * GravityScale * DeltaSeconds;
+	}
+
+	/** Same rule as UCharacterMovementComponent::DoJump */
+	template<typename T>
+	T Jump(T VelocityY, T JumpVelocity)
+	{
+		return VelocityY > JumpVelocity ? VelocityY : JumpVelocity;
+	}
+
+	/** Moves the horizontal velocity towards Input * MaxSpeed, limited by the air-control scaled acceleration */
+	template<typename T>
+	T ApplyAirControl(T VelocityX, T Input, T MaxSpeed, T MaxAcceleration, T AirControl, T DeltaSeconds)
+	{
+		const T Target = Input * MaxSpeed;
+		const T MaxDelta = MaxAcceleration * AirControl * DeltaSeconds;
+		const T Delta = Target - VelocityX;
+
+		if (Delta > MaxDelta)
+		{
+			return VelocityX + MaxDelta;
+		}
+		if (Delta < -MaxDelta)
+		{
+			return VelocityX - MaxDelta;
+		}
+		return Target;
+	}
+
+	/** One glide step. Matches the original per-frame DescendPlayer behaviour with DeltaSeconds as the easing alpha. */
+	void StepGlide(FITPGlideState& State, FITPScalar DescendingRate, FITPScalar DeltaSeconds);
+
+	FITPGlideState Interpolate(const FITPGlideState& From, const FITPGlideState& To, float Alpha);
+}
+
+/**
+ * Fixed-rate driver for the glide kinematics.
+ * Either the game thread advances it with an accumulator, or Chaos calls AsyncStep from the async physics tick
+ * and the game thread only reads interpolated results.
+ */
+class FITPFixedStepSimulation
+{
+public:
+	/** Game thread: latch new input for the next step */
+	void SetInput(bool bIsGliding, float EntryVelocityY, float DescendingRate);
+
+	/** Game thread: step on the game thread at FixedDeltaSeconds, used when async physics is off */
+	void AdvanceGameThread(float DeltaSeconds, float FixedDeltaSeconds);
+
+	/** Game thread: note elapsed frame time when steps are produced by the async tick */
+	void AdvanceAsyncReadback(float DeltaSeconds, float FixedDeltaSeconds);
+
+	/** Game thread: state blended between the last two completed steps */
+	FITPGlideState GetInterpolated() const;
+
+	/** Physics thread: one fixed step from the Chaos async physics tick */
+	void AsyncStep(float FixedDeltaSeconds);
+
+private:
+	void Step_AssumesLocked(float FixedDeltaSeconds);
+
+	struct FInput
+	{
+		bool bIsGliding = false;
+		FITPScalar EntryVelocityY = ITPFromFloat<FITPScalar>(0.f);
+		FITPScalar DescendingRate = ITPFromFloat<FITPScalar>(0.f);
+		uint32 Serial = 0;
+	};
+
+	mutable FCriticalSection Lock;
+
+	FInput Input;
+	uint32 ConsumedInputSerial = 0;
+
+	FITPMoverState SimState;
+	FITPMoverState PrevResult;
+	FITPMoverState CurrResult;
+	uint32 NumSteps = 0;
+
+	/** Game thread bookkeeping for interpolation */
+	float Accumulator = 0.f;
+	uint32 LastSeenStep = 0;
+	float Alpha = 1.f;
+};
@@ -0,0 +1,344 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPLagCompensationSubsystem.h"
+#include "ITP.h"
+#include "ITPCharacter.h"
+#include "ITPCollision.h"
+#include "ITPMath2D.h"
+#include "ITPOriginSubsystem.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Record"), STAT_ITPLagCompRecord, STATGROUP_ITP);
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Rewind"), STAT_ITPLagCompRewind, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Lag Compensated Hits Accepted"), STAT_ITPLagCompAccepted, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Lag Compensated Hits Rejected"), STAT_ITPLagCompRejected, STATGROUP_ITP);
+
+static float GITPLagCompMaxRewindMs = 250.f;
+static FAutoConsoleVariableRef CVarITPLagCompMaxRewindMs(
+	TEXT("ITP.LagComp.MaxRewindMs"),
+	GITPLagCompMaxRewindMs,
+	TEXT("Clients can be rewound to at most this far behind the server. Limits what a lagging or lying client can claim."));
+
+static float GITPLagCompTolerance = 15.f;
+static FAutoConsoleVariableRef CVarITPLagCompTolerance(
+	TEXT("ITP.LagComp.Tolerance"),
+	GITPLagCompTolerance,
+	TEXT("Slack in cm added to rewound bounds to absorb interpolation error."));
+
+static FBox2f GetCurrentBounds(const AActor* Actor, const ITP2D::FPlaneOrigin& Origin)
+{
+	const FBox Bounds = Actor->GetComponentsBoundingBox();
+	return FBox2f(ITP2D::FromWorld(Bounds.Min, Origin), ITP2D::FromWorld(Bounds.Max, Origin));
+}
+
+static FBox2f GetCapsuleBounds(const AITPCharacter* Character, const ITP2D::FPlaneOrigin& Origin)
+{
+	const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+	return ITP2D::CapsuleBounds(ITP2D::FromWorld(Character->GetActorLocation(), Origin), Capsule->GetScaledCapsuleRadius(), Capsule->GetScaledCapsuleHalfHeight());
+}
+
+static ITP2D::FPlaneOrigin GetPlaneOrigin(const UWorld* World)
+{
+	const UITPOriginSubsystem* OriginSubsystem = World->GetSubsystem<UITPOriginSubsystem>();
+	return OriginSubsystem ? OriginSubsystem->GetOrigin() : ITP2D::FPlaneOrigin();
+}
+
+void UITPLagCompensationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (UITPOriginSubsystem* OriginSubsystem = Collection.InitializeDependency<UITPOriginSubsystem>())
+	{
+		OriginShiftedHandle = OriginSubsystem->OnOriginShifted.AddUObject(this, &UITPLagCompensationSubsystem::HandleOriginShifted);
+	}
+}
+
+void UITPLagCompensationSubsystem::Deinitialize()
+{
+	if (UITPOriginSubsystem* OriginSubsystem = GetWorld()->GetSubsystem<UITPOriginSubsystem>())
+	{
+		OriginSubsystem->OnOriginShifted.Remove(OriginShiftedHandle);
+	}
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	GetWorld()->RemoveOnActorDestroyedHandler(ActorDestroyedHandle);
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+
+	History.Reset();
+	Actors.Reset();
+	HalfExtents.Reset();
+	SlotOf.Reset();
+
+	Super::Deinitialize();
+}
+
+void UITPLagCompensationSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Same rule as AITPCharacter: only a server judges client reports
+	if (InWorld.GetNetMode() == NM_Client || InWorld.GetNetMode() == NM_Standalone)
+	{
+		return;
+	}
+
+	for (ULevel* Level : InWorld.GetLevels())
+	{
+		HandleLevelAdded(Level, &InWorld);
+	}
+
+	ActorSpawnedHandle = InWorld.AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UITPLagCompensationSubsystem::RegisterHazard));
+	ActorDestroyedHandle = InWorld.AddOnActorDestroyedHandler(FOnActorDestroyed::FDelegate::CreateUObject(this, &UITPLagCompensationSubsystem::Unregister));
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UITPLagCompensationSubsystem::HandleLevelAdded);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UITPLagCompensationSubsystem::HandleLevelRemoved);
+}
+
+void UITPLagCompensationSubsystem::HandleLevelAdded(ULevel* Level, UWorld* InWorld)
+{
+	if (Level && InWorld == GetWorld())
+	{
+		for (AActor* Actor : Level->Actors)
+		{
+			RegisterHazard(Actor);
+		}
+	}
+}
+
+void UITPLagCompensationSubsystem::HandleLevelRemoved(ULevel* Level, UWorld* InWorld)
+{
+	// Streamed out actors are not reported as destroyed
+	if (Level && InWorld == GetWorld())
+	{
+		for (AActor* Actor : Level->Actors)
+		{
+			Unregister(Actor);
+		}
+	}
+}
+
+void UITPLagCompensationSubsystem::RegisterHazard(AActor* Actor)
+{
+	if (!ITPCollision::IsHazard(Actor))
+	{
+		return;
+	}
+
+	// History records the actor location, so the extent covers the bounds on both sides of it
+	const FBox Bounds = Actor->GetComponentsBoundingBox();
+	const FVector Location = Actor->GetActorLocation();
+	const FVector2f Min = ITP2D::FromWorldDirection(Bounds.Min - Location);
+	const FVector2f Max = ITP2D::FromWorldDirection(Bounds.Max - Location);
+	Register(Actor, FVector2f(FMath::Max(FMath::Abs(Min.X), FMath::Abs(Max.X)), FMath::Max(FMath::Abs(Min.Y), FMath::Abs(Max.Y))));
+}
+
+void UITPLagCompensationSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ITPLagCompRecord);
+
+	// World subsystems tick after actors, so this records where everything ended up this frame
+	const double Now = GetWorld()->GetTimeSeconds();
+	const ITP2D::FPlaneOrigin Origin = GetPlaneOrigin(GetWorld());
+
+	for (int32 Slot = 0; Slot < Actors.Num(); ++Slot)
+	{
+		if (const AActor* Actor = Actors[Slot].Get())
+		{
+			History.Record(Slot, Now, ITP2D::FromWorld(Actor->GetActorLocation(), Origin));
+		}
+	}
+}
+
+TStatId UITPLagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UITPLagCompensationSubsystem, STATGROUP_ITP);
+}
+
+bool UITPLagCompensationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UITPLagCompensationSubsystem::Register(AActor* Actor, const FVector2f& HalfExtent)
+{
+	if (!Actor || SlotOf.Contains(Actor))
+	{
+		return;
+	}
+
+	const int32 Slot = History.AddSlot();
+	if (Slot == Actors.Num())
+	{
+		Actors.AddDefaulted();
+		HalfExtents.AddDefaulted();
+	}
+
+	Actors[Slot] = Actor;
+	HalfExtents[Slot] = HalfExtent;
+	SlotOf.Add(Actor, Slot);
+}
+
+void UITPLagCompensationSubsystem::Unregister(AActor* Actor)
+{
+	int32 Slot;
+	if (SlotOf.RemoveAndCopyValue(Actor, Slot))
+	{
+		History.RemoveSlot(Slot);
+		Actors[Slot].Reset();
+	}
+}
+
+FBox2f UITPLagCompensationSubsystem::GetBoundsAt(const AActor* Actor, double Time) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ITPLagCompRewind);
+
+	const int32* Slot = SlotOf.Find(Actor);
+	FVector2f Center;
+	if (!Slot || !History.Sample(*Slot, Time, Center))
+	{
+		return GetCurrentBounds(Actor, GetPlaneOrigin(GetWorld()));
+	}
+
+	return FBox2f(Center - HalfExtents[*Slot], Center + HalfExtents[*Slot]);
+}
+
+bool UITPLagCompensationSubsystem::ValidateStomp(const AITPCharacter* Stomper, const AActor* Victim, double ViewTime) const
+{
+	if (!Stomper || !Victim)
+	{
+		return false;
+	}
+
+	const FBox2f VictimBounds = GetBoundsAt(Victim, ClampViewTime(ViewTime));
+	const FBox2f StomperBounds = GetCapsuleBounds(Stomper, GetPlaneOrigin(GetWorld()));
+	const float Tolerance = GITPLagCompTolerance;
+
+	const bool bOverlapsX = StomperBounds.Min.X <= VictimBounds.Max.X + Tolerance && StomperBounds.Max.X >= VictimBounds.Min.X - Tolerance;
+	const float Feet = StomperBounds.Min.Y;
+	const bool bOnTop = Feet >= VictimBounds.GetCenter().Y && Feet <= VictimBounds.Max.Y + Tolerance;
+
+	const bool bValid = bOverlapsX && bOnTop;
+	INC_DWORD_STAT(bValid ? STAT_ITPLagCompAccepted : STAT_ITPLagCompRejected);
+	return bValid;
+}
+
+bool UITPLagCompensationSubsystem::ValidateHazard(const AITPCharacter* Character, const AActor* Hazard, double ViewTime) const
+{
+	if (!Character || !Hazard)
+	{
+		return false;
+	}
+
+	const FBox2f HazardBounds = GetBoundsAt(Hazard, ClampViewTime(ViewTime)).ExpandBy(GITPLagCompTolerance);
+	const FBox2f CharacterBounds = GetCapsuleBounds(Character, GetPlaneOrigin(GetWorld()));
+
+	const bool bValid = HazardBounds.Intersect(CharacterBounds);
+	INC_DWORD_STAT(bValid ? STAT_ITPLagCompAccepted : STAT_ITPLagCompRejected);
+	return bValid;
+}
+
+double UITPLagCompensationSubsystem::GetClientViewTime(const APawn* Viewer)
+{
+	const UWorld* World = Viewer->GetWorld();
+	const AGameStateBase* GameState = World->GetGameState();
+	const double ServerNow = GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+
+	// Remote actors arrive half a round trip after the server moved them
+	const APlayerState* PlayerState = Viewer->GetPlayerState();
+	const double HalfRoundTrip = PlayerState ? PlayerState->GetPingInMilliseconds() * 0.0005 : 0.0;
+
+	return ServerNow - HalfRoundTrip;
+}
+
+void UITPLagCompensationSubsystem::HandleOriginShifted(const FITPOriginShift& Shift)
+{
+	History.Rebase(Shift.LocationOffset);
+}
+
+double UITPLagCompensationSubsystem::ClampViewTime(double ViewTime) const
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+	return FMath::Clamp(ViewTime, Now - GITPLagCompMaxRewindMs * 0.001, Now);
+}
+
+static FAutoConsoleCommand CmdITPLagCompBenchmark(
+	TEXT("ITP.LagComp.Benchmark"),
+	TEXT("ITP.LagComp.Benchmark [Actors=64] [Checks=100000]: times history rewinds and checks them against a linear scan."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumActors = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 64;
+		const int32 NumChecks = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 100000;
+		constexpr double TickSeconds = 1.0 / 60.0;
+
+		// Fill every ring past capacity so wrap-around is exercised
+		FRandomStream Random(NumActors);
+		FITPLagHistory History;
+		TArray<TArray<TPair<double, FVector2f>>> Reference;
+		Reference.SetNum(NumActors);
+		const int32 NumTicks = FITPLagHistory::Capacity + FITPLagHistory::Capacity / 2;
+		for (int32 Actor = 0; Actor < NumActors; ++Actor)
+		{
+			History.AddSlot();
+		}
+		for (int32 Tick = 0; Tick < NumTicks; ++Tick)
+		{
+			const double Time = Tick * TickSeconds;
+			for (int32 Actor = 0; Actor < NumActors; ++Actor)
+			{
+				const FVector2f Location(Actor * 500.f + Tick * 5.f, Random.FRandRange(0.f, 400.f));
+				History.Record(Actor, Time, Location);
+				Reference[Actor].Emplace(Time, Location);
+			}
+		}
+
+		const double Newest = (NumTicks - 1) * TickSeconds;
+		const double Oldest = History.GetOldestTime(0);
+
+		TArray<TPair<int32, double>> Queries;
+		Queries.Reserve(NumChecks);
+		for (int32 Check = 0; Check < NumChecks; ++Check)
+		{
+			Queries.Emplace(Random.RandHelper(NumActors), Random.FRandRange(Oldest, Newest));
+		}
+
+		FVector2f Sink = FVector2f::ZeroVector;
+		const double StartTime = FPlatformTime::Seconds();
+		for (const TPair<int32, double>& Query : Queries)
+		{
+			FVector2f Location;
+			History.Sample(Query.Key, Query.Value, Location);
+			Sink += Location;
+		}
+		const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+		// Linear scan over the retained window for a sample of the queries
+		int32 NumMismatches = 0;
+		for (int32 Check = 0; Check < FMath::Min(NumChecks, 1000); ++Check)
+		{
+			const TArray<TPair<double, FVector2f>>& Samples = Reference[Queries[Check].Key];
+			const double Time = Queries[Check].Value;
+			FVector2f Expected = Samples.Last().Value;
+			for (int32 Index = NumTicks - FITPLagHistory::Capacity; Index < NumTicks - 1; ++Index)
+			{
+				if (Samples[Index].Key <= Time && Time < Samples[Index + 1].Key)
+				{
+					const float Alpha = (float)((Time - Samples[Index].Key) / (Samples[Index + 1].Key - Samples[Index].Key));
+					Expected = FMath::Lerp(Samples[Index].Value, Samples[Index + 1].Value, Alpha);
+					break;
+				}
+			}
+
+			FVector2f Location;
+			History.Sample(Queries[Check].Key, Time, Location);
+			NumMismatches += Location.Equals(Expected, 0.01f) ? 0 : 1;
+		}
+
+		UE_LOG(LogITP, Log, TEXT("Lag compensation: %d actors x %d samples, %d rewinds in %.2f ms (%.3f us each), %d mismatch(es) (%.1f)"),
+			NumActors, FITPLagHistory::Capacity, NumChecks, Elapsed * 1000.0, Elapsed * 1e6 / NumChecks, NumMismatches, Sink.X);
+	}));
@@ -0,0 +1,73 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ITPLagHistory.h"
+#include "ITPLagCompensationSubsystem.generated.h"
+
+class AITPCharacter;
+class ULevel;
+struct FITPOriginShift;
+
+/**
+ * Server-side lag compensation for stomps and hazard hits.
+ * Registered actors have their plane location recorded into an FITPLagHistory after every server tick. ITP
+ * characters register themselves; hazards (actors whose root is ITP_Hazard) are registered here as they are
+ * spawned or streamed in, and dropped when destroyed or streamed out. Reports
+ * from clients carry the server time they were looking at; the victim or hazard is rewound to that time
+ * (clamped to ITP.LagComp.MaxRewindMs) before the hit is judged, while the reporting character is taken as is,
+ * since its own movement already arrived at the server in order.
+ */
+UCLASS()
+class ITP_API UITPLagCompensationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Starts recording Actor. HalfExtent is its half size in the plane (capsule radius, half height). */
+	void Register(AActor* Actor, const FVector2f& HalfExtent);
+	void Unregister(AActor* Actor);
+
+	/** Plane bounds of Actor at server time Time. Unregistered actors are taken at their current location. */
+	FBox2f GetBoundsAt(const AActor* Actor, double Time) const;
+
+	/** True if Stomper's feet were on top of Victim as the client saw Victim at ViewTime */
+	bool ValidateStomp(const AITPCharacter* Stomper, const AActor* Victim, double ViewTime) const;
+
+	/** True if Character overlapped Hazard as the client saw Hazard at ViewTime */
+	bool ValidateHazard(const AITPCharacter* Character, const AActor* Hazard, double ViewTime) const;
+
+	/** Server time a locally controlled client sees remote actors at: server time minus half the round trip */
+	static double GetClientViewTime(const APawn* Viewer);
+
+private:
+	void HandleOriginShifted(const FITPOriginShift& Shift);
+
+	/** Registers Actor if it is a hazard, sized by its bounds around its location */
+	void RegisterHazard(AActor* Actor);
+	void HandleLevelAdded(ULevel* Level, UWorld* InWorld);
+	void HandleLevelRemoved(ULevel* Level, UWorld* InWorld);
+	double ClampViewTime(double ViewTime) const;
+
+	FITPLagHistory History;
+
+	/** Indexed by history slot */
+	TArray<TWeakObjectPtr<AActor>> Actors;
+	TArray<FVector2f> HalfExtents;
+	TMap<TObjectKey<AActor>, int32> SlotOf;
+
+	FDelegateHandle OriginShiftedHandle;
+	FDelegateHandle ActorSpawnedHandle;
+	FDelegateHandle ActorDestroyedHandle;
+	FDelegateHandle LevelAddedHandle;
+	FDelegateHandle LevelRemovedHandle;
+};
@@ -0,0 +1,105 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPLagHistory.h"
+#include "ITPMath2D.h"
+
+static_assert((FITPLagHistory::Capacity & (FITPLagHistory::Capacity - 1)) == 0, "FITPLagHistory::Capacity must be a power of two");
+
+int32 FITPLagHistory::AddSlot()
+{
+	if (FreeSlots.Num() > 0)
+	{
+		const int32 Slot = FreeSlots.Pop(false);
+		Heads[Slot] = 0;
+		Counts[Slot] = 0;
+		return Slot;
+	}
+
+	const int32 Slot = Heads.Add(0);
+	Counts.Add(0);
+	Times.AddZeroed(Capacity);
+	PlaneX.AddZeroed(Capacity);
+	PlaneY.AddZeroed(Capacity);
+	return Slot;
+}
+
+void FITPLagHistory::RemoveSlot(int32 Slot)
+{
+	Counts[Slot] = 0;
+	FreeSlots.Add(Slot);
+}
+
+void FITPLagHistory::Reset()
+{
+	Times.Reset();
+	PlaneX.Reset();
+	PlaneY.Reset();
+	Heads.Reset();
+	Counts.Reset();
+	FreeSlots.Reset();
+}
+
+void FITPLagHistory::Record(int32 Slot, double Time, const FVector2f& Location)
+{
+	const int32 Index = Slot * Capacity + Heads[Slot];
+	Times[Index] = Time;
+	PlaneX[Index] = Location.X;
+	PlaneY[Index] = Location.Y;
+
+	Heads[Slot] = (Heads[Slot] + 1) & (Capacity - 1);
+	Counts[Slot] = FMath::Min(Counts[Slot] + 1, Capacity);
+}
+
+bool FITPLagHistory::Sample(int32 Slot, double Time, FVector2f& OutLocation) const
+{
+	const int32 Count = Counts[Slot];
+	if (Count == 0)
+	{
+		return false;
+	}
+
+	const int32 Oldest = PhysicalIndex(Slot, 0);
+	const int32 Newest = PhysicalIndex(Slot, Count - 1);
+	if (Time <= Times[Oldest] || Count == 1)
+	{
+		OutLocation = FVector2f(PlaneX[Oldest], PlaneY[Oldest]);
+		return true;
+	}
+	if (Time >= Times[Newest])
+	{
+		OutLocation = FVector2f(PlaneX[Newest], PlaneY[Newest]);
+		return true;
+	}
+
+	// Times[Lo] <= Time < Times[Hi]
+	int32 Lo = 0;
+	int32 Hi = Count - 1;
+	while (Hi - Lo > 1)
+	{
+		const int32 Mid = (Lo + Hi) / 2;
+		if (Times[PhysicalIndex(Slot, Mid)] <= Time)
+		{
+			Lo = Mid;
+		}
+		else
+		{
+			Hi = Mid;
+		}
+	}
+
+	const int32 A = PhysicalIndex(Slot, Lo);
+	const int32 B = PhysicalIndex(Slot, Hi);
+	const float Alpha = (float)((Time - Times[A]) / FMath::Max(Times[B] - Times[A], UE_DOUBLE_SMALL_NUMBER));
+	OutLocation = FVector2f(FMath::Lerp(PlaneX[A], PlaneX[B], Alpha), FMath::Lerp(PlaneY[A], PlaneY[B], Alpha));
+	return true;
+}
+
+void FITPLagHistory::Rebase(float Offset)
+{
+	ITP2D::Translate(PlaneX.GetData(), PlaneX.Num(), Offset);
+}
+
+double FITPLagHistory::GetOldestTime(int32 Slot) const
+{
+	return Counts[Slot] > 0 ? Times[PhysicalIndex(Slot, 0)] : 0.0;
+}
@@ -0,0 +1,51 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Short per-slot history of plane locations for rewinding to an earlier server time.
+ * Storage is SoA: one array each for times, plane X and plane Y, Capacity samples per slot in a ring.
+ * Sampling binary searches the ring of one slot and lerps between the two samples around the requested time,
+ * so a rewind touches a handful of cache lines regardless of how many slots exist.
+ */
+class ITP_API FITPLagHistory
+{
+public:
+	/** Samples kept per slot; a power of two. About a second at a 60 Hz server tick. */
+	static constexpr int32 Capacity = 64;
+
+	int32 AddSlot();
+	void RemoveSlot(int32 Slot);
+	void Reset();
+
+	/** Times must increase per slot */
+	void Record(int32 Slot, double Time, const FVector2f& Location);
+
+	/** Location of Slot at Time, clamped to the oldest and newest samples. False if the slot has no samples. */
+	bool Sample(int32 Slot, double Time, FVector2f& OutLocation) const;
+
+	/** Adds Offset to every stored plane X, after a plane origin shift */
+	void Rebase(float Offset);
+
+	double GetOldestTime(int32 Slot) const;
+	int32 NumSamples(int32 Slot) const { return Counts[Slot]; }
+	int32 NumSlots() const { return Heads.Num(); }
+
+private:
+	/** Flat index of the Logical-th oldest sample of Slot */
+	FORCEINLINE int32 PhysicalIndex(int32 Slot, int32 Logical) const
+	{
+		return Slot * Capacity + ((Heads[Slot] - Counts[Slot] + Logical) & (Capacity - 1));
+	}
+
+	TArray<double> Times;
+	TArray<float> PlaneX;
+	TArray<float> PlaneY;
+
+	/** Per slot: next write position in the ring and number of valid samples */
+	TArray<int32> Heads;
+	TArray<int32> Counts;
+	TArray<int32> FreeSlots;
+};
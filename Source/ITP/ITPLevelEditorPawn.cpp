@@ -0,0 +1,151 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPLevelEditorPawn.h"
+#include "ITPLevelEditorSubsystem.h"
+#include "ITPTileMapActor.h"
+#include "Camera/CameraComponent.h"
+#include "EnhancedInputComponent.h"
+#include "EnhancedInputSubsystems.h"
+#include "GameFramework/PlayerController.h"
+#include "InputActionValue.h"
+
+AITPLevelEditorPawn::AITPLevelEditorPawn()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	Camera = CreateDefaultSubobject<UCameraComponent>(TEXT("Camera"));
+	RootComponent = Camera;
+
+	// Look down the depth axis at the gameplay plane, orthographic so tiles line up with the cursor
+	Camera->SetProjectionMode(ECameraProjectionMode::Orthographic);
+	Camera->SetOrthoWidth(3200.f);
+	Camera->SetRelativeRotation(FRotator::ZeroRotator);
+}
+
+void AITPLevelEditorPawn::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+
+	if (APlayerController* PlayerController = Cast<APlayerController>(NewController))
+	{
+		PlayerController->SetShowMouseCursor(true);
+		if (UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(PlayerController->GetLocalPlayer()))
+		{
+			Subsystem->AddMappingContext(EditorMappingContext, 0);
+		}
+	}
+}
+
+void AITPLevelEditorPawn::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
+{
+	if (UEnhancedInputComponent* EnhancedInputComponent = Cast<UEnhancedInputComponent>(PlayerInputComponent))
+	{
+		EnhancedInputComponent->BindAction(PaintAction, ETriggerEvent::Started, this, &AITPLevelEditorPawn::BeginPaint);
+		EnhancedInputComponent->BindAction(PaintAction, ETriggerEvent::Triggered, this, &AITPLevelEditorPawn::Paint);
+		EnhancedInputComponent->BindAction(PaintAction, ETriggerEvent::Completed, this, &AITPLevelEditorPawn::EndPaint);
+		EnhancedInputComponent->BindAction(EraseAction, ETriggerEvent::Started, this, &AITPLevelEditorPawn::BeginPaint);
+		EnhancedInputComponent->BindAction(EraseAction, ETriggerEvent::Triggered, this, &AITPLevelEditorPawn::Erase);
+		EnhancedInputComponent->BindAction(EraseAction, ETriggerEvent::Completed, this, &AITPLevelEditorPawn::EndPaint);
+		EnhancedInputComponent->BindAction(PanAction, ETriggerEvent::Triggered, this, &AITPLevelEditorPawn::Pan);
+		EnhancedInputComponent->BindAction(UndoAction, ETriggerEvent::Started, this, &AITPLevelEditorPawn::Undo);
+		EnhancedInputComponent->BindAction(RedoAction, ETriggerEvent::Started, this, &AITPLevelEditorPawn::Redo);
+		EnhancedInputComponent->BindAction(SaveAction, ETriggerEvent::Started, this, &AITPLevelEditorPawn::Save);
+		EnhancedInputComponent->BindAction(PlaytestAction, ETriggerEvent::Started, this, &AITPLevelEditorPawn::Playtest);
+	}
+}
+
+void AITPLevelEditorPawn::BeginPaint(const FInputActionValue& Value)
+{
+	if (UITPLevelEditorSubsystem* Editor = GetEditor())
+	{
+		Editor->BeginStroke();
+	}
+}
+
+void AITPLevelEditorPawn::Paint(const FInputActionValue& Value)
+{
+	PaintUnderCursor(static_cast<uint16>(BrushTileId));
+}
+
+void AITPLevelEditorPawn::Erase(const FInputActionValue& Value)
+{
+	PaintUnderCursor(0);
+}
+
+void AITPLevelEditorPawn::EndPaint(const FInputActionValue& Value)
+{
+	if (UITPLevelEditorSubsystem* Editor = GetEditor())
+	{
+		Editor->EndStroke();
+	}
+}
+
+void AITPLevelEditorPawn::Pan(const FInputActionValue& Value)
+{
+	const FVector2D Axis = Value.Get<FVector2D>();
+	const float DeltaSeconds = GetWorld()->GetDeltaSeconds();
+	AddActorWorldOffset(ITP2D::ToWorldDirection(FVector2f(Axis)) * PanSpeed * DeltaSeconds);
+}
+
+void AITPLevelEditorPawn::Undo(const FInputActionValue& Value)
+{
+	if (UITPLevelEditorSubsystem* Editor = GetEditor())
+	{
+		Editor->Undo();
+	}
+}
+
+void AITPLevelEditorPawn::Redo(const FInputActionValue& Value)
+{
+	if (UITPLevelEditorSubsystem* Editor = GetEditor())
+	{
+		Editor->Redo();
+	}
+}
+
+void AITPLevelEditorPawn::Save(const FInputActionValue& Value)
+{
+	if (UITPLevelEditorSubsystem* Editor = GetEditor())
+	{
+		Editor->Save();
+	}
+}
+
+void AITPLevelEditorPawn::Playtest(const FInputActionValue& Value)
+{
+	if (UITPLevelEditorSubsystem* Editor = GetEditor())
+	{
+		Editor->StartPlaytest();
+	}
+}
+
+void AITPLevelEditorPawn::PaintUnderCursor(uint16 TileId)
+{
+	UITPLevelEditorSubsystem* Editor = GetEditor();
+	const APlayerController* PlayerController = Cast<APlayerController>(GetController());
+	if (!Editor || !Editor->GetTileMap() || !PlayerController)
+	{
+		return;
+	}
+
+	FVector Origin, Direction;
+	if (!PlayerController->DeprojectMousePositionToWorld(Origin, Direction))
+	{
+		return;
+	}
+
+	// Intersect the cursor ray with the tile map's gameplay plane
+	const AITPTileMapActor* TileMap = Editor->GetTileMap();
+	const FPlane Plane(TileMap->GetActorLocation(), TileMap->GetActorForwardVector());
+	if (FMath::IsNearlyZero(Direction | Plane.GetNormal()))
+	{
+		return;
+	}
+	const FVector Hit = FMath::RayPlaneIntersection(Origin, Direction, Plane);
+	Editor->PaintTile(TileMap->WorldToTile(Hit), TileId, BrushLayer);
+}
+
+UITPLevelEditorSubsystem* AITPLevelEditorPawn::GetEditor() const
+{
+	return GetWorld()->GetSubsystem<UITPLevelEditorSubsystem>();
+}
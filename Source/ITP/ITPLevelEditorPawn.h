@@ -0,0 +1,80 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Pawn.h"
+#include "ITPLevelEditorPawn.generated.h"
+
+class UCameraComponent;
+class UInputAction;
+class UInputMappingContext;
+struct FInputActionValue;
+
+/** Free camera for the in-game level editor. Paints tiles under the cursor through UITPLevelEditorSubsystem. */
+UCLASS(config=Game)
+class AITPLevelEditorPawn : public APawn
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, Category = Camera)
+	TObjectPtr<UCameraComponent> Camera;
+
+	UPROPERTY(EditAnywhere, Category = Input)
+	TObjectPtr<UInputMappingContext> EditorMappingContext;
+
+	UPROPERTY(EditAnywhere, Category = Input)
+	TObjectPtr<UInputAction> PaintAction;
+
+	UPROPERTY(EditAnywhere, Category = Input)
+	TObjectPtr<UInputAction> EraseAction;
+
+	/** 2D axis, scroll and up */
+	UPROPERTY(EditAnywhere, Category = Input)
+	TObjectPtr<UInputAction> PanAction;
+
+	UPROPERTY(EditAnywhere, Category = Input)
+	TObjectPtr<UInputAction> UndoAction;
+
+	UPROPERTY(EditAnywhere, Category = Input)
+	TObjectPtr<UInputAction> RedoAction;
+
+	UPROPERTY(EditAnywhere, Category = Input)
+	TObjectPtr<UInputAction> SaveAction;
+
+	UPROPERTY(EditAnywhere, Category = Input)
+	TObjectPtr<UInputAction> PlaytestAction;
+
+public:
+	AITPLevelEditorPawn();
+
+	/** Tile id painted by PaintAction */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Editor)
+	int32 BrushTileId = 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Editor)
+	int32 BrushLayer = 0;
+
+	UPROPERTY(EditAnywhere, Category = Editor)
+	float PanSpeed = 2000.f;
+
+protected:
+	virtual void PossessedBy(AController* NewController) override;
+	virtual void SetupPlayerInputComponent(UInputComponent* PlayerInputComponent) override;
+
+private:
+	void BeginPaint(const FInputActionValue& Value);
+	void Paint(const FInputActionValue& Value);
+	void Erase(const FInputActionValue& Value);
+	void EndPaint(const FInputActionValue& Value);
+	void Pan(const FInputActionValue& Value);
+	void Undo(const FInputActionValue& Value);
+	void Redo(const FInputActionValue& Value);
+	void Save(const FInputActionValue& Value);
+	void Playtest(const FInputActionValue& Value);
+
+	/** Writes TileId into the tile under the mouse cursor */
+	void PaintUnderCursor(uint16 TileId);
+
+	class UITPLevelEditorSubsystem* GetEditor() const;
+};
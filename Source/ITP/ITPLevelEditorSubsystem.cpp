@@ -0,0 +1,578 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPLevelEditorSubsystem.h"
+#include "ITP.h"
+#include "ITPCharacter.h"
+#include "ITPKinematics.h"
+#include "ITPTileMapActor.h"
+#include "Algo/BinarySearch.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Tasks/Task.h"
+
+DECLARE_CYCLE_STAT(TEXT("Level Editor Tick"), STAT_ITPLevelEditorTick, STATGROUP_ITP);
+DECLARE_CYCLE_STAT(TEXT("Level Editor Save"), STAT_ITPLevelEditorSave, STATGROUP_ITP);
+DECLARE_CYCLE_STAT(TEXT("Reachability Analysis"), STAT_ITPReachability, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Editor Chunks Rebuilt"), STAT_ITPEditorChunksRebuilt, STATGROUP_ITP);
+
+static int32 GITPEditorUndoLimit = 256;
+static FAutoConsoleVariableRef CVarITPEditorUndoLimit(
+	TEXT("ITP.Editor.UndoLimit"),
+	GITPEditorUndoLimit,
+	TEXT("Maximum number of undo steps kept by the in-game level editor."));
+
+static float GITPEditorReachabilityDelay = 0.25f;
+static FAutoConsoleVariableRef CVarITPEditorReachabilityDelay(
+	TEXT("ITP.Editor.ReachabilityDelay"),
+	GITPEditorReachabilityDelay,
+	TEXT("Seconds without edits before the level editor re-runs the reachability analysis."));
+
+/** The play pawn has no editor bindings, so leaving a playtest goes through the console */
+static FAutoConsoleCommandWithWorld CmdITPEditorTogglePlaytest(
+	TEXT("ITP.Editor.TogglePlaytest"),
+	TEXT("Switches the in-game level editor between editing and playing the current level."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UITPLevelEditorSubsystem* Editor = World ? World->GetSubsystem<UITPLevelEditorSubsystem>() : nullptr)
+		{
+			Editor->IsPlaytesting() ? Editor->StopPlaytest() : Editor->StartPlaytest();
+		}
+	}));
+
+void UITPLevelEditorSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ITPLevelEditorTick);
+
+	if (!TileMap)
+	{
+		return;
+	}
+
+	// A stroke touches many tiles of the same chunks, so instances are rebuilt at most once per frame
+	for (const FIntPoint& Coord : VisualDirty)
+	{
+		if (const FITPLevelChunk* Chunk = Chunks.Find(Coord))
+		{
+			TileMap->RebuildChunk(*Chunk);
+		}
+		else
+		{
+			TileMap->RemoveChunk(Coord);
+		}
+		INC_DWORD_STAT(STAT_ITPEditorChunksRebuilt);
+	}
+	VisualDirty.Reset();
+
+	if (AnalysisTask.IsValid() && AnalysisTask.IsCompleted())
+	{
+		TSharedPtr<FITPReachabilityResult> Result = AnalysisTask.GetResult();
+		AnalysisTask = {};
+		if (Result && LaunchedGeneration == AnalysisGeneration)
+		{
+			Reachability = MoveTemp(*Result);
+			OnReachabilityUpdated.Broadcast(Reachability);
+		}
+	}
+
+	if (AnalysisDelay >= 0.f)
+	{
+		AnalysisDelay -= DeltaTime;
+		if (AnalysisDelay < 0.f && !AnalysisTask.IsValid())
+		{
+			LaunchAnalysis();
+		}
+		else if (AnalysisDelay < 0.f)
+		{
+			// Still running on stale data; try again next frame
+			AnalysisDelay = 0.f;
+		}
+	}
+}
+
+TStatId UITPLevelEditorSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UITPLevelEditorSubsystem, STATGROUP_ITP);
+}
+
+bool UITPLevelEditorSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UITPLevelEditorSubsystem::Deinitialize()
+{
+	if (AnalysisTask.IsValid())
+	{
+		AnalysisTask.Wait();
+	}
+
+	Super::Deinitialize();
+}
+
+void UITPLevelEditorSubsystem::StartEditing(AITPTileMapActor* InTileMap, const FString& SaveFilename, FIntPoint NewLevelSize, int32 NewLevelLayers)
+{
+	check(InTileMap);
+
+	TileMap = InTileMap;
+	Filename = SaveFilename;
+	Chunks.Reset();
+	SaveDirty.Reset();
+	VisualDirty.Reset();
+	UndoStack.Reset();
+	RedoStack.Reset();
+	FileTable.Reset();
+	bFileWritten = false;
+
+	TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Filename));
+	if (File && ITPLevelFile::ReadHeader(*File, FileHeader) && ITPLevelFile::ReadTable(*File, FileHeader, FileTable))
+	{
+		SizeInTiles = FileHeader.SizeInTiles;
+		NumLayers = FileHeader.NumLayers;
+		TileMap->TileSize = FileHeader.TileSize;
+
+		FITPCookedChunk Cooked;
+		for (const ITPLevelFile::FChunkEntry& Entry : FileTable)
+		{
+			FITPLevelChunk Chunk;
+			if (ITPLevelFile::ReadChunk(*File, Entry, Cooked) && UITPChunkedLevel::UncompressChunk(Cooked, Chunk))
+			{
+				VisualDirty.Add(Chunk.Coord);
+				Chunks.Add(Chunk.Coord, MoveTemp(Chunk));
+			}
+			else
+			{
+				UE_LOG(LogITP, Warning, TEXT("%s: dropping unreadable chunk (%d, %d)"), *Filename, Entry.Coord.X, Entry.Coord.Y);
+			}
+		}
+		bFileWritten = true;
+	}
+	else
+	{
+		SizeInTiles = NewLevelSize;
+		NumLayers = FMath::Max(NewLevelLayers, 1);
+		FileHeader = ITPLevelFile::FHeader();
+		FileHeader.SizeInTiles = SizeInTiles;
+		FileHeader.TileSize = TileMap->TileSize;
+		FileHeader.NumLayers = NumLayers;
+	}
+
+	TileMap->ClearChunks();
+	QueueAnalysis();
+}
+
+void UITPLevelEditorSubsystem::BeginStroke()
+{
+	++StrokeDepth;
+}
+
+void UITPLevelEditorSubsystem::EndStroke()
+{
+	if (StrokeDepth > 0 && --StrokeDepth == 0)
+	{
+		RecordAndCommit(MoveTemp(Stroke));
+		Stroke = FITPEditDiff();
+	}
+}
+
+void UITPLevelEditorSubsystem::PaintTile(const FIntPoint& Tile, uint16 TileId, int32 Layer)
+{
+	if (!IsEditing() || Tile.X < 0 || Tile.Y < 0 || Tile.X >= SizeInTiles.X || Tile.Y >= SizeInTiles.Y || Layer < 0 || Layer >= NumLayers)
+	{
+		return;
+	}
+
+	const uint16 OldId = GetTile(Tile, Layer);
+	if (OldId == TileId)
+	{
+		return;
+	}
+
+	SetTile(Tile, Layer, TileId);
+
+	FITPEditDiff Single;
+	FITPEditDiff& Diff = StrokeDepth > 0 ? Stroke : Single;
+	Diff.Tiles.Add({Tile, OldId, TileId, static_cast<uint8>(Layer)});
+	if (StrokeDepth == 0)
+	{
+		RecordAndCommit(MoveTemp(Single));
+	}
+}
+
+uint16 UITPLevelEditorSubsystem::GetTile(const FIntPoint& Tile, int32 Layer) const
+{
+	const FIntPoint Coord = FITPLevelChunk::TileToChunk(Tile);
+	const FITPLevelChunk* Chunk = Chunks.Find(Coord);
+	if (!Chunk || Chunk->Tiles.IsEmpty())
+	{
+		return 0;
+	}
+
+	const FIntPoint Local = Tile - Coord * FITPLevelChunk::ChunkSize;
+	return Chunk->Tiles[FITPLevelChunk::GetTileIndex(Layer, Local.X, Local.Y)];
+}
+
+void UITPLevelEditorSubsystem::AddSpawn(const FITPSpawnEntry& Entry)
+{
+	if (!IsEditing())
+	{
+		return;
+	}
+
+	ApplySpawn(Entry, true);
+
+	FITPEditDiff Single;
+	FITPEditDiff& Diff = StrokeDepth > 0 ? Stroke : Single;
+	Diff.Spawns.Add({Entry, true});
+	if (StrokeDepth == 0)
+	{
+		RecordAndCommit(MoveTemp(Single));
+	}
+}
+
+void UITPLevelEditorSubsystem::RemoveSpawnsAt(const FIntPoint& Tile)
+{
+	FITPLevelChunk* Chunk = IsEditing() ? Chunks.Find(FITPLevelChunk::TileToChunk(Tile)) : nullptr;
+	if (!Chunk)
+	{
+		return;
+	}
+
+	FITPEditDiff Single;
+	FITPEditDiff& Diff = StrokeDepth > 0 ? Stroke : Single;
+	const float TileSize = TileMap->TileSize;
+
+	// Copied out first: ApplySpawn removes from Chunk->Spawns, and may add chunks to Chunks
+	TArray<FITPSpawnEntry, TInlineAllocator<4>> Removed;
+	for (int32 Index = Chunk->Spawns.Num() - 1; Index >= 0; --Index)
+	{
+		if (ITP2D::LocationToTile(Chunk->Spawns[Index].Location, TileSize) == Tile)
+		{
+			Removed.Add(Chunk->Spawns[Index]);
+		}
+	}
+
+	for (const FITPSpawnEntry& Entry : Removed)
+	{
+		Diff.Spawns.Add({Entry, false});
+		ApplySpawn(Entry, false);
+	}
+
+	if (StrokeDepth == 0)
+	{
+		RecordAndCommit(MoveTemp(Single));
+	}
+}
+
+void UITPLevelEditorSubsystem::Undo()
+{
+	if (UndoStack.IsEmpty() || StrokeDepth > 0)
+	{
+		return;
+	}
+
+	FITPEditDiff Diff = UndoStack.Pop(false);
+	ApplyDiff(Diff, false);
+	RedoStack.Add(MoveTemp(Diff));
+	QueueAnalysis();
+}
+
+void UITPLevelEditorSubsystem::Redo()
+{
+	if (RedoStack.IsEmpty() || StrokeDepth > 0)
+	{
+		return;
+	}
+
+	FITPEditDiff Diff = RedoStack.Pop(false);
+	ApplyDiff(Diff, true);
+	UndoStack.Add(MoveTemp(Diff));
+	QueueAnalysis();
+}
+
+bool UITPLevelEditorSubsystem::Save()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ITPLevelEditorSave);
+
+	if (!IsEditing())
+	{
+		return false;
+	}
+
+	FileHeader.SizeInTiles = SizeInTiles;
+	FileHeader.TileSize = TileMap->TileSize;
+	FileHeader.NumLayers = NumLayers;
+
+	const int64 FileSize = bFileWritten ? IFileManager::Get().FileSize(*Filename) : INDEX_NONE;
+	const bool bCompact = !bFileWritten || FileSize <= 0 || FileHeader.DeadBytes * 2 > FileSize;
+
+	TArray<FITPCookedChunk> Cooked;
+	TArray<FIntPoint> Removed;
+	bool bCooked = true;
+	if (bCompact)
+	{
+		Cooked.Reserve(Chunks.Num());
+		for (TPair<FIntPoint, FITPLevelChunk>& Pair : Chunks)
+		{
+			bCooked &= UITPChunkedLevel::CookChunk(Pair.Value, Cooked.AddDefaulted_GetRef());
+		}
+	}
+	else
+	{
+		for (const FIntPoint& Coord : SaveDirty)
+		{
+			if (FITPLevelChunk* Chunk = Chunks.Find(Coord))
+			{
+				bCooked &= UITPChunkedLevel::CookChunk(*Chunk, Cooked.AddDefaulted_GetRef());
+			}
+			else
+			{
+				Removed.Add(Coord);
+			}
+		}
+	}
+
+	// Nothing is written unless every chunk compressed, so the file never loses a chunk to a failed save
+	const bool bSaved = bCooked && (bCompact
+		? ITPLevelFile::WriteFull(Filename, FileHeader, Cooked, &FileTable)
+		: ITPLevelFile::WriteIncremental(Filename, FileHeader, FileTable, Cooked, Removed));
+	if (!bSaved)
+	{
+		UE_LOG(LogITP, Error, TEXT("Failed to save level %s"), *Filename);
+		return false;
+	}
+
+	if (bCompact)
+	{
+		// WriteFull takes the header by value; mirror what it wrote
+		FileHeader.NumChunks = FileTable.Num();
+		FileHeader.DeadBytes = 0;
+	}
+
+	UE_LOG(LogITP, Log, TEXT("Saved level %s: %d chunk(s) written%s"), *Filename, Cooked.Num(), bCompact ? TEXT(", compacted") : TEXT(""));
+	bFileWritten = true;
+	SaveDirty.Reset();
+	return true;
+}
+
+void UITPLevelEditorSubsystem::StartPlaytest()
+{
+	UWorld* World = GetWorld();
+	APlayerController* PlayerController = World->GetFirstPlayerController();
+	if (!IsEditing() || bPlaytesting || !PlayerController)
+	{
+		return;
+	}
+
+	// Instances must match the edited tiles before anything collides with them
+	Tick(0.f);
+
+	FVector2f StartLocation = ITP2D::TileCenter(FIntPoint(0, SizeInTiles.Y / 2), TileMap->TileSize);
+	for (const TPair<FIntPoint, FITPLevelChunk>& Pair : Chunks)
+	{
+		if (const FITPSpawnEntry* Start = Pair.Value.Spawns.FindByPredicate([](const FITPSpawnEntry& Entry) { return Entry.Type == EITPSpawnType::PlayerStart; }))
+		{
+			StartLocation = Start->Location;
+			break;
+		}
+	}
+
+	const AGameModeBase* GameMode = World->GetAuthGameMode();
+	UClass* PawnClass = GameMode && GameMode->DefaultPawnClass ? GameMode->DefaultPawnClass.Get() : AITPCharacter::StaticClass();
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	APawn* Pawn = World->SpawnActor<APawn>(PawnClass, TileMap->PlaneToWorld(StartLocation), FRotator::ZeroRotator, SpawnParams);
+	if (!Pawn)
+	{
+		return;
+	}
+
+	EditorPawn = PlayerController->GetPawn();
+	PlayPawn = Pawn;
+	PlayerController->Possess(Pawn);
+	bPlaytesting = true;
+}
+
+void UITPLevelEditorSubsystem::StopPlaytest()
+{
+	if (!bPlaytesting)
+	{
+		return;
+	}
+
+	bPlaytesting = false;
+	if (APawn* Pawn = PlayPawn.Get())
+	{
+		Pawn->Destroy();
+	}
+	PlayPawn.Reset();
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (PlayerController && EditorPawn.IsValid())
+	{
+		PlayerController->Possess(EditorPawn.Get());
+	}
+}
+
+FITPLevelChunk& UITPLevelEditorSubsystem::FindOrAddChunk(const FIntPoint& Coord)
+{
+	FITPLevelChunk& Chunk = Chunks.FindOrAdd(Coord);
+	if (Chunk.Tiles.IsEmpty())
+	{
+		Chunk.Coord = Coord;
+		Chunk.Tiles.SetNumZeroed(NumLayers * FITPLevelChunk::TilesPerLayer);
+	}
+	return Chunk;
+}
+
+void UITPLevelEditorSubsystem::SetTile(const FIntPoint& Tile, int32 Layer, uint16 TileId)
+{
+	const FIntPoint Coord = FITPLevelChunk::TileToChunk(Tile);
+	FITPLevelChunk& Chunk = FindOrAddChunk(Coord);
+	const FIntPoint Local = Tile - Coord * FITPLevelChunk::ChunkSize;
+	Chunk.Tiles[FITPLevelChunk::GetTileIndex(Layer, Local.X, Local.Y)] = TileId;
+
+	// Chunks with nothing left in them are not stored
+	if (TileId == 0 && Chunk.Spawns.IsEmpty() && !Chunk.Tiles.ContainsByPredicate([](uint16 Id) { return Id != 0; }))
+	{
+		Chunks.Remove(Coord);
+	}
+	MarkDirty(Coord);
+}
+
+void UITPLevelEditorSubsystem::ApplySpawn(const FITPSpawnEntry& Entry, bool bAdd)
+{
+	const FIntPoint Coord = FITPLevelChunk::TileToChunk(ITP2D::LocationToTile(Entry.Location, TileMap->TileSize));
+	FITPLevelChunk& Chunk = FindOrAddChunk(Coord);
+	if (bAdd)
+	{
+		// Spawn tables stay sorted by type, see FITPLevelChunk
+		const int32 Index = Algo::UpperBoundBy(Chunk.Spawns, Entry.Type, &FITPSpawnEntry::Type);
+		Chunk.Spawns.Insert(Entry, Index);
+	}
+	else
+	{
+		Chunk.Spawns.RemoveAll([&Entry](const FITPSpawnEntry& Other)
+		{
+			return Other.SourceId == Entry.SourceId && Other.Type == Entry.Type && Other.Location == Entry.Location;
+		});
+	}
+	MarkDirty(Coord);
+}
+
+void UITPLevelEditorSubsystem::ApplyDiff(const FITPEditDiff& Diff, bool bForward)
+{
+	if (bForward)
+	{
+		for (const FITPTileChange& Change : Diff.Tiles)
+		{
+			SetTile(Change.Tile, Change.Layer, Change.NewId);
+		}
+		for (const FITPSpawnChange& Change : Diff.Spawns)
+		{
+			ApplySpawn(Change.Entry, Change.bAdded);
+		}
+	}
+	else
+	{
+		for (int32 Index = Diff.Spawns.Num() - 1; Index >= 0; --Index)
+		{
+			ApplySpawn(Diff.Spawns[Index].Entry, !Diff.Spawns[Index].bAdded);
+		}
+		for (int32 Index = Diff.Tiles.Num() - 1; Index >= 0; --Index)
+		{
+			SetTile(Diff.Tiles[Index].Tile, Diff.Tiles[Index].Layer, Diff.Tiles[Index].OldId);
+		}
+	}
+}
+
+void UITPLevelEditorSubsystem::RecordAndCommit(FITPEditDiff&& Diff)
+{
+	if (Diff.IsEmpty())
+	{
+		return;
+	}
+
+	RedoStack.Reset();
+	UndoStack.Add(MoveTemp(Diff));
+	if (UndoStack.Num() > FMath::Max(GITPEditorUndoLimit, 1))
+	{
+		UndoStack.RemoveAt(0, UndoStack.Num() - FMath::Max(GITPEditorUndoLimit, 1), false);
+	}
+	QueueAnalysis();
+}
+
+void UITPLevelEditorSubsystem::MarkDirty(const FIntPoint& ChunkCoord)
+{
+	SaveDirty.Add(ChunkCoord);
+	VisualDirty.Add(ChunkCoord);
+}
+
+void UITPLevelEditorSubsystem::QueueAnalysis()
+{
+	++AnalysisGeneration;
+	AnalysisDelay = GITPEditorReachabilityDelay;
+}
+
+void UITPLevelEditorSubsystem::LaunchAnalysis()
+{
+	TSharedPtr<FITPReachabilityInput> Input = MakeShared<FITPReachabilityInput>();
+	Input->Size = SizeInTiles;
+	Input->Solid.Init(false, SizeInTiles.X * SizeInTiles.Y);
+
+	const float TileSize = TileMap->TileSize;
+	const UITPGameData* GameData = TileMap->GetGameData();
+	bool bHasStart = false;
+	for (const TPair<FIntPoint, FITPLevelChunk>& Pair : Chunks)
+	{
+		const FITPLevelChunk& Chunk = Pair.Value;
+		const FIntPoint Origin = Chunk.Coord * FITPLevelChunk::ChunkSize;
+		for (int32 LocalY = 0; LocalY < FITPLevelChunk::ChunkSize; ++LocalY)
+		{
+			const int32 Y = Origin.Y + LocalY;
+			for (int32 LocalX = 0; LocalX < FITPLevelChunk::ChunkSize; ++LocalX)
+			{
+				const int32 X = Origin.X + LocalX;
+				if (X < SizeInTiles.X && Y < SizeInTiles.Y && AITPTileMapActor::IsSolidTile(Chunk.Tiles[FITPLevelChunk::GetTileIndex(0, LocalX, LocalY)], GameData))
+				{
+					Input->Solid[Y * SizeInTiles.X + X] = true;
+				}
+			}
+		}
+
+		for (const FITPSpawnEntry& Spawn : Chunk.Spawns)
+		{
+			const FIntPoint Tile = ITP2D::LocationToTile(Spawn.Location, TileSize);
+			if (Spawn.Type == EITPSpawnType::PlayerStart && !bHasStart)
+			{
+				Input->Start = Tile;
+				bHasStart = true;
+			}
+			else if (Spawn.Type == EITPSpawnType::Coin || Spawn.Type == EITPSpawnType::Checkpoint)
+			{
+				Input->Targets.Add(Tile);
+			}
+		}
+	}
+
+	// Jump envelope from the playable character's tuning: apex height and the distance covered while airborne
+	const UCharacterMovementComponent* Movement = GetDefault<AITPCharacter>()->GetCharacterMovement();
+	const float Gravity = FMath::Max(FMath::Abs(GetWorld()->GetGravityZ() * Movement->GravityScale), UE_KINDA_SMALL_NUMBER);
+	const float JumpVelocity = Movement->JumpZVelocity;
+	const FITPMoverParams Params;
+	Input->JumpHeight = FMath::FloorToInt32(JumpVelocity * JumpVelocity / (2.f * Gravity) / TileSize);
+	Input->JumpDistance = FMath::FloorToInt32(Movement->MaxWalkSpeed * 2.f * JumpVelocity / Gravity / TileSize);
+	Input->GlideRatio = Movement->MaxWalkSpeed / FMath::Max(ITPToFloat(Params.DescendingRate), UE_KINDA_SMALL_NUMBER);
+
+	LaunchedGeneration = AnalysisGeneration;
+	AnalysisTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Input]()
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ITPReachability);
+		TSharedPtr<FITPReachabilityResult> Result = MakeShared<FITPReachabilityResult>();
+		ITPReachability::Analyze(*Input, *Result);
+		return Result;
+	});
+}
@@ -0,0 +1,131 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+#include "ITPChunkedLevel.h"
+#include "ITPLevelFile.h"
+#include "ITPReachability.h"
+#include "ITPLevelEditorSubsystem.generated.h"
+
+class AITPTileMapActor;
+class APawn;
+
+/** One tile write, kept small since undo history stores thousands of these */
+struct FITPTileChange
+{
+	FIntPoint Tile;
+	uint16 OldId;
+	uint16 NewId;
+	uint8 Layer;
+};
+
+/** Spawn entry added (bAdded) or removed */
+struct FITPSpawnChange
+{
+	FITPSpawnEntry Entry;
+	bool bAdded;
+};
+
+/** Everything one editor action (e.g. a paint stroke) changed; undo applies it backwards */
+struct FITPEditDiff
+{
+	TArray<FITPTileChange> Tiles;
+	TArray<FITPSpawnChange> Spawns;
+
+	bool IsEmpty() const { return Tiles.IsEmpty() && Spawns.IsEmpty(); }
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FITPOnReachabilityUpdated, const FITPReachabilityResult&);
+
+/**
+ * In-game tile level editor.
+ * Edits the chunked tile format directly, keeps multi-level undo as diffs, saves only dirty chunks
+ * (see ITPLevelFile.h), switches to play mode by possessing a freshly spawned AITPCharacter without reloading
+ * the map, and re-runs the reachability analyzer on a worker task shortly after each edit.
+ */
+UCLASS()
+class ITP_API UITPLevelEditorSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+
+	/** Opens SaveFilename if it exists, otherwise starts an empty level of the given size */
+	void StartEditing(AITPTileMapActor* InTileMap, const FString& SaveFilename, FIntPoint NewLevelSize, int32 NewLevelLayers = 1);
+
+	bool IsEditing() const { return TileMap != nullptr; }
+
+	/** Groups the following changes into one undo step */
+	void BeginStroke();
+	void EndStroke();
+
+	void PaintTile(const FIntPoint& Tile, uint16 TileId, int32 Layer = 0);
+	uint16 GetTile(const FIntPoint& Tile, int32 Layer = 0) const;
+
+	void AddSpawn(const FITPSpawnEntry& Entry);
+	void RemoveSpawnsAt(const FIntPoint& Tile);
+
+	void Undo();
+	void Redo();
+
+	/** Writes dirty chunks. Falls back to a full rewrite for new files or when half the file is dead space. */
+	bool Save();
+
+	void StartPlaytest();
+	void StopPlaytest();
+	bool IsPlaytesting() const { return bPlaytesting; }
+
+	const FITPReachabilityResult& GetReachability() const { return Reachability; }
+	FITPOnReachabilityUpdated OnReachabilityUpdated;
+
+	AITPTileMapActor* GetTileMap() const { return TileMap; }
+
+private:
+	FITPLevelChunk& FindOrAddChunk(const FIntPoint& Coord);
+	void SetTile(const FIntPoint& Tile, int32 Layer, uint16 TileId);
+	void ApplySpawn(const FITPSpawnEntry& Entry, bool bAdd);
+	void ApplyDiff(const FITPEditDiff& Diff, bool bForward);
+	void RecordAndCommit(FITPEditDiff&& Diff);
+	void MarkDirty(const FIntPoint& ChunkCoord);
+	void QueueAnalysis();
+	void LaunchAnalysis();
+
+	UPROPERTY(Transient)
+	TObjectPtr<AITPTileMapActor> TileMap;
+
+	FIntPoint SizeInTiles = FIntPoint::ZeroValue;
+	int32 NumLayers = 1;
+	TMap<FIntPoint, FITPLevelChunk> Chunks;
+
+	/** Chunks changed since the last save, and chunks whose instances need rebuilding this frame */
+	TSet<FIntPoint> SaveDirty;
+	TSet<FIntPoint> VisualDirty;
+
+	FString Filename;
+	ITPLevelFile::FHeader FileHeader;
+	TArray<ITPLevelFile::FChunkEntry> FileTable;
+	bool bFileWritten = false;
+
+	TArray<FITPEditDiff> UndoStack;
+	TArray<FITPEditDiff> RedoStack;
+	FITPEditDiff Stroke;
+	int32 StrokeDepth = 0;
+
+	bool bPlaytesting = false;
+	TWeakObjectPtr<APawn> EditorPawn;
+	TWeakObjectPtr<APawn> PlayPawn;
+
+	/** Background reachability; results from superseded runs are dropped */
+	UE::Tasks::TTask<TSharedPtr<FITPReachabilityResult>> AnalysisTask;
+	uint32 AnalysisGeneration = 0;
+	uint32 LaunchedGeneration = 0;
+	float AnalysisDelay = -1.f;
+	FITPReachabilityResult Reachability;
+};
@@ -0,0 +1,313 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPLevelFile.h"
+#include "ITP.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace ITPLevelFile
+{
+	static bool WriteBytes(IFileHandle& File, const TArray<uint8>& Bytes)
+	{
+		return File.Write(Bytes.GetData(), Bytes.Num());
+	}
+
+	/** Writes Header at the current position, which is offset 0 or the end of the file */
+	static bool WriteHeader(IFileHandle& File, FHeader& Header)
+	{
+		TArray<uint8> Bytes;
+		FMemoryWriter Writer(Bytes);
+		Writer << Header;
+		return WriteBytes(File, Bytes);
+	}
+
+	static bool ParseHeader(const TArray<uint8>& Bytes, FHeader& OutHeader)
+	{
+		FMemoryReader Reader(Bytes);
+		Reader << OutHeader;
+		return !Reader.IsError() && OutHeader.Magic == Magic && OutHeader.Version == Version;
+	}
+
+	static bool WriteTable(IFileHandle& File, TArray<FChunkEntry>& Table)
+	{
+		TArray<uint8> Bytes;
+		FMemoryWriter Writer(Bytes);
+		for (FChunkEntry& Entry : Table)
+		{
+			Writer << Entry;
+		}
+		return WriteBytes(File, Bytes);
+	}
+
+	bool WriteFull(const FString& Filename, FHeader Header, TConstArrayView<FITPCookedChunk> Chunks, TArray<FChunkEntry>* OutTable)
+	{
+		IFileManager::Get().MakeDirectory(*FPaths::GetPath(Filename), true);
+		TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*Filename, false, true));
+		if (!File)
+		{
+			UE_LOG(LogITP, Error, TEXT("Could not write level file '%s'"), *Filename);
+			return false;
+		}
+
+		TArray<FChunkEntry> Table;
+		Table.Reserve(Chunks.Num());
+
+		bool bOk = File->Seek(FHeader::Size);
+		for (const FITPCookedChunk& Chunk : Chunks)
+		{
+			FChunkEntry& Entry = Table.AddDefaulted_GetRef();
+			Entry.Coord = Chunk.Coord;
+			Entry.SourceHash = Chunk.SourceHash;
+			Entry.UncompressedSize = Chunk.UncompressedSize;
+			Entry.CompressedSize = Chunk.CompressedData.Num();
+			Entry.Offset = File->Tell();
+			bOk &= WriteBytes(*File, Chunk.CompressedData);
+		}
+
+		Header.NumChunks = Table.Num();
+		Header.ChunkTableOffset = File->Tell();
+		Header.DeadBytes = 0;
+		bOk &= WriteTable(*File, Table);
+
+		// This handle truncated the file and does not append, so the header at offset 0 can be written last
+		bOk &= WriteHeader(*File, Header);
+		bOk &= File->Seek(0) && WriteHeader(*File, Header);
+
+		if (OutTable)
+		{
+			*OutTable = MoveTemp(Table);
+		}
+		return bOk;
+	}
+
+	bool WriteIncremental(const FString& Filename, FHeader& InOutHeader, TArray<FChunkEntry>& InOutTable, TConstArrayView<FITPCookedChunk> Dirty, TConstArrayView<FIntPoint> Removed)
+	{
+		TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*Filename, true, true));
+		if (!File)
+		{
+			UE_LOG(LogITP, Error, TEXT("Could not open level file '%s' for update"), *Filename);
+			return false;
+		}
+
+		// The old table and trailer become dead space once the new ones are written
+		int64 DeadBytes = InOutHeader.DeadBytes + (int64)InOutTable.Num() * FChunkEntry::Size + FHeader::Size;
+
+		// Everything goes at the end, whether or not the platform honours seeks on an append handle
+		bool bOk = File->SeekFromEnd(0);
+		for (const FITPCookedChunk& Chunk : Dirty)
+		{
+			FChunkEntry* Entry = InOutTable.FindByPredicate([&Chunk](const FChunkEntry& Existing) { return Existing.Coord == Chunk.Coord; });
+			if (Entry)
+			{
+				DeadBytes += Entry->CompressedSize;
+			}
+			else
+			{
+				Entry = &InOutTable.AddDefaulted_GetRef();
+				Entry->Coord = Chunk.Coord;
+			}
+
+			Entry->SourceHash = Chunk.SourceHash;
+			Entry->UncompressedSize = Chunk.UncompressedSize;
+			Entry->CompressedSize = Chunk.CompressedData.Num();
+			Entry->Offset = File->Tell();
+			bOk &= WriteBytes(*File, Chunk.CompressedData);
+		}
+
+		for (const FIntPoint& Coord : Removed)
+		{
+			const int32 Index = InOutTable.IndexOfByPredicate([&Coord](const FChunkEntry& Existing) { return Existing.Coord == Coord; });
+			if (Index != INDEX_NONE)
+			{
+				DeadBytes += InOutTable[Index].CompressedSize;
+				InOutTable.RemoveAtSwap(Index, 1, false);
+			}
+		}
+
+		InOutHeader.NumChunks = InOutTable.Num();
+		InOutHeader.ChunkTableOffset = File->Tell();
+		InOutHeader.DeadBytes = DeadBytes;
+		bOk &= WriteTable(*File, InOutTable);
+
+		// Trailer last: until it is complete, ReadHeader falls back to the header of the last full write
+		bOk &= WriteHeader(*File, InOutHeader);
+		return bOk;
+	}
+
+	bool ReadHeader(IFileHandle& File, FHeader& OutHeader)
+	{
+		TArray<uint8> Bytes;
+		Bytes.SetNumUninitialized(FHeader::Size);
+
+		// A trailer only counts if it sits right behind the table it points at; a torn save leaves garbage there
+		const int64 TrailerOffset = File.Size() - FHeader::Size;
+		FHeader Trailer;
+		if (TrailerOffset >= FHeader::Size && File.Seek(TrailerOffset) && File.Read(Bytes.GetData(), Bytes.Num())
+			&& ParseHeader(Bytes, Trailer)
+			&& Trailer.NumChunks >= 0 && Trailer.ChunkTableOffset >= FHeader::Size
+			&& Trailer.ChunkTableOffset + (int64)Trailer.NumChunks * FChunkEntry::Size == TrailerOffset)
+		{
+			OutHeader = Trailer;
+			return true;
+		}
+
+		return File.Seek(0) && File.Read(Bytes.GetData(), Bytes.Num()) && ParseHeader(Bytes, OutHeader);
+	}
+
+	bool ReadTable(IFileHandle& File, const FHeader& Header, TArray<FChunkEntry>& OutTable)
+	{
+		TArray<uint8> Bytes;
+		Bytes.SetNumUninitialized(Header.NumChunks * FChunkEntry::Size);
+		if (!File.Seek(Header.ChunkTableOffset) || !File.Read(Bytes.GetData(), Bytes.Num()))
+		{
+			return false;
+		}
+
+		FMemoryReader Reader(Bytes);
+		OutTable.SetNum(Header.NumChunks);
+		for (FChunkEntry& Entry : OutTable)
+		{
+			Reader << Entry;
+		}
+		return !Reader.IsError();
+	}
+
+	bool ReadChunk(IFileHandle& File, const FChunkEntry& Entry, FITPCookedChunk& OutChunk)
+	{
+		OutChunk.Coord = Entry.Coord;
+		OutChunk.SourceHash = Entry.SourceHash;
+		OutChunk.UncompressedSize = Entry.UncompressedSize;
+		OutChunk.CompressedData.SetNumUninitialized(Entry.CompressedSize);
+		return File.Seek(Entry.Offset) && File.Read(OutChunk.CompressedData.GetData(), Entry.CompressedSize);
+	}
+}
+
+namespace ITPLevelFileTest
+{
+	using namespace ITPLevelFile;
+
+	/** A chunk whose tiles all hold Fill, so a reload shows which save it came from */
+	static FITPCookedChunk MakeChunk(const FIntPoint& Coord, uint16 Fill)
+	{
+		FITPLevelChunk Chunk;
+		Chunk.Coord = Coord;
+		Chunk.Tiles.Init(Fill, FITPLevelChunk::TilesPerLayer);
+		FITPCookedChunk Cooked;
+		UITPChunkedLevel::CookChunk(Chunk, Cooked);
+		return Cooked;
+	}
+
+	/** Reopens the file from scratch and returns the fill of every chunk it holds, or false if it does not read back */
+	static bool Reload(const FString& Filename, TMap<FIntPoint, uint16>& OutFills, FHeader& OutHeader)
+	{
+		OutFills.Reset();
+		TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Filename));
+		TArray<FChunkEntry> Table;
+		if (!File || !ReadHeader(*File, OutHeader) || !ReadTable(*File, OutHeader, Table))
+		{
+			return false;
+		}
+
+		for (const FChunkEntry& Entry : Table)
+		{
+			FITPCookedChunk Cooked;
+			FITPLevelChunk Chunk;
+			if (!ReadChunk(*File, Entry, Cooked) || !UITPChunkedLevel::UncompressChunk(Cooked, Chunk) || Chunk.Coord != Entry.Coord)
+			{
+				return false;
+			}
+			OutFills.Add(Entry.Coord, Chunk.Tiles[0]);
+		}
+		return true;
+	}
+
+	/**
+	 * A full save of three chunks, then incremental saves that change, add and remove chunks, reopening the file
+	 * after each. Every reload must hold exactly the chunks of the latest save, with the dead bytes it left behind.
+	 */
+	static void SelfTest()
+	{
+		const FString Filename = FPaths::ProjectSavedDir() / TEXT("ITP") / TEXT("LevelFileSelfTest.itplevel");
+		TMap<FIntPoint, uint16> Expected;
+		TMap<FIntPoint, uint16> Loaded;
+		TArray<FChunkEntry> Table;
+		FHeader Header;
+		Header.NumLayers = 1;
+		int64 ExpectedDeadBytes = 0;
+		TArray<const TCHAR*> Failures;
+
+		const auto Check = [&](const TCHAR* Name, bool bWritten)
+		{
+			FHeader Reloaded;
+			if (!bWritten || !Reload(Filename, Loaded, Reloaded) || !Loaded.OrderIndependentCompareEqual(Expected)
+				|| Reloaded.NumChunks != Expected.Num() || Reloaded.DeadBytes != ExpectedDeadBytes)
+			{
+				Failures.Add(Name);
+			}
+		};
+
+		const auto SaveIncremental = [&](const TCHAR* Name, const TArray<TPair<FIntPoint, uint16>>& Changed, const TArray<FIntPoint>& Removed)
+		{
+			// Same accounting WriteIncremental must do: old table and trailer, plus every replaced or removed blob
+			ExpectedDeadBytes += (int64)Table.Num() * FChunkEntry::Size + FHeader::Size;
+			TArray<FITPCookedChunk> Dirty;
+			for (const TPair<FIntPoint, uint16>& Pair : Changed)
+			{
+				if (const FChunkEntry* Entry = Table.FindByPredicate([&Pair](const FChunkEntry& Existing) { return Existing.Coord == Pair.Key; }))
+				{
+					ExpectedDeadBytes += Entry->CompressedSize;
+				}
+				Dirty.Add(MakeChunk(Pair.Key, Pair.Value));
+				Expected.Add(Pair.Key, Pair.Value);
+			}
+			for (const FIntPoint& Coord : Removed)
+			{
+				if (const FChunkEntry* Entry = Table.FindByPredicate([&Coord](const FChunkEntry& Existing) { return Existing.Coord == Coord; }))
+				{
+					ExpectedDeadBytes += Entry->CompressedSize;
+				}
+				Expected.Remove(Coord);
+			}
+			Check(Name, WriteIncremental(Filename, Header, Table, Dirty, Removed));
+		};
+
+		const TArray<FITPCookedChunk> Initial = { MakeChunk(FIntPoint(0, 0), 1), MakeChunk(FIntPoint(1, 0), 2), MakeChunk(FIntPoint(2, 0), 3) };
+		Expected = { { FIntPoint(0, 0), 1 }, { FIntPoint(1, 0), 2 }, { FIntPoint(2, 0), 3 } };
+		Check(TEXT("full save"), WriteFull(Filename, Header, Initial, &Table));
+		Header.NumChunks = Table.Num();
+
+		SaveIncremental(TEXT("first incremental save"), { { FIntPoint(1, 0), 20 }, { FIntPoint(3, 0), 4 } }, { FIntPoint(2, 0) });
+		SaveIncremental(TEXT("second incremental save"), { { FIntPoint(0, 0), 10 }, { FIntPoint(1, 0), 200 } }, {});
+
+		// A save torn before its trailer must fall back to a readable file, not to garbage
+		{
+			TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*Filename, true, true));
+			const TArray<uint8> Torn = MakeChunk(FIntPoint(5, 5), 9).CompressedData;
+			FHeader Reloaded;
+			if (!File || !File->SeekFromEnd(0) || !File->Write(Torn.GetData(), Torn.Num()))
+			{
+				Failures.Add(TEXT("torn save"));
+			}
+			File.Reset();
+			Expected = { { FIntPoint(0, 0), 1 }, { FIntPoint(1, 0), 2 }, { FIntPoint(2, 0), 3 } };
+			if (!Reload(Filename, Loaded, Reloaded) || !Loaded.OrderIndependentCompareEqual(Expected))
+			{
+				Failures.Add(TEXT("torn save"));
+			}
+		}
+
+		IFileManager::Get().Delete(*Filename);
+		UE_LOG(LogITP, Display, TEXT("Level file self test %s%s"), Failures.Num() == 0 ? TEXT("passed") : TEXT("FAILED: "),
+			*FString::Join(Failures, TEXT(", ")));
+	}
+
+	static FAutoConsoleCommand SelfTestCommand(
+		TEXT("ITP.LevelFile.SelfTest"),
+		TEXT("Writes a level file in full and incrementally under Saved/ITP, reloading it after every save, and checks that a torn save leaves it readable."),
+		FConsoleCommandDelegate::CreateStatic(&SelfTest));
+}
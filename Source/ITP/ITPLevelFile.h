@@ -0,0 +1,79 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ITPChunkedLevel.h"
+
+class IFileHandle;
+
+/**
+ * On-disk form of an ITP chunked level, used for levels built in the in-game editor and for user level files.
+ *
+ * Layout: fixed size header, chunk blobs, chunk table, then a copy of the header as a trailer. Saves are log
+ * structured: dirty chunks, a new table and a new trailer pointing at it are appended, so a save costs
+ * O(dirty chunks). Nothing is ever written before the end of an existing file: platform files opened for append
+ * may ignore seeks (O_APPEND), and none can be opened for writing without either appending or truncating.
+ * ReadHeader takes the trailer when it directly follows its table, which a torn save cannot produce, and the
+ * header at offset 0 (the last full write) otherwise. Dead blobs are dropped by a full rewrite once they exceed
+ * half the file.
+ */
+namespace ITPLevelFile
+{
+	constexpr uint32 Magic = 0x4C505449; // "ITPL"
+	constexpr uint32 Version = 1;
+
+	struct FHeader
+	{
+		uint32 Magic = ITPLevelFile::Magic;
+		uint32 Version = ITPLevelFile::Version;
+		FIntPoint SizeInTiles = FIntPoint::ZeroValue;
+		float TileSize = ITP2D::DefaultTileSize;
+		int32 NumLayers = 0;
+		int32 NumChunks = 0;
+		int64 ChunkTableOffset = 0;
+
+		/** Bytes occupied by blobs no longer referenced from the table */
+		int64 DeadBytes = 0;
+
+		/** Serialized size, constant so the header can be rewritten in place */
+		static constexpr int64 Size = 4 + 4 + 8 + 4 + 4 + 4 + 8 + 8;
+
+		friend FArchive& operator<<(FArchive& Ar, FHeader& Header)
+		{
+			Ar << Header.Magic << Header.Version << Header.SizeInTiles << Header.TileSize << Header.NumLayers << Header.NumChunks << Header.ChunkTableOffset << Header.DeadBytes;
+			return Ar;
+		}
+	};
+
+	struct FChunkEntry
+	{
+		FIntPoint Coord = FIntPoint::ZeroValue;
+		uint64 SourceHash = 0;
+		int32 UncompressedSize = 0;
+		int32 CompressedSize = 0;
+		int64 Offset = 0;
+
+		static constexpr int64 Size = 8 + 8 + 4 + 4 + 8;
+
+		friend FArchive& operator<<(FArchive& Ar, FChunkEntry& Entry)
+		{
+			Ar << Entry.Coord << Entry.SourceHash << Entry.UncompressedSize << Entry.CompressedSize << Entry.Offset;
+			return Ar;
+		}
+	};
+
+	/** Writes a complete file with no dead space */
+	ITP_API bool WriteFull(const FString& Filename, FHeader Header, TConstArrayView<FITPCookedChunk> Chunks, TArray<FChunkEntry>* OutTable = nullptr);
+
+	/**
+	 * Appends Dirty chunks, a new table and a new trailer to an existing file, replacing entries with the same Coord
+	 * and removing entries listed in Removed. InOutTable must be the file's current table.
+	 */
+	ITP_API bool WriteIncremental(const FString& Filename, FHeader& InOutHeader, TArray<FChunkEntry>& InOutTable, TConstArrayView<FITPCookedChunk> Dirty, TConstArrayView<FIntPoint> Removed);
+
+	/** Reads the header of the file's latest complete save: the trailer if it is intact, else the header at offset 0 */
+	ITP_API bool ReadHeader(IFileHandle& File, FHeader& OutHeader);
+	ITP_API bool ReadTable(IFileHandle& File, const FHeader& Header, TArray<FChunkEntry>& OutTable);
+	ITP_API bool ReadChunk(IFileHandle& File, const FChunkEntry& Entry, FITPCookedChunk& OutChunk);
+}
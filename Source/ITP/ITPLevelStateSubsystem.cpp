@@ -0,0 +1,368 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPLevelStateSubsystem.h"
+#include "ITP.h"
+#include "ITPCoin.h"
+#include "ITPPlayerController.h"
+#include "ITPRunLength.h"
+#include "ITPTileMapActor.h"
+#include "Algo/Sort.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Level State Events Sent"), STAT_ITPLevelStateEvents, STATGROUP_ITP);
+
+static int32 GITPLevelStatePartBytes = 1024;
+static FAutoConsoleVariableRef CVarITPLevelStatePartBytes(
+	TEXT("ITP.LevelState.PartBytes"),
+	GITPLevelStatePartBytes,
+	TEXT("Largest level state snapshot RPC payload. Must stay below net.MaxRepArraySize."));
+
+/** Events per delta RPC, below the default net.MaxRepArraySize of 2048 */
+static constexpr int32 MaxEventsPerDelta = 1024;
+
+void UITPLevelStateSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Placed coins exist on every machine under the same names, so name order is a shared numbering
+	TArray<AITPCoin*> Coins;
+	for (TActorIterator<AITPCoin> It(&InWorld); It; ++It)
+	{
+		if (It->IsNetStartupActor())
+		{
+			Coins.Add(*It);
+		}
+	}
+	Algo::Sort(Coins, [](const AITPCoin* A, const AITPCoin* B) { return A->GetFName().LexicalLess(B->GetFName()); });
+
+	Entities.Reset(Coins.Num());
+	for (int32 Id = 0; Id < Coins.Num(); ++Id)
+	{
+		Coins[Id]->SetLevelStateId(Id);
+		Entities.Add(Coins[Id]);
+	}
+
+	// A snapshot may have arrived before the world began play
+	if (CollectedEntities.Num() == Entities.Num())
+	{
+		ApplyEntities(CollectedEntities, false);
+	}
+	else
+	{
+		UE_CLOG(CollectedEntities.Num() > 0, LogITP, Warning, TEXT("Level state has %d entities, the level %d; ignoring collected coins"), CollectedEntities.Num(), Entities.Num());
+		CollectedEntities.Init(false, Entities.Num());
+	}
+}
+
+void UITPLevelStateSubsystem::Tick(float DeltaTime)
+{
+	if (PendingEvents.IsEmpty())
+	{
+		return;
+	}
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		AITPPlayerController* PlayerController = Cast<AITPPlayerController>(It->Get());
+		if (!PlayerController || !PlayerController->bLevelStateSent || PlayerController->IsLocalController())
+		{
+			continue;
+		}
+
+		for (int32 First = 0; First < PendingEvents.Num(); First += MaxEventsPerDelta)
+		{
+			const int32 Num = FMath::Min(MaxEventsPerDelta, PendingEvents.Num() - First);
+			PlayerController->ClientReceiveLevelStateDelta(TArray<uint32>(PendingEvents.GetData() + First, Num));
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_ITPLevelStateEvents, PendingEvents.Num());
+	PendingEvents.Reset();
+}
+
+TStatId UITPLevelStateSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UITPLevelStateSubsystem, STATGROUP_ITP);
+}
+
+bool UITPLevelStateSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UITPLevelStateSubsystem::SetTileMap(AITPTileMapActor* InTileMap)
+{
+	TileMap = InTileMap;
+	SizeInTiles = InTileMap ? InTileMap->GetSizeInTiles() : FIntPoint::ZeroValue;
+
+	// Clients keep a snapshot that arrived before the level was built and apply it now
+	const int32 NumTiles = SizeInTiles.X * SizeInTiles.Y;
+	if (GetWorld()->GetNetMode() != NM_Client || BrokenTiles.Num() != NumTiles)
+	{
+		UE_CLOG(GetWorld()->GetNetMode() == NM_Client && BrokenTiles.Num() > 0, LogITP, Warning,
+			TEXT("Level state has %d tiles, the level %d; ignoring broken tiles"), BrokenTiles.Num(), NumTiles);
+		BrokenTiles.Init(false, NumTiles);
+		return;
+	}
+
+	ApplyTiles(BrokenTiles);
+}
+
+bool UITPLevelStateSubsystem::BreakTile(AITPTileMapActor* InTileMap, const FIntPoint& Tile)
+{
+	if (!InTileMap || TileMap.Get() != InTileMap)
+	{
+		return false;
+	}
+
+	const int32 Index = TileIndex(Tile);
+	if (Index == INDEX_NONE || BrokenTiles[Index] || !InTileMap->IsBreakableTile(InTileMap->GetTile(Tile)))
+	{
+		return false;
+	}
+
+	InTileMap->ClearTiles(MakeArrayView(&Tile, 1));
+	BrokenTiles[Index] = true;
+	PendingEvents.Add((uint32)Index);
+	return true;
+}
+
+void UITPLevelStateSubsystem::CollectEntity(int32 EntityId)
+{
+	if (!CollectedEntities.IsValidIndex(EntityId) || CollectedEntities[EntityId])
+	{
+		return;
+	}
+
+	CollectedEntities[EntityId] = true;
+	PendingEvents.Add(EntityEventBit | (uint32)EntityId);
+}
+
+void UITPLevelStateSubsystem::SendSnapshot(AITPPlayerController* PlayerController)
+{
+	if (!PlayerController || PlayerController->IsLocalController())
+	{
+		return;
+	}
+
+	TArray<uint8> Data;
+	EncodeSnapshot(BrokenTiles, CollectedEntities, Data);
+
+	const int32 PartBytes = FMath::Clamp(GITPLevelStatePartBytes, 64, 2048);
+	const int32 NumParts = FMath::Max(FMath::DivideAndRoundUp(Data.Num(), PartBytes), 1);
+	for (int32 Part = 0; Part < NumParts; ++Part)
+	{
+		const int32 First = Part * PartBytes;
+		PlayerController->ClientReceiveLevelState(Part, NumParts, TArray<uint8>(Data.GetData() + First, FMath::Min(PartBytes, Data.Num() - First)));
+	}
+
+	// Reliable RPCs on one channel stay ordered, so deltas can follow right away
+	PlayerController->bLevelStateSent = true;
+	LastSnapshotBytes = Data.Num();
+
+	UE_LOG(LogITP, Verbose, TEXT("Level state snapshot for %s: %d bytes in %d part(s), %d broken tile(s), %d collected"),
+		*PlayerController->GetName(), Data.Num(), NumParts, GetNumBrokenTiles(), GetNumCollected());
+}
+
+void UITPLevelStateSubsystem::ReceiveSnapshotPart(int32 Part, int32 NumParts, const TArray<uint8>& Data)
+{
+	if (Part == 0 || SnapshotParts.Num() != NumParts)
+	{
+		SnapshotParts.Reset();
+		SnapshotParts.SetNum(NumParts);
+		NumSnapshotPartsReceived = 0;
+	}
+	if (!SnapshotParts.IsValidIndex(Part))
+	{
+		return;
+	}
+
+	SnapshotParts[Part] = Data;
+	if (++NumSnapshotPartsReceived < NumParts)
+	{
+		return;
+	}
+
+	TArray<uint8> Snapshot;
+	for (const TArray<uint8>& SnapshotPart : SnapshotParts)
+	{
+		Snapshot.Append(SnapshotPart);
+	}
+	SnapshotParts.Reset();
+	NumSnapshotPartsReceived = 0;
+	LastSnapshotBytes = Snapshot.Num();
+
+	TBitArray<> Tiles;
+	TBitArray<> Collected;
+	if (!DecodeSnapshot(Snapshot, Tiles, Collected))
+	{
+		UE_LOG(LogITP, Warning, TEXT("Level state snapshot is corrupt (%d bytes)"), Snapshot.Num());
+		return;
+	}
+
+	BrokenTiles = MoveTemp(Tiles);
+	CollectedEntities = MoveTemp(Collected);
+
+	// Whatever is not loaded yet picks the bits up in SetTileMap / OnWorldBeginPlay
+	if (TileMap.IsValid() && BrokenTiles.Num() == SizeInTiles.X * SizeInTiles.Y)
+	{
+		ApplyTiles(BrokenTiles);
+	}
+	if (CollectedEntities.Num() == Entities.Num())
+	{
+		ApplyEntities(CollectedEntities, false);
+	}
+}
+
+void UITPLevelStateSubsystem::ApplyEvents(TConstArrayView<uint32> Events)
+{
+	TArray<FIntPoint> Tiles;
+	for (const uint32 Event : Events)
+	{
+		const int32 Index = (int32)(Event & ~EntityEventBit);
+		if (Event & EntityEventBit)
+		{
+			if (CollectedEntities.IsValidIndex(Index) && !CollectedEntities[Index])
+			{
+				CollectedEntities[Index] = true;
+				if (AITPCoin* Coin = Entities.IsValidIndex(Index) ? Entities[Index].Get() : nullptr)
+				{
+					Coin->Collect(true);
+				}
+			}
+		}
+		else if (BrokenTiles.IsValidIndex(Index) && !BrokenTiles[Index])
+		{
+			BrokenTiles[Index] = true;
+			Tiles.Add(IndexToTile(Index));
+		}
+	}
+
+	if (AITPTileMapActor* Map = TileMap.Get(); Map && Tiles.Num() > 0)
+	{
+		Map->ClearTiles(Tiles);
+	}
+}
+
+void UITPLevelStateSubsystem::EncodeSnapshot(const TBitArray<>& Tiles, const TBitArray<>& Collected, TArray<uint8>& Out)
+{
+	ITPRunLength::WriteVarInt(Out, (uint32)Tiles.Num());
+	ITPRunLength::WriteVarInt(Out, (uint32)Collected.Num());
+	ITPRunLength::EncodeBits(Tiles, Out);
+	ITPRunLength::EncodeBits(Collected, Out);
+}
+
+bool UITPLevelStateSubsystem::DecodeSnapshot(TConstArrayView<uint8> Data, TBitArray<>& OutTiles, TBitArray<>& OutCollected)
+{
+	const uint8* Cursor = Data.GetData();
+	const uint8* End = Cursor + Data.Num();
+
+	// Sizes come off the wire, so bound them before allocating
+	uint32 NumTiles;
+	uint32 NumCollected;
+	if (!ITPRunLength::ReadVarInt(Cursor, End, NumTiles) || !ITPRunLength::ReadVarInt(Cursor, End, NumCollected)
+		|| NumTiles > (uint32)MAX_int32 / 2 || NumCollected > (uint32)MAX_int32 / 2)
+	{
+		return false;
+	}
+
+	return ITPRunLength::DecodeBits(Cursor, End, (int32)NumTiles, OutTiles)
+		&& ITPRunLength::DecodeBits(Cursor, End, (int32)NumCollected, OutCollected)
+		&& Cursor == End;
+}
+
+int32 UITPLevelStateSubsystem::TileIndex(const FIntPoint& Tile) const
+{
+	if (Tile.X < 0 || Tile.Y < 0 || Tile.X >= SizeInTiles.X || Tile.Y >= SizeInTiles.Y)
+	{
+		return INDEX_NONE;
+	}
+	return Tile.Y * SizeInTiles.X + Tile.X;
+}
+
+FIntPoint UITPLevelStateSubsystem::IndexToTile(int32 Index) const
+{
+	return FIntPoint(Index % SizeInTiles.X, Index / SizeInTiles.X);
+}
+
+void UITPLevelStateSubsystem::ApplyTiles(const TBitArray<>& Tiles)
+{
+	AITPTileMapActor* Map = TileMap.Get();
+	if (!Map)
+	{
+		return;
+	}
+
+	TArray<FIntPoint> Broken;
+	for (TConstSetBitIterator<> It(Tiles); It; ++It)
+	{
+		Broken.Add(IndexToTile(It.GetIndex()));
+	}
+	Map->ClearTiles(Broken);
+}
+
+void UITPLevelStateSubsystem::ApplyEntities(const TBitArray<>& Collected, bool bPlayEffects)
+{
+	for (TConstSetBitIterator<> It(Collected); It; ++It)
+	{
+		if (AITPCoin* Coin = Entities.IsValidIndex(It.GetIndex()) ? Entities[It.GetIndex()].Get() : nullptr)
+		{
+			Coin->Collect(bPlayEffects);
+		}
+	}
+}
+
+static FAutoConsoleCommandWithWorld CmdITPLevelStateReport(
+	TEXT("ITP.LevelState.Report"),
+	TEXT("Logs broken tiles, collected coins and the size of the last join snapshot."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UITPLevelStateSubsystem* LevelState = World ? World->GetSubsystem<UITPLevelStateSubsystem>() : nullptr)
+		{
+			UE_LOG(LogITP, Log, TEXT("Level state: %d broken tile(s), %d collected coin(s), last snapshot %d bytes"),
+				LevelState->GetNumBrokenTiles(), LevelState->GetNumCollected(), LevelState->GetLastSnapshotBytes());
+		}
+	}));
+
+static FAutoConsoleCommand CmdITPLevelStateBenchmark(
+	TEXT("ITP.LevelState.Benchmark"),
+	TEXT("ITP.LevelState.Benchmark [Width=20000] [Height=32] [Coins=5000] [BrokenPercent=3]: join snapshot size and coding time for a fully played level."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 Width = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 20000;
+		const int32 Height = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 32;
+		const int32 NumCoins = Args.Num() > 2 ? FMath::Max(FCString::Atoi(*Args[2]), 0) : 5000;
+		const float BrokenPercent = Args.Num() > 3 ? FCString::Atof(*Args[3]) : 3.f;
+
+		// Fully played: every coin collected, breakable blocks scattered at random (the worst case for run lengths)
+		FRandomStream Random(Width);
+		TBitArray<> Tiles(false, Width * Height);
+		for (int32 Index = 0; Index < Tiles.Num(); ++Index)
+		{
+			Tiles[Index] = Random.FRand() * 100.f < BrokenPercent;
+		}
+		const TBitArray<> Collected(true, NumCoins);
+
+		const double EncodeStart = FPlatformTime::Seconds();
+		TArray<uint8> Data;
+		UITPLevelStateSubsystem::EncodeSnapshot(Tiles, Collected, Data);
+		const double EncodeSeconds = FPlatformTime::Seconds() - EncodeStart;
+
+		const double DecodeStart = FPlatformTime::Seconds();
+		TBitArray<> DecodedTiles;
+		TBitArray<> DecodedCollected;
+		const bool bDecoded = UITPLevelStateSubsystem::DecodeSnapshot(Data, DecodedTiles, DecodedCollected);
+		const double DecodeSeconds = FPlatformTime::Seconds() - DecodeStart;
+
+		const int32 NumBroken = Tiles.CountSetBits();
+		const int32 RawBytes = FMath::DivideAndRoundUp(Tiles.Num() + Collected.Num(), 8);
+		UE_LOG(LogITP, Log, TEXT("Level state: %dx%d tiles (%d broken), %d coins collected: %d bytes raw, %d bytes on join (%.2f bytes per change), %d part(s), encode %.2f ms, decode %.2f ms, round trip %s"),
+			Width, Height, NumBroken, NumCoins, RawBytes, Data.Num(),
+			(NumBroken + NumCoins) > 0 ? (double)Data.Num() / (NumBroken + NumCoins) : 0.0,
+			FMath::Max(FMath::DivideAndRoundUp(Data.Num(), FMath::Clamp(GITPLevelStatePartBytes, 64, 2048)), 1),
+			EncodeSeconds * 1000.0, DecodeSeconds * 1000.0,
+			bDecoded && DecodedTiles == Tiles && DecodedCollected == Collected ? TEXT("ok") : TEXT("FAILED"));
+	}));
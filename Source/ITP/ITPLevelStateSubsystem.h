@@ -0,0 +1,82 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ITPLevelStateSubsystem.generated.h"
+
+class AITPCoin;
+class AITPPlayerController;
+class AITPTileMapActor;
+
+/**
+ * Which tiles are broken and which level entities are collected, as two bitsets.
+ * Entities are the coins placed in the level, numbered by name so server and clients agree without
+ * replicating them. A joining player gets both bitsets once, run-length coded (ITPRunLength.h); after that
+ * every change goes out as one packed event per frame batch, instead of one actor channel per coin or block.
+ */
+UCLASS()
+class ITP_API UITPLevelStateSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** The tile map whose tiles are tracked; called when it loads a level */
+	void SetTileMap(AITPTileMapActor* InTileMap);
+
+	/** Server: knocks out a breakable tile of TileMap. False if it is not the tracked map or not breakable. */
+	bool BreakTile(AITPTileMapActor* TileMap, const FIntPoint& Tile);
+
+	/** Server: marks a placed coin collected */
+	void CollectEntity(int32 EntityId);
+
+	/** Server: sends the current state to a newly joined player; deltas follow from the next flush */
+	void SendSnapshot(AITPPlayerController* PlayerController);
+
+	/** Client */
+	void ReceiveSnapshotPart(int32 Part, int32 NumParts, const TArray<uint8>& Data);
+	void ApplyEvents(TConstArrayView<uint32> Events);
+
+	/** Run-length coded tile and entity bitsets, as sent on join */
+	static void EncodeSnapshot(const TBitArray<>& Tiles, const TBitArray<>& Entities, TArray<uint8>& Out);
+	static bool DecodeSnapshot(TConstArrayView<uint8> Data, TBitArray<>& OutTiles, TBitArray<>& OutEntities);
+
+	int32 GetNumBrokenTiles() const { return BrokenTiles.CountSetBits(); }
+	int32 GetNumCollected() const { return CollectedEntities.CountSetBits(); }
+	int32 GetLastSnapshotBytes() const { return LastSnapshotBytes; }
+
+	/** Packed event: the top bit tells entities from tiles, the rest is the index */
+	static constexpr uint32 EntityEventBit = 1u << 31;
+
+private:
+	int32 TileIndex(const FIntPoint& Tile) const;
+	FIntPoint IndexToTile(int32 Index) const;
+
+	/** Brings the world in line with the bitsets, e.g. after a snapshot or once the tile map loaded */
+	void ApplyTiles(const TBitArray<>& Tiles);
+	void ApplyEntities(const TBitArray<>& Entities, bool bPlayEffects);
+
+	TWeakObjectPtr<AITPTileMapActor> TileMap;
+	FIntPoint SizeInTiles = FIntPoint::ZeroValue;
+
+	/** Indexed by entity id */
+	TArray<TWeakObjectPtr<AITPCoin>> Entities;
+
+	TBitArray<> BrokenTiles;
+	TBitArray<> CollectedEntities;
+
+	/** Server: events since the last flush */
+	TArray<uint32> PendingEvents;
+
+	/** Client: snapshot parts received so far */
+	TArray<TArray<uint8>> SnapshotParts;
+	int32 NumSnapshotPartsReceived = 0;
+
+	int32 LastSnapshotBytes = 0;
+};
@@ -0,0 +1,356 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPMatchHostSubsystem.h"
+#include "ITP.h"
+#include "Containers/Ticker.h"
+#include "Engine/Engine.h"
+#include "Engine/GameEngine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/PackageName.h"
+#include "Misc/PackagePath.h"
+#include "UObject/LinkerInstancingContext.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectGlobals.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Hosted Matches"), STAT_ITPHostedMatches, STATGROUP_ITP);
+
+static int32 GITPMatchBasePort = 7787;
+static FAutoConsoleVariableRef CVarITPMatchBasePort(
+	TEXT("ITP.Match.BasePort"),
+	GITPMatchBasePort,
+	TEXT("First listen port for hosted matches; each match takes the lowest free port from here."));
+
+static constexpr double BytesPerMB = 1024.0 * 1024.0;
+
+UWorld* FITPHostedMatch::GetWorld() const
+{
+	return GameInstance ? GameInstance->GetWorld() : nullptr;
+}
+
+void UITPMatchHostSubsystem::Deinitialize()
+{
+	StopAllMatches();
+
+	Super::Deinitialize();
+}
+
+int32 UITPMatchHostSubsystem::StartMatch(const FString& MapName, const FString& Options)
+{
+	if (!FPackageName::DoesPackageExist(MapName))
+	{
+		UE_LOG(LogITP, Warning, TEXT("Cannot host a match on %s: no such map"), *MapName);
+		return INDEX_NONE;
+	}
+
+	// Same game instance class as the process's own, so per-run subsystems exist once per match
+	UClass* GameInstanceClass = UGameInstance::StaticClass();
+	if (const UGameEngine* GameEngine = Cast<UGameEngine>(GEngine); GameEngine && GameEngine->GameInstance)
+	{
+		GameInstanceClass = GameEngine->GameInstance->GetClass();
+	}
+
+	const int32 MatchId = NextMatchId++;
+	UGameInstance* GameInstance = NewObject<UGameInstance>(GEngine, GameInstanceClass);
+	GameInstance->InitializeStandalone(FName(*FString::Printf(TEXT("ITPMatch%d"), MatchId)));
+
+	// The port is taken now, so matches started while this one loads get their own
+	FITPHostedMatch& Match = Matches.AddDefaulted_GetRef();
+	Match.GameInstance = GameInstance;
+	Match.Id = MatchId;
+	Match.Port = FindFreePort();
+	Match.MapName = MapName;
+	Match.Options = Options;
+	Match.InstanceName = FString::Printf(TEXT("%s_ITPMatch%d"), *MapName, MatchId);
+	Match.MemoryBeforeLoad = FPlatformMemory::GetStats().UsedPhysical;
+	SET_DWORD_STAT(STAT_ITPHostedMatches, Matches.Num());
+
+	UE_LOG(LogITP, Log, TEXT("Match %d: loading %s for port %d"), MatchId, *MapName, Match.Port);
+
+	// An instanced load gives the match its own copy of the level; everything the level references is shared
+	const FName InstanceName(*Match.InstanceName);
+	FLinkerInstancingContext InstancingContext;
+	InstancingContext.AddPackageMapping(FName(*MapName), InstanceName);
+	LoadPackageAsync(FPackagePath::FromPackageNameChecked(MapName), InstanceName,
+		FLoadPackageAsyncDelegate::CreateUObject(this, &ThisClass::OnMatchPackageLoaded, MatchId), PKG_ContainsMap, INDEX_NONE, 0, &InstancingContext);
+	return MatchId;
+}
+
+void UITPMatchHostSubsystem::OnMatchPackageLoaded(const FName& PackageName, UPackage* Package, EAsyncLoadingResult::Type Result, int32 MatchId)
+{
+	FITPHostedMatch* Match = FindMatch(MatchId);
+	if (!Match)
+	{
+		// Stopped while loading; the package goes with the next garbage collection
+		return;
+	}
+
+	Match->LoadedWorld = Result == EAsyncLoadingResult::Succeeded && Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+	if (!Match->LoadedWorld)
+	{
+		UE_LOG(LogITP, Warning, TEXT("Cannot host match %d: %s failed to load"), MatchId, *PackageName.ToString());
+		StopMatch(MatchId);
+		return;
+	}
+
+	// LoadMap collects garbage, which cannot run inside the loader's completion callback; run it on the next tick
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateWeakLambda(this, [this, MatchId](float)
+	{
+		FinishMatchLoad(MatchId);
+		return false;
+	}));
+}
+
+void UITPMatchHostSubsystem::FinishMatchLoad(int32 MatchId)
+{
+	FITPHostedMatch* Match = FindMatch(MatchId);
+	if (!Match)
+	{
+		return;
+	}
+
+	// LoadMap finds the instanced package by name, then spawns the game mode and listens like a regular server
+	FURL URL(nullptr, *FString::Printf(TEXT("%s?listen?game=/Script/ITP.ITPGameMode%s"), *Match->InstanceName, *Match->Options), TRAVEL_Absolute);
+	URL.Port = Match->Port;
+
+	UGameInstance* GameInstance = Match->GameInstance;
+	UWorld* const PreviousWorld = GWorld;
+	FString Error;
+	const double LoadMapStart = FPlatformTime::Seconds();
+	const bool bLoaded = GEngine->LoadMap(*GameInstance->GetWorldContext(), URL, nullptr, Error);
+	const double LoadMapMs = (FPlatformTime::Seconds() - LoadMapStart) * 1000.0;
+	GWorld = PreviousWorld;
+
+	// LoadMap may have started or stopped other matches through the console; look this one up again
+	Match = FindMatch(MatchId);
+	UWorld* World = GameInstance->GetWorld();
+	if (!Match || !bLoaded || !World || !World->GetNetDriver())
+	{
+		UE_LOG(LogITP, Warning, TEXT("Cannot host match %d on port %d: %s"), MatchId, URL.Port, Error.IsEmpty() ? TEXT("listen failed") : *Error);
+		StopMatch(MatchId);
+		return;
+	}
+
+	// The world context holds the world from here on. Had LoadMap not found the instanced package, it would have
+	// loaded the map under its own name, shared with every other match on it.
+	const UWorld* const LoadedWorld = Match->LoadedWorld;
+	Match->LoadedWorld = nullptr;
+	if (World != LoadedWorld)
+	{
+		UE_LOG(LogITP, Error, TEXT("Cannot host match %d: LoadMap produced %s instead of the instanced %s"),
+			MatchId, *World->GetPackage()->GetName(), *Match->InstanceName);
+		StopMatch(MatchId);
+		return;
+	}
+
+	World->OnTickDispatch().AddUObject(this, &ThisClass::OnMatchTickStart, MatchId);
+	World->OnPostTickFlush().AddUObject(this, &ThisClass::OnMatchTickEnd, MatchId);
+
+	Match->bLoading = false;
+	Match->LoadMapMs = LoadMapMs;
+	const uint64 MemoryAfter = FPlatformMemory::GetStats().UsedPhysical;
+	Match->MemoryBytes = MemoryAfter > Match->MemoryBeforeLoad ? MemoryAfter - Match->MemoryBeforeLoad : 0;
+	if (FirstMatchId == INDEX_NONE)
+	{
+		FirstMatchId = MatchId;
+		FirstMatchBytes = Match->MemoryBytes;
+	}
+
+	UE_LOG(LogITP, Log, TEXT("Match %d: %s on port %d, %.1f MB, LoadMap stalled the game thread for %.1f ms"),
+		MatchId, *Match->MapName, Match->Port, Match->MemoryBytes / BytesPerMB, LoadMapMs);
+}
+
+void UITPMatchHostSubsystem::StopMatch(int32 MatchId)
+{
+	const int32 Index = Matches.IndexOfByPredicate([MatchId](const FITPHostedMatch& Match) { return Match.Id == MatchId; });
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	UGameInstance* GameInstance = Matches[Index].GameInstance;
+	Matches.RemoveAt(Index);
+	if (GameInstance)
+	{
+		ShutdownMatch(GameInstance);
+	}
+
+	SET_DWORD_STAT(STAT_ITPHostedMatches, Matches.Num());
+	UE_LOG(LogITP, Log, TEXT("Match %d stopped, memory is returned on the next garbage collection"), MatchId);
+}
+
+void UITPMatchHostSubsystem::StopAllMatches()
+{
+	while (Matches.Num() > 0)
+	{
+		StopMatch(Matches.Last().Id);
+	}
+}
+
+void UITPMatchHostSubsystem::LogReport() const
+{
+	// A dedicated server sleeps out the rest of each frame, so the budget per frame is set by the tick rate
+	const float TickRate = GEngine->GetMaxTickRate(0.f, false);
+	const double BudgetMs = 1000.0 / (TickRate > 0.f ? TickRate : 30.0);
+
+	double TotalTickMs = 0.0;
+	int32 NumTicks = 0;
+	uint64 FurtherMatchBytes = 0;
+	int32 NumFurtherMatches = 0;
+	for (const FITPHostedMatch& Match : Matches)
+	{
+		const UWorld* World = Match.GetWorld();
+		if (Match.bLoading)
+		{
+			UE_LOG(LogITP, Log, TEXT("Match %d on %s port %d: loading"), Match.Id, *Match.MapName, Match.Port);
+			continue;
+		}
+
+		UE_LOG(LogITP, Log, TEXT("Match %d on %s port %d: %d player(s), tick avg %.2f ms max %.2f ms, %.1f MB, LoadMap %.1f ms"),
+			Match.Id,
+			*Match.MapName,
+			Match.Port,
+			World ? World->GetNumPlayerControllers() : 0,
+			Match.NumTicks > 0 ? Match.TotalTickMs / Match.NumTicks : 0.0,
+			Match.MaxTickMs,
+			Match.MemoryBytes / BytesPerMB,
+			Match.LoadMapMs);
+
+		TotalTickMs += Match.TotalTickMs;
+		NumTicks += Match.NumTicks;
+		if (Match.Id != FirstMatchId)
+		{
+			FurtherMatchBytes += Match.MemoryBytes;
+			++NumFurtherMatches;
+		}
+	}
+
+	const double MatchMs = NumTicks > 0 ? TotalTickMs / NumTicks : 0.0;
+	UE_LOG(LogITP, Log, TEXT("Matches: %d hosted, %.2f ms per match tick against a %.1f ms frame, %.1f matches per core"),
+		Matches.Num(), MatchMs, BudgetMs, MatchMs > 0.0 ? BudgetMs / MatchMs : 0.0);
+
+	// The first match also pays for the assets every later match shares
+	if (NumFurtherMatches > 0)
+	{
+		const double PerMatchMB = FurtherMatchBytes / BytesPerMB / NumFurtherMatches;
+		UE_LOG(LogITP, Log, TEXT("Memory: %.1f MB per match, %.1f MB shared, %.1f MB process"),
+			PerMatchMB, FMath::Max(FirstMatchBytes / BytesPerMB - PerMatchMB, 0.0), FPlatformMemory::GetStats().UsedPhysical / BytesPerMB);
+	}
+	else
+	{
+		UE_LOG(LogITP, Log, TEXT("Memory: first match %.1f MB including shared assets, %.1f MB process; start more matches to split the two"),
+			FirstMatchBytes / BytesPerMB, FPlatformMemory::GetStats().UsedPhysical / BytesPerMB);
+	}
+}
+
+FITPHostedMatch* UITPMatchHostSubsystem::FindMatch(int32 MatchId)
+{
+	return Matches.FindByPredicate([MatchId](const FITPHostedMatch& Match) { return Match.Id == MatchId; });
+}
+
+int32 UITPMatchHostSubsystem::FindFreePort() const
+{
+	int32 Port = GITPMatchBasePort;
+	while (Matches.ContainsByPredicate([Port](const FITPHostedMatch& Match) { return Match.Port == Port; }))
+	{
+		++Port;
+	}
+	return Port;
+}
+
+void UITPMatchHostSubsystem::ShutdownMatch(UGameInstance* GameInstance)
+{
+	UWorld* World = GameInstance->GetWorld();
+	if (World)
+	{
+		World->OnTickDispatch().RemoveAll(this);
+		World->OnPostTickFlush().RemoveAll(this);
+		World->BeginTearingDown();
+		GEngine->ShutdownWorldNetDriver(World);
+	}
+
+	GameInstance->Shutdown();
+
+	if (World)
+	{
+		World->DestroyWorld(true);
+		GEngine->DestroyWorldContext(World);
+	}
+}
+
+void UITPMatchHostSubsystem::OnMatchTickStart(float DeltaSeconds, int32 MatchId)
+{
+	if (FITPHostedMatch* Match = FindMatch(MatchId))
+	{
+		Match->TickStartTime = FPlatformTime::Seconds();
+	}
+}
+
+void UITPMatchHostSubsystem::OnMatchTickEnd(float DeltaSeconds, int32 MatchId)
+{
+	FITPHostedMatch* Match = FindMatch(MatchId);
+	if (!Match || Match->TickStartTime <= 0.0)
+	{
+		return;
+	}
+
+	const double TickMs = (FPlatformTime::Seconds() - Match->TickStartTime) * 1000.0;
+	Match->TotalTickMs += TickMs;
+	Match->MaxTickMs = FMath::Max(Match->MaxTickMs, TickMs);
+	++Match->NumTicks;
+}
+
+static FAutoConsoleCommand CmdITPMatchStart(
+	TEXT("ITP.Match.Start"),
+	TEXT("ITP.Match.Start <Map> [Count=1] [Options]: hosts Count new matches of Map (long package name, e.g. /Game/Maps/Level1)\n")
+	TEXT("in this process. Options are URL options passed to AITPGameMode, e.g. ?RunSeed=42. Dedicated servers can start\n")
+	TEXT("matches at launch with -ExecCmds=\"ITP.Match.Start /Game/Maps/Level1 8\"."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		UITPMatchHostSubsystem* Host = GEngine ? GEngine->GetEngineSubsystem<UITPMatchHostSubsystem>() : nullptr;
+		if (!Host || Args.Num() == 0)
+		{
+			return;
+		}
+
+		const int32 Count = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 1;
+		const FString Options = Args.Num() > 2 ? Args[2] : FString();
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			if (Host->StartMatch(Args[0], Options) == INDEX_NONE)
+			{
+				return;
+			}
+		}
+	}));
+
+static FAutoConsoleCommand CmdITPMatchStop(
+	TEXT("ITP.Match.Stop"),
+	TEXT("ITP.Match.Stop [Id]: stops one hosted match, or all of them without an id."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		if (UITPMatchHostSubsystem* Host = GEngine ? GEngine->GetEngineSubsystem<UITPMatchHostSubsystem>() : nullptr)
+		{
+			if (Args.Num() > 0)
+			{
+				Host->StopMatch(FCString::Atoi(*Args[0]));
+			}
+			else
+			{
+				Host->StopAllMatches();
+			}
+		}
+	}));
+
+static FAutoConsoleCommand CmdITPMatchReport(
+	TEXT("ITP.Match.Report"),
+	TEXT("Logs every hosted match with its tick time and memory, then matches per core and memory per match."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		if (const UITPMatchHostSubsystem* Host = GEngine ? GEngine->GetEngineSubsystem<UITPMatchHostSubsystem>() : nullptr)
+		{
+			Host->LogReport();
+		}
+	}));
@@ -0,0 +1,112 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "UObject/UObjectGlobals.h"
+#include "ITPMatchHostSubsystem.generated.h"
+
+class UGameInstance;
+class UPackage;
+class UWorld;
+
+/** One hosted match: its own game instance, world, AITPGameMode and listen port */
+USTRUCT()
+struct FITPHostedMatch
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TObjectPtr<UGameInstance> GameInstance;
+
+	int32 Id = INDEX_NONE;
+	int32 Port = 0;
+	FString MapName;
+
+	/** URL options and the instanced package name, kept until the map package has loaded */
+	FString Options;
+	FString InstanceName;
+
+	/**
+	 * World of the loaded instanced map package. Nothing else references it before LoadMap, whose garbage collection
+	 * would take it; holding the world keeps its package as well.
+	 */
+	UPROPERTY()
+	TObjectPtr<UWorld> LoadedWorld;
+
+	/** True from StartMatch until LoadMap ran on the loaded package */
+	bool bLoading = true;
+
+	/** Process memory added by loading the match; loads overlapping this one are counted in as well */
+	uint64 MemoryBeforeLoad = 0;
+	uint64 MemoryBytes = 0;
+
+	/** Game thread stall of LoadMap itself, which includes a full garbage collection */
+	double LoadMapMs = 0.0;
+
+	/** Game thread time of the match world's own tick, from tick dispatch to post tick flush */
+	double TickStartTime = 0.0;
+	double TotalTickMs = 0.0;
+	double MaxTickMs = 0.0;
+	int32 NumTicks = 0;
+
+	UWorld* GetWorld() const;
+};
+
+/**
+ * Hosts several independent matches in one dedicated server process.
+ * Every match gets its own game instance, so run seeds and the other game instance subsystems stay per match, and
+ * loads its map as an instanced package: actors are per match while meshes, textures and level data the map
+ * references are loaded once and shared. Each match listens on its own port from ITP.Match.BasePort.
+ * The map package loads asynchronously while the other matches keep ticking; only LoadMap itself, which spawns the
+ * actors and collects garbage, runs on the game thread once the package is in memory.
+ * The engine ticks all match worlds on the game thread one after another; their tick groups and replication
+ * already fan out to the task graph workers. Per-match game thread time is measured here, so ITP.Match.Report
+ * can say how many matches one core sustains at the server tick rate and what each costs in memory.
+ */
+UCLASS()
+class ITP_API UITPMatchHostSubsystem : public UEngineSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	/**
+	 * Starts loading MapName (a long package name) as a new match. Options are URL options, e.g. ?RunSeed=.
+	 * Returns the match id, or INDEX_NONE if the map does not exist; the match listens once its load completed.
+	 */
+	int32 StartMatch(const FString& MapName, const FString& Options = FString());
+
+	void StopMatch(int32 MatchId);
+	void StopAllMatches();
+
+	int32 GetNumMatches() const { return Matches.Num(); }
+
+	void LogReport() const;
+
+private:
+	FITPHostedMatch* FindMatch(int32 MatchId);
+	int32 FindFreePort() const;
+
+	void OnMatchPackageLoaded(const FName& PackageName, UPackage* Package, EAsyncLoadingResult::Type Result, int32 MatchId);
+
+	/** Creates the match world from its loaded package and starts listening */
+	void FinishMatchLoad(int32 MatchId);
+
+	/** Closes the listen socket, then destroys the world and its world context */
+	void ShutdownMatch(UGameInstance* GameInstance);
+
+	void OnMatchTickStart(float DeltaSeconds, int32 MatchId);
+	void OnMatchTickEnd(float DeltaSeconds, int32 MatchId);
+
+	UPROPERTY()
+	TArray<FITPHostedMatch> Matches;
+
+	int32 NextMatchId = 0;
+
+	/** The first match also loads the assets all matches share, so its memory is kept apart */
+	int32 FirstMatchId = INDEX_NONE;
+	uint64 FirstMatchBytes = 0;
+};
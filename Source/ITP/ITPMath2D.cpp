@@ -0,0 +1,117 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPMath2D.h"
+#include "ITP.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Math/VectorRegister.h"
+
+namespace ITP2D
+{
+	void Translate(float* RESTRICT Pos, int32 Num, float Offset)
+	{
+		const VectorRegister4Float Delta = VectorSetFloat1(Offset);
+
+		int32 Index = 0;
+		for (; Index + 4 <= Num; Index += 4)
+		{
+			VectorStore(VectorAdd(VectorLoad(Pos + Index), Delta), Pos + Index);
+		}
+		for (; Index < Num; ++Index)
+		{
+			Pos[Index] += Offset;
+		}
+	}
+}
+
+namespace ITP2DTest
+{
+	using namespace ITP2D;
+
+	/**
+	 * Precision: plane round trips of world locations up to 10 km along the scroll axis, once relative to the world
+	 * origin and once relative to an FPlaneOrigin near them, as UITPOriginSubsystem keeps it.
+	 * Kernels: Translate on an unaligned, odd-sized array must match the scalar loop bit for bit; its cost is timed
+	 * against a scalar float loop and a double loop over the same count, the cost of keeping locations in world space.
+	 */
+	static void SelfTest(const TArray<FString>& Args)
+	{
+		const int32 Count = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100000;
+		const int32 Iterations = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 100;
+
+		FRandomStream Random(Count);
+		double MaxErrorAtOrigin = 0.0;
+		double MaxErrorRebased = 0.0;
+		for (int32 Sample = 0; Sample < 10000; ++Sample)
+		{
+			const FVector World(Random.FRandRange(-500.0, 500.0), Random.FRandRange(0.0, 1.0e6), Random.FRandRange(-1000.0, 5000.0));
+			FPlaneOrigin Origin;
+			Origin.Scroll = FMath::GridSnap(World.Y, 10000.0);
+
+			const FVector AtOrigin = ToWorld(FromWorld(World), World.X);
+			const FVector Rebased = ToWorld(FromWorld(World, Origin), World.X, Origin);
+			MaxErrorAtOrigin = FMath::Max(MaxErrorAtOrigin, FVector::Dist(AtOrigin, World));
+			MaxErrorRebased = FMath::Max(MaxErrorRebased, FVector::Dist(Rebased, World));
+		}
+
+		// One extra element and a one float offset, so both the unaligned loads and the scalar tail are exercised
+		TArray<float> Simd;
+		TArray<float> Scalar;
+		TArray<double> Doubles;
+		Simd.SetNumUninitialized(Count + 2);
+		for (int32 Index = 0; Index < Count + 2; ++Index)
+		{
+			Simd[Index] = Random.FRandRange(-1.0e4f, 1.0e4f);
+		}
+		Scalar = Simd;
+		Doubles.SetNumUninitialized(Count + 1);
+		for (int32 Index = 0; Index < Count + 1; ++Index)
+		{
+			Doubles[Index] = Simd[Index + 1];
+		}
+
+		const int32 Num = Count + 1;
+		uint64 SimdCycles = 0;
+		uint64 ScalarCycles = 0;
+		uint64 DoubleCycles = 0;
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			const float Offset = Iteration % 2 == 0 ? -1234.5f : 1234.5f;
+
+			uint64 StartCycles = FPlatformTime::Cycles64();
+			Translate(Simd.GetData() + 1, Num, Offset);
+			SimdCycles += FPlatformTime::Cycles64() - StartCycles;
+
+			StartCycles = FPlatformTime::Cycles64();
+			float* RESTRICT ScalarPos = Scalar.GetData() + 1;
+			for (int32 Index = 0; Index < Num; ++Index)
+			{
+				ScalarPos[Index] += Offset;
+			}
+			ScalarCycles += FPlatformTime::Cycles64() - StartCycles;
+
+			StartCycles = FPlatformTime::Cycles64();
+			double* RESTRICT DoublePos = Doubles.GetData();
+			for (int32 Index = 0; Index < Num; ++Index)
+			{
+				DoublePos[Index] += Offset;
+			}
+			DoubleCycles += FPlatformTime::Cycles64() - StartCycles;
+		}
+
+		const bool bIdentical = FMemory::Memcmp(Simd.GetData(), Scalar.GetData(), Simd.Num() * sizeof(float)) == 0;
+		const bool bRebasedPrecise = MaxErrorRebased <= 0.01;
+		const auto UsPerCall = [Iterations](uint64 Cycles) { return FPlatformTime::ToMilliseconds64(Cycles) * 1000.0 / Iterations; };
+		UE_LOG(LogITP, Display, TEXT("Math2D self test %s: plane round trip error up to 10 km %.4f cm from the world origin, %.6f cm rebased; Translate %s the scalar loop"),
+			bIdentical && bRebasedPrecise ? TEXT("passed") : TEXT("FAILED"),
+			MaxErrorAtOrigin, MaxErrorRebased, bIdentical ? TEXT("matches") : TEXT("DIFFERS FROM"));
+		UE_LOG(LogITP, Display, TEXT("Translate of %d locations: %.2f us vectorized, %.2f us scalar float, %.2f us scalar double"),
+			Num, UsPerCall(SimdCycles), UsPerCall(ScalarCycles), UsPerCall(DoubleCycles));
+	}
+
+	static FAutoConsoleCommand SelfTestCommand(
+		TEXT("ITP.Math.SelfTest"),
+		TEXT("ITP.Math.SelfTest [Count=100000] [Iterations=100]: checks plane conversion precision with and without a rebased origin, and checks and times ITP2D::Translate against scalar float and double loops."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&SelfTest));
+}
@@ -0,0 +1,79 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Single precision 2D math for ITP-owned simulation.
+ * The gameplay plane maps 2D X to the world Y (scroll) axis and 2D Y to world Z (up); world X is depth.
+ * Simulation stays in FVector2f and only converts to double world space at the engine boundary.
+ */
+namespace ITP2D
+{
+	/** World axes spanning the gameplay plane */
+	inline const FVector ScrollAxis(0.0, 1.0, 0.0);
+	inline const FVector UpAxis(0.0, 0.0, 1.0);
+
+	/** Default size of one level tile in cm */
+	constexpr float DefaultTileSize = 100.f;
+
+	/**
+	 * Double precision scroll-axis offset that plane locations are relative to.
+	 * UITPOriginSubsystem moves it on long runs so float locations stay near zero.
+	 */
+	struct FPlaneOrigin
+	{
+		double Scroll = 0.0;
+	};
+
+	FORCEINLINE FVector2f FromWorld(const FVector& WorldLocation, const FPlaneOrigin& Origin = FPlaneOrigin())
+	{
+		return FVector2f((float)(WorldLocation.Y - Origin.Scroll), (float)WorldLocation.Z);
+	}
+
+	FORCEINLINE FVector ToWorld(const FVector2f& Location, double Depth = 0.0, const FPlaneOrigin& Origin = FPlaneOrigin())
+	{
+		return FVector(Depth, (double)Location.X + Origin.Scroll, (double)Location.Y);
+	}
+
+	/** Directions drop their depth component, which keeps movement in the gameplay plane */
+	FORCEINLINE FVector2f FromWorldDirection(const FVector& WorldDirection)
+	{
+		return FVector2f((float)WorldDirection.Y, (float)WorldDirection.Z);
+	}
+
+	FORCEINLINE FVector ToWorldDirection(const FVector2f& Direction)
+	{
+		return FVector(0.0, (double)Direction.X, (double)Direction.Y);
+	}
+
+	/** Axis aligned bounds of a capsule standing upright in the plane */
+	FORCEINLINE FBox2f CapsuleBounds(const FVector2f& Center, float Radius, float HalfHeight)
+	{
+		const FVector2f Extent(Radius, HalfHeight);
+		return FBox2f(Center - Extent, Center + Extent);
+	}
+
+	FORCEINLINE FIntPoint LocationToTile(const FVector2f& Location, float TileSize = DefaultTileSize)
+	{
+		return FIntPoint(FMath::FloorToInt32(Location.X / TileSize), FMath::FloorToInt32(Location.Y / TileSize));
+	}
+
+	FORCEINLINE FBox2f TileBounds(const FIntPoint& Tile, float TileSize = DefaultTileSize)
+	{
+		const FVector2f Min((float)Tile.X * TileSize, (float)Tile.Y * TileSize);
+		return FBox2f(Min, Min + FVector2f(TileSize));
+	}
+
+	FORCEINLINE FVector2f TileCenter(const FIntPoint& Tile, float TileSize = DefaultTileSize)
+	{
+		return TileBounds(Tile, TileSize).GetCenter();
+	}
+
+	/**
+	 * Pos += Offset over a float array, four lanes per register, used to rebase SoA location arrays after an
+	 * origin shift. Pos may be unaligned; Num does not need to be a multiple of four.
+	 */
+	void Translate(float* RESTRICT Pos, int32 Num, float Offset);
+}
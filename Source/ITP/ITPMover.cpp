@@ -0,0 +1,169 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPMover.h"
+#include "ITP.h"
+#include "ITPChecksumSubsystem.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+
+namespace ITPMoverBenchmark
+{
+	/** The runtime-dispatched design TITPMover replaces: one rules object per mover, every policy a virtual call */
+	struct FVirtualRules
+	{
+		virtual ~FVirtualRules() = default;
+		virtual void ApplyGravity(FITPMoverState& State, const FITPMoverParams& Params, FITPScalar DeltaSeconds) const = 0;
+		virtual bool CanGlide() const = 0;
+		virtual void ApplyGlide(FITPMoverState& State, const FITPMoverParams& Params, FITPScalar DeltaSeconds) const = 0;
+		virtual void Move(FITPMoverState& State, const FITPMoverContext& Context, FITPScalar DeltaSeconds) const = 0;
+	};
+
+	template<typename GravityPolicy, typename GlidePolicy, typename CollisionPolicy>
+	struct TVirtualRules : FVirtualRules
+	{
+		virtual void ApplyGravity(FITPMoverState& State, const FITPMoverParams& Params, FITPScalar DeltaSeconds) const override { GravityPolicy::Apply(State, Params, DeltaSeconds); }
+		virtual bool CanGlide() const override { return GlidePolicy::bCanGlide; }
+		virtual void ApplyGlide(FITPMoverState& State, const FITPMoverParams& Params, FITPScalar DeltaSeconds) const override { GlidePolicy::Apply(State, Params, DeltaSeconds); }
+		virtual void Move(FITPMoverState& State, const FITPMoverContext& Context, FITPScalar DeltaSeconds) const override { CollisionPolicy::Move(State, Context, DeltaSeconds); }
+	};
+
+	/** Same rules as TITPMover::Step, decided at run time */
+	static void StepVirtual(const FVirtualRules& Rules, FITPMoverState& State, const FITPMoverParams& Params, const FITPMoverContext& Context, FITPScalar DeltaSeconds)
+	{
+		if (Rules.CanGlide() && State.Glide.bIsGliding)
+		{
+			Rules.ApplyGlide(State, Params, DeltaSeconds);
+		}
+		else
+		{
+			State.Glide.bForceVelocityY = false;
+			Rules.ApplyGravity(State, Params, DeltaSeconds);
+		}
+
+		if (!State.bGrounded)
+		{
+			State.VelocityX = ITPKinematics::ApplyAirControl(State.VelocityX, State.InputX, Params.MaxSpeed, Params.MaxAcceleration, Params.AirControl, DeltaSeconds);
+		}
+
+		Rules.Move(State, Context, DeltaSeconds);
+	}
+
+	static void AddState(FITPChecksumBuilder& Builder, const FITPMoverState& State)
+	{
+		Builder.Add(State.Position.X);
+		Builder.Add(State.Position.Y);
+		Builder.Add(ITPToFloat(State.VelocityX));
+		Builder.Add(ITPToFloat(State.VelocityY));
+	}
+
+	enum EKind
+	{
+		Player,
+		NPC,
+		Projectile,
+
+		NumKinds
+	};
+
+	/**
+	 * Steps Count movers of each kind (player, NPC, projectile) for Steps fixed steps, once per kind through its
+	 * TITPMover specialization and once as one mixed list through virtual rules, as a class hierarchy of movers
+	 * would. Both must end in the same state. Without a world the NPC's ground probe is skipped, so this measures
+	 * the kinematics and their dispatch, not collision.
+	 */
+	static void Benchmark(const TArray<FString>& Args)
+	{
+		const int32 Count = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10000;
+		const int32 Steps = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 100;
+		const FITPScalar DeltaSeconds = ITPFromFloat<FITPScalar>(ITPKinematics::GetFixedDeltaSeconds());
+		const FITPMoverParams Params;
+		const FITPMoverContext Context;
+
+		const TVirtualRules<FITPNoGravity, FITPCharacterGlide, FITPExternalCollision> PlayerRules;
+		const TVirtualRules<FITPConstantGravity, FITPNoGlide, FITPGroundProbeCollision> NPCRules;
+		const TVirtualRules<FITPNoGravity, FITPNoGlide, FITPNoCollision> ProjectileRules;
+		const FVirtualRules* Rules[NumKinds] = { &PlayerRules, &NPCRules, &ProjectileRules };
+
+		// Movers spawn in no particular order, so the mixed list interleaves kinds at random
+		FRandomStream Random(Count);
+		TArray<FITPMoverState> ByKind[NumKinds];
+		TArray<FITPMoverState> Mixed;
+		TArray<const FVirtualRules*> MixedRules;
+		for (int32 Index = 0; Index < Count * NumKinds; ++Index)
+		{
+			FITPMoverState State;
+			State.VelocityX = ITPFromFloat<FITPScalar>(Random.FRandRange(-500.f, 500.f));
+			State.VelocityY = ITPFromFloat<FITPScalar>(Random.FRandRange(-300.f, 700.f));
+			State.InputX = ITPFromFloat<FITPScalar>(Random.FRandRange(-1.f, 1.f));
+			State.Glide.bIsGliding = Random.FRand() < 0.5f;
+
+			const int32 Kind = Index % NumKinds;
+			ByKind[Kind].Add(State);
+			Mixed.Add(State);
+			MixedRules.Add(Rules[Kind]);
+		}
+		for (int32 Index = Mixed.Num() - 1; Index > 0; --Index)
+		{
+			const int32 Other = Random.RandRange(0, Index);
+			Mixed.Swap(Index, Other);
+			MixedRules.Swap(Index, Other);
+		}
+
+		uint64 TemplatedCycles[NumKinds] = { 0, 0, 0 };
+		uint64 VirtualCycles = 0;
+		for (int32 Step = 0; Step < Steps; ++Step)
+		{
+			uint64 StartCycles = FPlatformTime::Cycles64();
+			FITPPlayerMover::StepAll(ByKind[Player], Params, Context, DeltaSeconds);
+			TemplatedCycles[Player] += FPlatformTime::Cycles64() - StartCycles;
+
+			StartCycles = FPlatformTime::Cycles64();
+			FITPNPCMover::StepAll(ByKind[NPC], Params, Context, DeltaSeconds);
+			TemplatedCycles[NPC] += FPlatformTime::Cycles64() - StartCycles;
+
+			StartCycles = FPlatformTime::Cycles64();
+			FITPProjectileMover::StepAll(ByKind[Projectile], Params, Context, DeltaSeconds);
+			TemplatedCycles[Projectile] += FPlatformTime::Cycles64() - StartCycles;
+
+			StartCycles = FPlatformTime::Cycles64();
+			for (int32 Index = 0; Index < Mixed.Num(); ++Index)
+			{
+				StepVirtual(*MixedRules[Index], Mixed[Index], Params, Context, DeltaSeconds);
+			}
+			VirtualCycles += FPlatformTime::Cycles64() - StartCycles;
+		}
+
+		// Order independent sums of per-mover hashes, so the shuffled list can be compared with the grouped one
+		uint64 TemplatedHash = 0;
+		uint64 VirtualHash = 0;
+		for (int32 Kind = 0; Kind < NumKinds; ++Kind)
+		{
+			for (const FITPMoverState& State : ByKind[Kind])
+			{
+				FITPChecksumBuilder Builder;
+				AddState(Builder, State);
+				TemplatedHash += Builder.Crc;
+			}
+		}
+		for (const FITPMoverState& State : Mixed)
+		{
+			FITPChecksumBuilder Builder;
+			AddState(Builder, State);
+			VirtualHash += Builder.Crc;
+		}
+
+		const double NumSteps = (double)Count * Steps;
+		const auto NsPerStep = [NumSteps](uint64 Cycles) { return FPlatformTime::ToMilliseconds64(Cycles) * 1.0e6 / NumSteps; };
+		const uint64 TotalTemplated = TemplatedCycles[Player] + TemplatedCycles[NPC] + TemplatedCycles[Projectile];
+		UE_LOG(LogITP, Log, TEXT("Mover benchmark, %d movers of each kind, %d steps: templated ns/step player %.2f, NPC %.2f, projectile %.2f, all %.2f; virtual %.2f; states %s"),
+			Count, Steps, NsPerStep(TemplatedCycles[Player]), NsPerStep(TemplatedCycles[NPC]), NsPerStep(TemplatedCycles[Projectile]),
+			NsPerStep(TotalTemplated) / NumKinds, NsPerStep(VirtualCycles) / NumKinds,
+			TemplatedHash == VirtualHash ? TEXT("match") : TEXT("DIFFER"));
+	}
+
+	static FAutoConsoleCommand BenchmarkCommand(
+		TEXT("ITP.Mover.Benchmark"),
+		TEXT("ITP.Mover.Benchmark [Count=10000] [Steps=100]: step cost of the player, NPC and projectile TITPMover specializations against a virtual-dispatch baseline."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Benchmark));
+}
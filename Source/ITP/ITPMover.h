@@ -0,0 +1,168 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CollisionQueryParams.h"
+#include "ITPKinematics.h"
+#include "ITPMath2D.h"
+#include "ITPProbeCache.h"
+
+class UWorld;
+
+/** World access for collision policies. Policies that do not query the world ignore it. */
+struct FITPMoverContext
+{
+	const UWorld* World = nullptr;
+	FITPProbeCache* ProbeCache = nullptr;
+	const FCollisionQueryParams* QueryParams = nullptr;
+	ITP2D::FPlaneOrigin Origin;
+	double Depth = 0.0;
+
+	/** Distance from the mover's origin to its feet */
+	float HalfHeight = 0.f;
+};
+
+/** Gravity policies */
+
+/** Gravity is applied elsewhere (e.g. by the CharacterMovementComponent), or not at all */
+struct FITPNoGravity
+{
+	static FORCEINLINE void Apply(FITPMoverState& State, const FITPMoverParams& Params, FITPScalar DeltaSeconds) {}
+};
+
+struct FITPConstantGravity
+{
+	static FORCEINLINE void Apply(FITPMoverState& State, const FITPMoverParams& Params, FITPScalar DeltaSeconds)
+	{
+		if (!State.bGrounded)
+		{
+			State.VelocityY = ITPKinematics::ApplyGravity(State.VelocityY, Params.GravityY, Params.GravityScale, DeltaSeconds);
+		}
+	}
+};
+
+/** Glide policies */
+
+struct FITPNoGlide
+{
+	static constexpr bool bCanGlide = false;
+
+	static FORCEINLINE void Apply(FITPMoverState& State, const FITPMoverParams& Params, FITPScalar DeltaSeconds) {}
+};
+
+/** The AITPCharacter glide: eased descent that holds the vertical velocity at -DescendingRate */
+struct FITPCharacterGlide
+{
+	static constexpr bool bCanGlide = true;
+
+	static FORCEINLINE void Apply(FITPMoverState& State, const FITPMoverParams& Params, FITPScalar DeltaSeconds)
+	{
+		ITPKinematics::StepGlide(State.Glide, Params.DescendingRate, DeltaSeconds);
+		if (State.Glide.bForceVelocityY)
+		{
+			State.VelocityY = State.Glide.ForcedVelocityY;
+		}
+	}
+};
+
+/** Collision policies. They own position integration, since resolving contacts and moving are one operation. */
+
+/** Movement and collision are done by the engine (CharacterMovementComponent sweeps); nothing to integrate */
+struct FITPExternalCollision
+{
+	static FORCEINLINE void Move(FITPMoverState& State, const FITPMoverContext& Context, FITPScalar DeltaSeconds) {}
+};
+
+/** Free flight, e.g. projectiles that only check overlaps */
+struct FITPNoCollision
+{
+	static FORCEINLINE void Move(FITPMoverState& State, const FITPMoverContext& Context, FITPScalar DeltaSeconds)
+	{
+		State.Position.X += ITPToFloat(State.VelocityX * DeltaSeconds);
+		State.Position.Y += ITPToFloat(State.VelocityY * DeltaSeconds);
+	}
+};
+
+/** Integrates, then lands on ITP_Ground through the mover's probe cache. Game thread only. */
+struct FITPGroundProbeCollision
+{
+	static void Move(FITPMoverState& State, const FITPMoverContext& Context, FITPScalar DeltaSeconds)
+	{
+		const FVector2f Start = State.Position;
+		FITPNoCollision::Move(State, Context, DeltaSeconds);
+
+		if (!Context.World || !Context.ProbeCache || !Context.QueryParams || ITPToFloat(State.VelocityY) > 0.f)
+		{
+			State.bGrounded = false;
+			return;
+		}
+
+		const FVector2f Feet(0.f, Context.HalfHeight);
+		FHitResult Hit;
+		State.bGrounded = Context.ProbeCache->LineProbe(EITPProbe::Ground, Context.World, Hit,
+			ITP2D::ToWorld(Start, Context.Depth, Context.Origin),
+			ITP2D::ToWorld(State.Position - Feet - FVector2f(0.f, 1.f), Context.Depth, Context.Origin),
+			*Context.QueryParams);
+
+		if (State.bGrounded)
+		{
+			State.Position.Y = ITP2D::FromWorld(Hit.ImpactPoint, Context.Origin).Y + Context.HalfHeight;
+			State.VelocityY = ITPFromFloat<FITPScalar>(0.f);
+		}
+	}
+};
+
+/**
+ * Kinematic mover assembled from compile-time policies.
+ * Every rule is resolved statically, so simple movers (projectiles, walkers) inline to a few instructions with
+ * no glide or collision branches left in them.
+ */
+template<typename GravityPolicy, typename GlidePolicy, typename CollisionPolicy>
+struct TITPMover
+{
+	static FORCEINLINE void Step(FITPMoverState& State, const FITPMoverParams& Params, const FITPMoverContext& Context, FITPScalar DeltaSeconds)
+	{
+		if constexpr (GlidePolicy::bCanGlide)
+		{
+			if (State.Glide.bIsGliding)
+			{
+				GlidePolicy::Apply(State, Params, DeltaSeconds);
+			}
+			else
+			{
+				State.Glide.bForceVelocityY = false;
+				GravityPolicy::Apply(State, Params, DeltaSeconds);
+			}
+		}
+		else
+		{
+			GravityPolicy::Apply(State, Params, DeltaSeconds);
+		}
+
+		if (!State.bGrounded)
+		{
+			State.VelocityX = ITPKinematics::ApplyAirControl(State.VelocityX, State.InputX, Params.MaxSpeed, Params.MaxAcceleration, Params.AirControl, DeltaSeconds);
+		}
+
+		CollisionPolicy::Move(State, Context, DeltaSeconds);
+	}
+
+	/** Steps a batch of movers sharing params and context */
+	static void StepAll(TArrayView<FITPMoverState> States, const FITPMoverParams& Params, const FITPMoverContext& Context, FITPScalar DeltaSeconds)
+	{
+		for (FITPMoverState& State : States)
+		{
+			Step(State, Params, Context, DeltaSeconds);
+		}
+	}
+};
+
+/** The player: the CharacterMovementComponent owns gravity and sweeps, ITP owns the glide */
+using FITPPlayerMover = TITPMover<FITPNoGravity, FITPCharacterGlide, FITPExternalCollision>;
+
+/** Simple walking NPCs: gravity and ground landing, no glide */
+using FITPNPCMover = TITPMover<FITPConstantGravity, FITPNoGlide, FITPGroundProbeCollision>;
+
+/** Projectiles: straight line flight */
+using FITPProjectileMover = TITPMover<FITPNoGravity, FITPNoGlide, FITPNoCollision>;
@@ -0,0 +1,103 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPNPCCharacter.h"
+#include "ITPAnimationLODSubsystem.h"
+#include "ITPMath2D.h"
+#include "ITPMover.h"
+#include "ITPOriginSubsystem.h"
+#include "Camera/CameraComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/SpringArmComponent.h"
+
+AITPNPCCharacter::AITPNPCCharacter()
+{
+	// NPCs are never viewed through
+	GetCameraBoom()->SetComponentTickEnabled(false);
+	GetFollowCamera()->SetAutoActivate(false);
+
+	// NPC paths are predictable and nobody aims at them closely, so trade latency for fewer extrapolation errors
+	ProxyInterpolation.MaxDelay = 0.4f;
+	ProxyInterpolation.MaxExtrapolation = 0.1f;
+}
+
+void AITPNPCCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UITPAnimationLODSubsystem* AnimationLOD = GetWorld()->GetSubsystem<UITPAnimationLODSubsystem>())
+	{
+		AnimationLOD->Register(this);
+	}
+
+	if (HasAuthority())
+	{
+		// The mover owns gravity and landing; the movement component only carries the velocity for replication and animation
+		GetCharacterMovement()->SetComponentTickEnabled(false);
+
+		const float Direction = bWalkForward ? 1.f : -1.f;
+		MoverParams.MaxSpeed = ITPFromFloat<FITPScalar>(WalkSpeed);
+		MoverState.InputX = ITPFromFloat<FITPScalar>(Direction);
+		MoverState.VelocityX = ITPFromFloat<FITPScalar>(WalkSpeed * Direction);
+	}
+}
+
+void AITPNPCCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UITPAnimationLODSubsystem* AnimationLOD = GetWorld()->GetSubsystem<UITPAnimationLODSubsystem>())
+	{
+		AnimationLOD->Unregister(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AITPNPCCharacter::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (HasAuthority())
+	{
+		StepMover(DeltaSeconds);
+	}
+}
+
+void AITPNPCCharacter::StepMover(float DeltaSeconds)
+{
+	const float FixedDeltaSeconds = ITPKinematics::GetFixedDeltaSeconds();
+	MoverAccumulator += DeltaSeconds;
+	if (MoverAccumulator < FixedDeltaSeconds)
+	{
+		return;
+	}
+
+	const UITPOriginSubsystem* OriginSubsystem = GetWorld()->GetSubsystem<UITPOriginSubsystem>();
+	const FVector Location = GetActorLocation();
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ITPNPCMover), false, this);
+
+	FITPMoverContext Context;
+	Context.World = GetWorld();
+	Context.ProbeCache = &GetProbeCache();
+	Context.QueryParams = &QueryParams;
+	Context.Origin = OriginSubsystem ? OriginSubsystem->GetOrigin() : ITP2D::FPlaneOrigin();
+	Context.Depth = Location.X;
+	Context.HalfHeight = GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+
+	// Teleports and origin shifts move the actor, so the plane position is always taken from it
+	MoverState.Position = ITP2D::FromWorld(Location, Context.Origin);
+	for (; MoverAccumulator >= FixedDeltaSeconds; MoverAccumulator -= FixedDeltaSeconds)
+	{
+		FITPNPCMover::Step(MoverState, MoverParams, Context, ITPFromFloat<FITPScalar>(FixedDeltaSeconds));
+	}
+
+	// The mover has no walls, so the move is swept and a wall ahead turns the NPC around
+	FHitResult Hit;
+	SetActorLocation(ITP2D::ToWorld(MoverState.Position, Context.Depth, Context.Origin), true, &Hit);
+	if (Hit.bBlockingHit && FMath::Abs(Hit.ImpactNormal | ITP2D::ScrollAxis) > 0.7)
+	{
+		MoverState.InputX = -MoverState.InputX;
+		MoverState.VelocityX = -MoverState.VelocityX;
+	}
+
+	GetCharacterMovement()->Velocity = ITP2D::ToWorldDirection(FVector2f(ITPToFloat(MoverState.VelocityX), ITPToFloat(MoverState.VelocityY)));
+}
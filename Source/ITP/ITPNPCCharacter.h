@@ -0,0 +1,42 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ITPCharacter.h"
+#include "ITPNPCCharacter.generated.h"
+
+/**
+ * Non-player ITP character. Its animation cost is managed by UITPAnimationLODSubsystem.
+ * The server moves it with FITPNPCMover (gravity and ground landing through the probe cache) at the ITP fixed step
+ * instead of running the CharacterMovementComponent; clients receive its movement like any other character's.
+ */
+UCLASS(config=Game)
+class AITPNPCCharacter : public AITPCharacter
+{
+	GENERATED_BODY()
+
+public:
+	AITPNPCCharacter();
+
+protected:
+	/** Walking speed along the scroll axis in cm/s */
+	UPROPERTY(EditAnywhere, Category = Movement, meta = (ClampMin = "0"))
+	float WalkSpeed = 150.f;
+
+	/** Starting walk direction along the scroll axis; flips when the NPC walks into a wall */
+	UPROPERTY(EditAnywhere, Category = Movement)
+	bool bWalkForward = false;
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+
+private:
+	/** Authority only: the mover's view of the NPC, re-read from the actor before every frame's steps */
+	FITPMoverState MoverState;
+	FITPMoverParams MoverParams;
+	float MoverAccumulator = 0.f;
+
+	void StepMover(float DeltaSeconds);
+};
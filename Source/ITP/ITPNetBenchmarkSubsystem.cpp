@@ -0,0 +1,180 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPNetBenchmarkSubsystem.h"
+#include "ITP.h"
+#include "ITPCharacter.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/PlatformTime.h"
+
+static FString GetReplicationPathName(const UNetDriver* NetDriver)
+{
+	return NetDriver->IsUsingIrisReplication() ? TEXT("Iris") : TEXT("legacy");
+}
+
+void UITPNetBenchmarkSubsystem::Tick(float DeltaTime)
+{
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (!NetDriver || !NetDriver->IsServer())
+	{
+		RemainingSeconds = 0.f;
+		return;
+	}
+
+	// GGameThreadTime excludes the frame-rate wait, so it is the server's actual work
+	const double GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	TotalGameThreadMs += GameThreadMs;
+	MaxGameThreadMs = FMath::Max(MaxGameThreadMs, GameThreadMs);
+	TotalOutBytes += NetDriver->OutBytesPerSecond * DeltaTime;
+	TotalInBytes += NetDriver->InBytesPerSecond * DeltaTime;
+	MaxConnections = FMath::Max(MaxConnections, NetDriver->ClientConnections.Num());
+	SampledSeconds += DeltaTime;
+	++NumFrames;
+
+	RemainingSeconds -= DeltaTime;
+	if (RemainingSeconds <= 0.f)
+	{
+		Finish();
+	}
+}
+
+TStatId UITPNetBenchmarkSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UITPNetBenchmarkSubsystem, STATGROUP_ITP);
+}
+
+bool UITPNetBenchmarkSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool UITPNetBenchmarkSubsystem::IsTickable() const
+{
+	return Super::IsTickable() && IsRunning();
+}
+
+void UITPNetBenchmarkSubsystem::Start(float Seconds)
+{
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (!NetDriver || !NetDriver->IsServer())
+	{
+		UE_LOG(LogITP, Warning, TEXT("ITP.Net.Benchmark runs on the server"));
+		return;
+	}
+
+	RemainingSeconds = FMath::Max(Seconds, 1.f);
+	SampledSeconds = 0.0;
+	NumFrames = 0;
+	TotalGameThreadMs = 0.0;
+	MaxGameThreadMs = 0.0;
+	TotalOutBytes = 0.0;
+	TotalInBytes = 0.0;
+	MaxConnections = 0;
+
+	UE_LOG(LogITP, Log, TEXT("Net benchmark (%s): sampling for %.0f s"), *GetReplicationPathName(NetDriver), RemainingSeconds);
+}
+
+void UITPNetBenchmarkSubsystem::Finish()
+{
+	RemainingSeconds = 0.f;
+
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (!NetDriver || NumFrames == 0 || SampledSeconds <= 0.0)
+	{
+		return;
+	}
+
+	const double OutBytesPerSecond = TotalOutBytes / SampledSeconds;
+	UE_LOG(LogITP, Log, TEXT("Net benchmark (%s): %d client(s), %d frames, game thread avg %.2f ms max %.2f ms, out %.1f KB/s (%.1f KB/s per client), in %.1f KB/s"),
+		*GetReplicationPathName(NetDriver),
+		MaxConnections,
+		NumFrames,
+		TotalGameThreadMs / NumFrames,
+		MaxGameThreadMs,
+		OutBytesPerSecond / 1024.0,
+		MaxConnections > 0 ? OutBytesPerSecond / 1024.0 / MaxConnections : 0.0,
+		TotalInBytes / SampledSeconds / 1024.0);
+
+	LogReport();
+}
+
+void UITPNetBenchmarkSubsystem::LogReport() const
+{
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (!NetDriver)
+	{
+		UE_LOG(LogITP, Log, TEXT("Net: no net driver"));
+		return;
+	}
+
+	int32 NumReplicated = 0;
+	int32 NumDormant = 0;
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		if (It->GetIsReplicated())
+		{
+			++NumReplicated;
+			NumDormant += It->NetDormancy > DORM_Awake ? 1 : 0;
+		}
+	}
+
+	UE_LOG(LogITP, Log, TEXT("Net: %s replication, %s, %d connection(s), %d replicated actor(s) (%d dormant)"),
+		*GetReplicationPathName(NetDriver),
+		NetDriver->IsServer() ? TEXT("server") : TEXT("client"),
+		NetDriver->IsServer() ? NetDriver->ClientConnections.Num() : 1,
+		NumReplicated,
+		NumDormant);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdITPNetBenchmark(
+	TEXT("ITP.Net.Benchmark"),
+	TEXT("ITP.Net.Benchmark [Seconds=30]: on the server, logs average game thread time and bandwidth over the window.\n")
+	TEXT("Run the same local session twice, e.g. a -server instance plus N -game clients connecting to 127.0.0.1, once as configured (Iris)\n")
+	TEXT("and once with -ini:Engine:[SystemSettings]:net.Iris.UseIrisReplication=0 on the server for the legacy path."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UITPNetBenchmarkSubsystem* Benchmark = World ? World->GetSubsystem<UITPNetBenchmarkSubsystem>() : nullptr)
+		{
+			Benchmark->Start(Args.Num() > 0 ? FCString::Atof(*Args[0]) : 30.f);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld CmdITPNetReport(
+	TEXT("ITP.Net.Report"),
+	TEXT("Logs the replication path in use, connections and replicated actor count."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UITPNetBenchmarkSubsystem* Benchmark = World ? World->GetSubsystem<UITPNetBenchmarkSubsystem>() : nullptr)
+		{
+			Benchmark->LogReport();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld CmdITPNetProxyReport(
+	TEXT("ITP.Net.ProxyReport"),
+	TEXT("Logs playout delay, jitter and extrapolated frames of every interpolated remote character.\n")
+	TEXT("Use with NetEmulation.PktEmulationProfile ITPGlideJitter to check interpolation on a bad link."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (!World)
+		{
+			return;
+		}
+
+		for (TActorIterator<AITPCharacter> It(World); It; ++It)
+		{
+			const FITPSnapshotBuffer& Snapshots = It->GetProxySnapshots();
+			if (It->GetLocalRole() != ROLE_SimulatedProxy || Snapshots.IsEmpty())
+			{
+				continue;
+			}
+
+			UE_LOG(LogITP, Log, TEXT("%s: delay %.0f ms (target %.0f ms), jitter %.1f ms, %d extrapolated frame(s)"),
+				*It->GetName(),
+				Snapshots.GetCurrentDelay() * 1000.f,
+				Snapshots.GetTargetDelay() * 1000.f,
+				Snapshots.GetJitter() * 1000.f,
+				Snapshots.GetNumExtrapolated());
+		}
+	}));
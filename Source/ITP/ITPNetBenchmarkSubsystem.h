@@ -0,0 +1,45 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ITPNetBenchmarkSubsystem.generated.h"
+
+/**
+ * Server-side replication benchmark. Samples game thread time and outgoing bandwidth for a fixed window and logs
+ * the result tagged with the replication path (Iris or legacy), so runs of the same local multi-client session
+ * can be compared. Started with ITP.Net.Benchmark.
+ */
+UCLASS()
+class ITP_API UITPNetBenchmarkSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual bool IsTickable() const override;
+
+	void Start(float Seconds);
+	bool IsRunning() const { return RemainingSeconds > 0.f; }
+
+	/** Logs the replication path, connection count and replicated actor count */
+	void LogReport() const;
+
+private:
+	void Finish();
+
+	float RemainingSeconds = 0.f;
+	double SampledSeconds = 0.0;
+	int32 NumFrames = 0;
+
+	double TotalGameThreadMs = 0.0;
+	double MaxGameThreadMs = 0.0;
+
+	/** Time-weighted, the net driver only refreshes its rate once per second */
+	double TotalOutBytes = 0.0;
+	double TotalInBytes = 0.0;
+	int32 MaxConnections = 0;
+};
@@ -0,0 +1,70 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPOriginSubsystem.h"
+#include "ITP.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_CYCLE_STAT(TEXT("Origin Shift"), STAT_ITPOriginShift, STATGROUP_ITP);
+
+static float GITPOriginShiftThreshold = 100000.f;
+static FAutoConsoleVariableRef CVarITPOriginShiftThreshold(
+	TEXT("ITP.Origin.ShiftThreshold"),
+	GITPOriginShiftThreshold,
+	TEXT("Distance (cm) from the plane origin along the scroll axis at which ITP data is rebased. 0 disables shifting."),
+	ECVF_Default);
+
+void UITPOriginSubsystem::Tick(float DeltaTime)
+{
+	if (GITPOriginShiftThreshold <= 0.f)
+	{
+		return;
+	}
+
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+	if (!Pawn)
+	{
+		return;
+	}
+
+	const float Scroll = ITP2D::FromWorld(Pawn->GetActorLocation(), Origin).X;
+	if (FMath::Abs(Scroll) >= GITPOriginShiftThreshold)
+	{
+		// Whole tiles keep tile indices integral across the shift
+		ShiftOrigin(FMath::RoundToInt32(Scroll / ITP2D::DefaultTileSize));
+	}
+}
+
+TStatId UITPOriginSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UITPOriginSubsystem, STATGROUP_Tickables);
+}
+
+bool UITPOriginSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UITPOriginSubsystem::ShiftOrigin(int32 Tiles)
+{
+	if (Tiles == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ITPOriginShift);
+
+	FITPOriginShift Shift;
+	Shift.TileOffset = -Tiles;
+	Shift.LocationOffset = -(float)Tiles * ITP2D::DefaultTileSize;
+	Shift.NewOrigin.Scroll = Origin.Scroll + (double)Tiles * ITP2D::DefaultTileSize;
+
+	Origin = Shift.NewOrigin;
+	++NumShifts;
+
+	OnOriginShifted.Broadcast(Shift);
+
+	UE_LOG(LogITP, Verbose, TEXT("Origin shifted by %d tiles, scroll origin now %.0f cm"), Tiles, Origin.Scroll);
+}
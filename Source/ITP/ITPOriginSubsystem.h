@@ -0,0 +1,49 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ITPMath2D.h"
+#include "ITPOriginSubsystem.generated.h"
+
+/** Describes one origin shift. Plane locations must add LocationOffset, tile coordinates TileOffset. */
+struct FITPOriginShift
+{
+	float LocationOffset = 0.f;
+	int32 TileOffset = 0;
+	ITP2D::FPlaneOrigin NewOrigin;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FITPOnOriginShifted, const FITPOriginShift&);
+
+/**
+ * Keeps ITP float simulation data close to zero on endless runs.
+ * When the local character passes ITP.Origin.ShiftThreshold along the scroll axis, the plane origin is moved
+ * by a whole number of tiles and every registered ITP system rebases its data in one pass.
+ * Engine actors stay in double precision world space and are not moved.
+ */
+UCLASS()
+class UITPOriginSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	const ITP2D::FPlaneOrigin& GetOrigin() const { return Origin; }
+
+	/** Moves the origin by whole tiles along the scroll axis and rebases all listeners */
+	void ShiftOrigin(int32 Tiles);
+
+	/** ITP systems holding plane locations or tile coordinates register here */
+	FITPOnOriginShifted OnOriginShifted;
+
+	int32 GetNumShifts() const { return NumShifts; }
+
+private:
+	ITP2D::FPlaneOrigin Origin;
+	int32 NumShifts = 0;
+};
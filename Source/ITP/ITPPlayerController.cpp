@@ -0,0 +1,73 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPPlayerController.h"
+#include "ITPIdleSubsystem.h"
+#include "ITPLevelStateSubsystem.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+
+void AITPPlayerController::ClientReceiveLevelState_Implementation(int32 Part, int32 NumParts, const TArray<uint8>& Data)
+{
+	if (UITPLevelStateSubsystem* LevelState = GetWorld()->GetSubsystem<UITPLevelStateSubsystem>())
+	{
+		LevelState->ReceiveSnapshotPart(Part, NumParts, Data);
+	}
+}
+
+void AITPPlayerController::ClientReceiveLevelStateDelta_Implementation(const TArray<uint32>& Events)
+{
+	if (UITPLevelStateSubsystem* LevelState = GetWorld()->GetSubsystem<UITPLevelStateSubsystem>())
+	{
+		LevelState->ApplyEvents(Events);
+	}
+}
+
+void AITPPlayerController::SetMenuOpen(bool bOpen)
+{
+	if (bOpen == bMenuOpen || !IsLocalController())
+	{
+		return;
+	}
+	bMenuOpen = bOpen;
+
+	// Every push is matched by exactly one pop, here or in EndPlay
+	if (UITPIdleSubsystem* Idle = UGameInstance::GetSubsystem<UITPIdleSubsystem>(GetGameInstance()))
+	{
+		if (bOpen)
+		{
+			Idle->PushIdleReason(UITPIdleSubsystem::MenuReason);
+		}
+		else
+		{
+			Idle->PopIdleReason(UITPIdleSubsystem::MenuReason);
+		}
+	}
+
+	SetShowMouseCursor(bOpen);
+	if (bOpen)
+	{
+		SetInputMode(FInputModeGameAndUI());
+	}
+	else
+	{
+		SetInputMode(FInputModeGameOnly());
+	}
+}
+
+bool AITPPlayerController::SetPause(bool bPause, FCanUnpause CanUnpauseDelegate)
+{
+	const bool bResult = Super::SetPause(bPause, CanUnpauseDelegate);
+	if (bResult)
+	{
+		SetMenuOpen(bPause);
+	}
+	return bResult;
+}
+
+void AITPPlayerController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// The idle subsystem outlives this controller, e.g. across a travel with the menu open
+	SetMenuOpen(false);
+
+	Super::EndPlay(EndPlayReason);
+}
@@ -0,0 +1,44 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/PlayerController.h"
+#include "ITPPlayerController.generated.h"
+
+UCLASS()
+class AITPPlayerController : public APlayerController
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Level state snapshot sent once on join (see UITPLevelStateSubsystem).
+	 * Split into parts so no RPC array exceeds net.MaxRepArraySize.
+	 */
+	UFUNCTION(Client, Reliable)
+	void ClientReceiveLevelState(int32 Part, int32 NumParts, const TArray<uint8>& Data);
+
+	/** Level state changes since the snapshot, one packed event per changed tile or entity */
+	UFUNCTION(Client, Reliable)
+	void ClientReceiveLevelStateDelta(const TArray<uint32>& Events);
+
+	/** Server: set once the snapshot went out, from then on this controller receives deltas */
+	bool bLevelStateSent = false;
+
+	/** Shows or hides the in-game menu's input state and holds UITPIdleSubsystem::MenuReason while it is open */
+	UFUNCTION(BlueprintCallable, Category = Menu)
+	void SetMenuOpen(bool bOpen);
+
+	UFUNCTION(BlueprintPure, Category = Menu)
+	bool IsMenuOpen() const { return bMenuOpen; }
+
+	/** Pausing opens the menu state and unpausing closes it */
+	virtual bool SetPause(bool bPause, FCanUnpause CanUnpauseDelegate = FCanUnpause()) override;
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	bool bMenuOpen = false;
+};
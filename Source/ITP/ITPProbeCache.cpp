@@ -0,0 +1,59 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPProbeCache.h"
+#include "ITP.h"
+#include "ITPCollision.h"
+#include "ITPCollisionSubsystem.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Probe Cache Hits"), STAT_ITPProbeCacheHits, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Probe Cache Misses"), STAT_ITPProbeCacheMisses, STATGROUP_ITP);
+
+bool FITPProbeCache::LineProbe(EITPProbe Kind, const UWorld* World, FHitResult& OutHit, const FVector& Start, const FVector& End, const FCollisionQueryParams& Params)
+{
+	FEntry& Entry = Entries[(uint8)Kind];
+	const UITPCollisionSubsystem* Collision = World->GetSubsystem<UITPCollisionSubsystem>();
+
+	if (Entry.bValid
+		&& FVector::DistSquared(Entry.Start, Start) <= FMath::Square(Tolerance)
+		&& FVector::DistSquared(Entry.End, End) <= FMath::Square(Tolerance))
+	{
+		// A hit on movable geometry (platforms, falling blocks) can move away under a stationary probe. Misses are
+		// kept: UITPCollisionSubsystem invalidates the region whenever movable geometry the probes can hit moves.
+		const UPrimitiveComponent* HitComponent = Entry.Hit.GetComponent();
+		const bool bStaticHit = !Entry.bBlockingHit || (HitComponent && HitComponent->Mobility != EComponentMobility::Movable);
+		FBox ProbeBounds(ForceInit);
+		ProbeBounds += Entry.Start;
+		ProbeBounds += Entry.End;
+		const bool bDirty = Collision && Collision->IsRegionDirtySince(Entry.Generation, ProbeBounds);
+
+		if (bStaticHit && !bDirty)
+		{
+			++NumHits;
+			INC_DWORD_STAT(STAT_ITPProbeCacheHits);
+			OutHit = Entry.Hit;
+			return Entry.bBlockingHit;
+		}
+	}
+
+	++NumMisses;
+	INC_DWORD_STAT(STAT_ITPProbeCacheMisses);
+
+	Entry.Start = Start;
+	Entry.End = End;
+	Entry.Generation = Collision ? Collision->GetGeneration() : 0;
+	Entry.bBlockingHit = ITPCollision::LineProbeGround(World, Entry.Hit, Start, End, Params);
+	Entry.bValid = true;
+
+	OutHit = Entry.Hit;
+	return Entry.bBlockingHit;
+}
+
+void FITPProbeCache::Reset()
+{
+	for (FEntry& Entry : Entries)
+	{
+		Entry.bValid = false;
+	}
+}
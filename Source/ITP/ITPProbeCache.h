@@ -0,0 +1,56 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/HitResult.h"
+
+class UWorld;
+struct FCollisionQueryParams;
+
+/** Probes a character issues every frame. Each kind keeps its own cached result. */
+enum class EITPProbe : uint8
+{
+	Ground,
+	Wall,
+	Ceiling,
+
+	Num
+};
+
+/**
+ * Per-character cache for ground/wall/ceiling probes.
+ * A probe whose start and end moved less than Tolerance since the last full query reuses that result,
+ * unless the geometry around it was invalidated through UITPCollisionSubsystem (which also happens whenever movable
+ * geometry moves) or the hit was on something movable.
+ */
+struct FITPProbeCache
+{
+	/** Max distance (cm) the probe may drift before a full query is issued */
+	float Tolerance = 2.f;
+
+	bool LineProbe(EITPProbe Kind, const UWorld* World, FHitResult& OutHit, const FVector& Start, const FVector& End, const FCollisionQueryParams& Params);
+
+	/** Drops all cached results, e.g. after a teleport */
+	void Reset();
+
+	uint32 GetNumHits() const { return NumHits; }
+	uint32 GetNumMisses() const { return NumMisses; }
+	float GetHitRate() const { return NumHits + NumMisses > 0 ? float(NumHits) / float(NumHits + NumMisses) : 0.f; }
+
+private:
+	struct FEntry
+	{
+		FVector Start = FVector::ZeroVector;
+		FVector End = FVector::ZeroVector;
+		FHitResult Hit;
+		uint32 Generation = 0;
+		bool bBlockingHit = false;
+		bool bValid = false;
+	};
+
+	FEntry Entries[(uint8)EITPProbe::Num];
+
+	uint32 NumHits = 0;
+	uint32 NumMisses = 0;
+};
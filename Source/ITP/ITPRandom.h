@@ -0,0 +1,93 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Counter-based random stream (Widynski's "Squares" generator).
+ * The output for draw N depends only on Key and N, so streams are plain values: copy them into worker
+ * tasks, generate chunks in any order and get the same numbers as a serial run.
+ */
+struct FITPRandomStream
+{
+	uint64 Key = 1;
+	uint64 Counter = 0;
+
+	FITPRandomStream() = default;
+	explicit FITPRandomStream(uint64 InKey) : Key(InKey | 1) {}
+
+	/** Stateless draw at an absolute index */
+	static FORCEINLINE uint32 Squares(uint64 Index, uint64 Key)
+	{
+		uint64 X = Index * Key;
+		const uint64 Y = X;
+		const uint64 Z = Y + Key;
+		X = X * X + Y; X = (X >> 32) | (X << 32);
+		X = X * X + Z; X = (X >> 32) | (X << 32);
+		X = X * X + Y; X = (X >> 32) | (X << 32);
+		return (uint32)((X * X + Z) >> 32);
+	}
+
+	FORCEINLINE uint32 NextUInt() { return Squares(Counter++, Key); }
+
+	/** Uniform in [0, 1) */
+	FORCEINLINE float NextFloat() { return (float)(NextUInt() >> 8) * (1.f / 16777216.f); }
+
+	/** Uniform in [Min, Max], inclusive */
+	FORCEINLINE int32 RandRange(int32 Min, int32 Max)
+	{
+		const uint64 Range = (uint64)((int64)Max - (int64)Min) + 1;
+		return Min + (int32)(((uint64)NextUInt() * Range) >> 32);
+	}
+
+	/** Fills Out with the next Out.Num() draws. The loop has no carried state so it vectorizes. */
+	void Fill(TArrayView<uint32> Out)
+	{
+		const uint64 Base = Counter;
+		const uint64 LocalKey = Key;
+		uint32* RESTRICT Data = Out.GetData();
+		for (int32 Index = 0; Index < Out.Num(); ++Index)
+		{
+			Data[Index] = Squares(Base + (uint64)Index, LocalKey);
+		}
+		Counter += (uint64)Out.Num();
+	}
+
+	void FillFloat(TArrayView<float> Out)
+	{
+		const uint64 Base = Counter;
+		const uint64 LocalKey = Key;
+		float* RESTRICT Data = Out.GetData();
+		for (int32 Index = 0; Index < Out.Num(); ++Index)
+		{
+			Data[Index] = (float)(Squares(Base + (uint64)Index, LocalKey) >> 8) * (1.f / 16777216.f);
+		}
+		Counter += (uint64)Out.Num();
+	}
+
+	/** Sub-stream for one chunk of parallel generation, independent of every other chunk */
+	FITPRandomStream Fork(uint64 ChunkIndex) const;
+};
+
+namespace ITPRandom
+{
+	/** SplitMix64 finalizer, used to derive well mixed stream keys */
+	FORCEINLINE uint64 Mix(uint64 Value)
+	{
+		Value += 0x9E3779B97F4A7C15ull;
+		Value = (Value ^ (Value >> 30)) * 0xBF58476D1CE4E5B9ull;
+		Value = (Value ^ (Value >> 27)) * 0x94D049BB133111EBull;
+		return Value ^ (Value >> 31);
+	}
+
+	FORCEINLINE uint64 MakeKey(uint64 RunSeed, uint64 SystemHash, uint64 Entity)
+	{
+		return Mix(Mix(Mix(RunSeed) ^ SystemHash) ^ Entity) | 1;
+	}
+}
+
+inline FITPRandomStream FITPRandomStream::Fork(uint64 ChunkIndex) const
+{
+	return FITPRandomStream(ITPRandom::MakeKey(Key, Counter, ChunkIndex));
+}
@@ -0,0 +1,66 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPRandomSubsystem.h"
+#include "ITP.h"
+#include "ITPChecksumSubsystem.h"
+#include "HAL/PlatformTime.h"
+#include "Hash/CityHash.h"
+#include "Kismet/GameplayStatics.h"
+
+const FString UITPRandomSubsystem::RunSlotName(TEXT("ITPRun"));
+
+void UITPRandomSubsystem::StartRun(uint64 Seed)
+{
+	RunSeed = Seed;
+	SharedStreams.Reset();
+
+	UE_LOG(LogITP, Log, TEXT("Run seed %llu"), RunSeed);
+}
+
+void UITPRandomSubsystem::StartNewRun()
+{
+	StartRun(ITPRandom::Mix(FPlatformTime::Cycles64() ^ (uint64)FPlatformTime::Seconds()));
+
+	UITPRunSaveGame* SaveGame = Cast<UITPRunSaveGame>(UGameplayStatics::CreateSaveGameObject(UITPRunSaveGame::StaticClass()));
+	SaveGame->RunSeed = RunSeed;
+	UGameplayStatics::AsyncSaveGameToSlot(SaveGame, RunSlotName, 0);
+}
+
+bool UITPRandomSubsystem::LoadRun(const FString& SlotName)
+{
+	const UITPRunSaveGame* SaveGame = Cast<UITPRunSaveGame>(UGameplayStatics::LoadGameFromSlot(SlotName, 0));
+	if (!SaveGame)
+	{
+		return false;
+	}
+
+	StartRun(SaveGame->RunSeed);
+	return true;
+}
+
+FITPRandomStream UITPRandomSubsystem::MakeStream(FName System, uint64 Entity) const
+{
+	// Hash the string rather than the FName index, which differs between processes
+	const FTCHARToUTF8 SystemString(*System.ToString());
+	const uint64 SystemHash = CityHash64(SystemString.Get(), SystemString.Length());
+	return FITPRandomStream(ITPRandom::MakeKey(RunSeed, SystemHash, Entity));
+}
+
+FITPRandomStream& UITPRandomSubsystem::GetSharedStream(FName System)
+{
+	if (FITPRandomStream* Stream = SharedStreams.Find(System))
+	{
+		return *Stream;
+	}
+	return SharedStreams.Add(System, MakeStream(System));
+}
+
+void UITPRandomSubsystem::AppendChecksum(FITPChecksumBuilder& Builder) const
+{
+	Builder.Add(RunSeed);
+	for (const TPair<FName, FITPRandomStream>& Pair : SharedStreams)
+	{
+		Builder.Add(Pair.Value.Key);
+		Builder.Add(Pair.Value.Counter);
+	}
+}
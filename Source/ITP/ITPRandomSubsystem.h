@@ -0,0 +1,61 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/SaveGame.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "ITPRandom.h"
+#include "ITPRandomSubsystem.generated.h"
+
+struct FITPChecksumBuilder;
+
+/** Save slot contents needed to reproduce a run */
+UCLASS()
+class UITPRunSaveGame : public USaveGame
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY()
+	uint64 RunSeed = 0;
+};
+
+/**
+ * Hands out deterministic random streams keyed by system and entity, all derived from the run seed.
+ * The seed comes from the URL (?RunSeed=), a save slot (?LoadRun=), or is rolled fresh; it is replicated
+ * through AITPGameState so clients and replays draw the same numbers.
+ */
+UCLASS()
+class UITPRandomSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static const FString RunSlotName;
+
+	/** Starts a run with Seed and drops all shared streams */
+	void StartRun(uint64 Seed);
+
+	/** Starts a run with a fresh seed and writes it to the run save slot */
+	void StartNewRun();
+
+	/** Starts a run with the seed stored in SlotName. Returns false if the slot does not exist. */
+	bool LoadRun(const FString& SlotName);
+
+	uint64 GetRunSeed() const { return RunSeed; }
+
+	/** Independent stream for one entity of one system. Value type, safe to use on any thread. */
+	FITPRandomStream MakeStream(FName System, uint64 Entity = 0) const;
+
+	/** Game thread stream owned by the subsystem, e.g. for loot rolls. Its counter is part of the simulation checksum. */
+	FITPRandomStream& GetSharedStream(FName System);
+
+	void AppendChecksum(FITPChecksumBuilder& Builder) const;
+
+private:
+	uint64 RunSeed = 0;
+
+	/** Sorted by name so checksums are independent of creation order */
+	TSortedMap<FName, FITPRandomStream, FDefaultAllocator, FNameLexicalLess> SharedStreams;
+};
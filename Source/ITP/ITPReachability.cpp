@@ -0,0 +1,115 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPReachability.h"
+
+namespace ITPReachability
+{
+	/** First stand cell at or below (X, Y), or -1 if the column drops out of the level */
+	static int32 DropTo(const FITPReachabilityInput& Input, int32 X, int32 Y)
+	{
+		for (int32 DropY = FMath::Min(Y, Input.Size.Y - 1); DropY > 0; --DropY)
+		{
+			if (Input.IsSolid(X, DropY))
+			{
+				return -1;
+			}
+			if (Input.IsSolid(X, DropY - 1))
+			{
+				return DropY;
+			}
+		}
+		return -1;
+	}
+
+	static bool IsColumnClear(const FITPReachabilityInput& Input, int32 X, int32 FromY, int32 ToY)
+	{
+		for (int32 Y = FromY; Y <= ToY; ++Y)
+		{
+			if (Input.IsSolid(X, Y))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void Analyze(const FITPReachabilityInput& Input, FITPReachabilityResult& OutResult)
+	{
+		const int32 NumCells = Input.Size.X * Input.Size.Y;
+		OutResult.Reachable.Init(false, NumCells);
+		OutResult.TargetReachable.Init(false, Input.Targets.Num());
+		OutResult.NumReachable = 0;
+
+		const int32 StartY = DropTo(Input, Input.Start.X, Input.Start.Y);
+		if (NumCells == 0 || StartY < 0)
+		{
+			return;
+		}
+
+		TArray<FIntPoint> Open;
+		const auto Visit = [&](int32 X, int32 Y)
+		{
+			const int32 Index = Y * Input.Size.X + X;
+			if (!OutResult.Reachable[Index])
+			{
+				OutResult.Reachable[Index] = true;
+				++OutResult.NumReachable;
+				Open.Add(FIntPoint(X, Y));
+			}
+		};
+
+		Visit(Input.Start.X, StartY);
+
+		while (Open.Num() > 0)
+		{
+			const FIntPoint Cell = Open.Pop(false);
+			const int32 Apex = Cell.Y + Input.JumpHeight;
+
+			// Headroom straight above the take-off cell limits every jump from here
+			int32 Headroom = Cell.Y;
+			while (Headroom < Apex && !Input.IsSolid(Cell.X, Headroom + 1))
+			{
+				++Headroom;
+			}
+
+			const int32 MaxReach = Input.JumpDistance + Input.MaxGlideDistance;
+			for (int32 Dx = -MaxReach; Dx <= MaxReach; ++Dx)
+			{
+				const int32 X = Cell.X + Dx;
+				if (X < 0 || X >= Input.Size.X)
+				{
+					continue;
+				}
+
+				// Jump up or across onto ledges up to the apex
+				if (FMath::Abs(Dx) <= Input.JumpDistance)
+				{
+					for (int32 Y = Cell.Y; Y <= Headroom; ++Y)
+					{
+						if (Input.IsStand(X, Y) && IsColumnClear(Input, X, Y, Headroom))
+						{
+							Visit(X, Y);
+						}
+					}
+				}
+
+				// Fall or glide down; the longer the drop the further a glide carries
+				if (IsColumnClear(Input, X, Cell.Y, Headroom))
+				{
+					const int32 LandY = DropTo(Input, X, Cell.Y);
+					if (LandY >= 0 && FMath::Abs(Dx) <= Input.JumpDistance + FMath::FloorToInt32(Input.GlideRatio * (float)(Headroom - LandY)))
+					{
+						Visit(X, LandY);
+					}
+				}
+			}
+		}
+
+		for (int32 TargetIndex = 0; TargetIndex < Input.Targets.Num(); ++TargetIndex)
+		{
+			const FIntPoint& Target = Input.Targets[TargetIndex];
+			const int32 StandY = Target.X >= 0 && Target.X < Input.Size.X ? DropTo(Input, Target.X, Target.Y) : -1;
+			OutResult.TargetReachable[TargetIndex] = StandY >= 0 && OutResult.Reachable[StandY * Input.Size.X + Target.X];
+		}
+	}
+}
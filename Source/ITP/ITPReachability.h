@@ -0,0 +1,55 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Snapshot of a level's solid tiles for the reachability analyzer. Built on the game thread, read on a worker. */
+struct FITPReachabilityInput
+{
+	FIntPoint Size = FIntPoint::ZeroValue;
+
+	/** Size.X * Size.Y bits, row-major from the bottom row */
+	TBitArray<> Solid;
+
+	FIntPoint Start = FIntPoint::ZeroValue;
+
+	/** Tiles that should be reachable (checkpoints, goal, coins) */
+	TArray<FIntPoint> Targets;
+
+	/** Movement envelope in tiles, derived from the character's jump and glide tuning */
+	int32 JumpHeight = 2;
+	int32 JumpDistance = 4;
+	float GlideRatio = 2.f;
+
+	/** Caps how far a glide is searched sideways, which bounds the work per cell */
+	int32 MaxGlideDistance = 16;
+
+	FORCEINLINE bool IsSolid(int32 X, int32 Y) const
+	{
+		return X < 0 || X >= Size.X || (Y >= 0 && Y < Size.Y && Solid[Y * Size.X + X]);
+	}
+
+	/** A cell the character can stand in: empty with solid ground below */
+	FORCEINLINE bool IsStand(int32 X, int32 Y) const
+	{
+		return Y > 0 && Y < Size.Y && !IsSolid(X, Y) && IsSolid(X, Y - 1);
+	}
+};
+
+struct FITPReachabilityResult
+{
+	/** Reachable stand cells, same layout as FITPReachabilityInput::Solid */
+	TBitArray<> Reachable;
+
+	/** Per input target */
+	TArray<bool> TargetReachable;
+
+	int32 NumReachable = 0;
+};
+
+namespace ITPReachability
+{
+	/** Flood fill over stand cells using walk, jump and glide-fall moves. Pure function, safe on any thread. */
+	ITP_API void Analyze(const FITPReachabilityInput& Input, FITPReachabilityResult& OutResult);
+}
@@ -0,0 +1,85 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPRunLength.h"
+
+namespace ITPRunLength
+{
+	void WriteVarInt(TArray<uint8>& Out, uint32 Value)
+	{
+		while (Value >= 0x80)
+		{
+			Out.Add((uint8)(Value | 0x80));
+			Value >>= 7;
+		}
+		Out.Add((uint8)Value);
+	}
+
+	bool ReadVarInt(const uint8*& Cursor, const uint8* End, uint32& OutValue)
+	{
+		OutValue = 0;
+		for (int32 Shift = 0; Shift < 35; Shift += 7)
+		{
+			if (Cursor >= End)
+			{
+				return false;
+			}
+
+			const uint8 Byte = *Cursor++;
+			OutValue |= (uint32)(Byte & 0x7f) << Shift;
+			if ((Byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void EncodeBits(const TBitArray<>& Bits, TArray<uint8>& Out)
+	{
+		bool bRunValue = false;
+		int32 RunStart = 0;
+		for (;;)
+		{
+			// Find is word-at-a-time, so long runs are skipped quickly
+			const int32 RunEnd = Bits.FindFrom(!bRunValue, RunStart);
+			const int32 End = RunEnd == INDEX_NONE ? Bits.Num() : RunEnd;
+			WriteVarInt(Out, (uint32)(End - RunStart));
+			if (RunEnd == INDEX_NONE)
+			{
+				return;
+			}
+
+			RunStart = End;
+			bRunValue = !bRunValue;
+		}
+	}
+
+	bool DecodeBits(const uint8*& Cursor, const uint8* End, int32 NumBits, TBitArray<>& OutBits)
+	{
+		OutBits.Init(false, NumBits);
+
+		bool bRunValue = false;
+		int32 Position = 0;
+		for (;;)
+		{
+			uint32 Run;
+			if (!ReadVarInt(Cursor, End, Run) || Run > (uint32)(NumBits - Position))
+			{
+				return false;
+			}
+
+			if (bRunValue && Run > 0)
+			{
+				OutBits.SetRange(Position, (int32)Run, true);
+			}
+			Position += (int32)Run;
+
+			// The encoder ends with the run that reaches the end, even an empty bitset writes one
+			if (Position == NumBits)
+			{
+				return true;
+			}
+			bRunValue = !bRunValue;
+		}
+	}
+}
@@ -0,0 +1,24 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Run-length coding of bitsets for network payloads.
+ * A bitset is written as alternating run lengths, starting with a run of zeros (possibly empty), each as a
+ * LEB128 varint. Level state is long stretches of untouched tiles with the occasional broken block or
+ * collected coin, so a run is usually one or two bytes regardless of how far apart changes are.
+ */
+namespace ITPRunLength
+{
+	void WriteVarInt(TArray<uint8>& Out, uint32 Value);
+
+	/** False on truncated or oversized input */
+	bool ReadVarInt(const uint8*& Cursor, const uint8* End, uint32& OutValue);
+
+	void EncodeBits(const TBitArray<>& Bits, TArray<uint8>& Out);
+
+	/** Decodes exactly NumBits bits into OutBits. False if the runs do not add up to NumBits. */
+	bool DecodeBits(const uint8*& Cursor, const uint8* End, int32 NumBits, TBitArray<>& OutBits);
+}
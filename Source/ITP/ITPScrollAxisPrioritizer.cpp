@@ -0,0 +1,66 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPScrollAxisPrioritizer.h"
+#include "ITP.h"
+#include "ITPMath2D.h"
+#include "Iris/ReplicationSystem/ReplicationView.h"
+
+DECLARE_CYCLE_STAT(TEXT("Net Scroll Prioritize"), STAT_ITPNetScrollPrioritize, STATGROUP_ITP);
+
+void UITPScrollAxisPrioritizer::Init(FNetObjectPrioritizerInitParams& Params)
+{
+	checkf(Params.Config != nullptr, TEXT("UITPScrollAxisPrioritizer needs a UITPScrollAxisPrioritizerConfig."));
+	Config = TStrongObjectPtr<UITPScrollAxisPrioritizerConfig>(CastChecked<UITPScrollAxisPrioritizerConfig>(Params.Config));
+
+	Super::Init(Params);
+}
+
+void UITPScrollAxisPrioritizer::Deinit()
+{
+	Super::Deinit();
+
+	Config.Reset();
+}
+
+void UITPScrollAxisPrioritizer::Prioritize(FNetObjectPrioritizationParams& Params)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ITPNetScrollPrioritize);
+
+	const UE::Net::FReplicationView& View = Params.View;
+	const float VerticalWeight = Config->VerticalWeight;
+
+	for (uint32 It = 0; It < Params.ObjectCount; ++It)
+	{
+		const uint32 ObjectIndex = Params.ObjectIndices[It];
+
+		FVector::FReal Components[4];
+		VectorStore(GetLocation(Params.PrioritizationInfos[ObjectIndex]), Components);
+		const FVector Location(Components[0], Components[1], Components[2]);
+
+		// Split screen has several views per connection; the closest one decides
+		float Priority = Config->OutsidePriority;
+		for (const UE::Net::FReplicationView::FView& ConnectionView : View.Views)
+		{
+			const FVector Delta = Location - ConnectionView.Pos;
+			const float Distance = FMath::Abs(Delta | ITP2D::ScrollAxis) + FMath::Abs(Delta.Z) * VerticalWeight;
+			Priority = FMath::Max(Priority, GetPriority(Distance));
+		}
+
+		Params.Priorities[ObjectIndex] = Priority;
+	}
+}
+
+float UITPScrollAxisPrioritizer::GetPriority(float ScrollDistance) const
+{
+	if (ScrollDistance <= Config->InnerDistance)
+	{
+		return Config->InnerPriority;
+	}
+	if (ScrollDistance >= Config->OuterDistance)
+	{
+		return Config->OutsidePriority;
+	}
+
+	const float Alpha = (ScrollDistance - Config->InnerDistance) / FMath::Max(Config->OuterDistance - Config->InnerDistance, UE_KINDA_SMALL_NUMBER);
+	return FMath::Lerp(Config->InnerPriority, Config->OuterPriority, Alpha);
+}
@@ -0,0 +1,59 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Iris/ReplicationSystem/Prioritization/LocationBasedNetObjectPrioritizer.h"
+#include "UObject/StrongObjectPtr.h"
+#include "ITPScrollAxisPrioritizer.generated.h"
+
+/** Tuning for UITPScrollAxisPrioritizer, read from [/Script/ITP.ITPScrollAxisPrioritizerConfig] in DefaultEngine.ini */
+UCLASS(transient, config=Engine)
+class UITPScrollAxisPrioritizerConfig : public UNetObjectPrioritizerConfig
+{
+	GENERATED_BODY()
+
+public:
+	/** Objects closer than this to a view along the scroll axis get InnerPriority */
+	UPROPERTY(Config)
+	float InnerDistance = 1500.f;
+
+	/** Priority falls linearly from InnerPriority to OuterPriority up to this distance */
+	UPROPERTY(Config)
+	float OuterDistance = 6000.f;
+
+	UPROPERTY(Config)
+	float InnerPriority = 1.f;
+
+	UPROPERTY(Config)
+	float OuterPriority = 0.2f;
+
+	/** Priority beyond OuterDistance. Above zero so far objects still update now and then */
+	UPROPERTY(Config)
+	float OutsidePriority = 0.05f;
+
+	/** How much height difference counts against scroll distance; the camera frames a tall strip, not a sphere */
+	UPROPERTY(Config)
+	float VerticalWeight = 0.25f;
+};
+
+/**
+ * Iris prioritizer for the side-scroller. Ranks objects by their distance from each connection's view along
+ * ITP2D::ScrollAxis instead of the 3D distance used by the engine's sphere prioritizer, so objects just off screen
+ * ahead of or behind the player win over objects far above or below. Locations are kept by the base class.
+ */
+UCLASS()
+class UITPScrollAxisPrioritizer : public ULocationBasedNetObjectPrioritizer
+{
+	GENERATED_BODY()
+
+protected:
+	virtual void Init(FNetObjectPrioritizerInitParams& Params) override;
+	virtual void Deinit() override;
+	virtual void Prioritize(FNetObjectPrioritizationParams& Params) override;
+
+private:
+	float GetPriority(float ScrollDistance) const;
+
+	TStrongObjectPtr<UITPScrollAxisPrioritizerConfig> Config;
+};
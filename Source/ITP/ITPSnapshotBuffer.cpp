@@ -0,0 +1,206 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPSnapshotBuffer.h"
+#include "ITP.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+
+static_assert((FITPSnapshotBuffer::Capacity & (FITPSnapshotBuffer::Capacity - 1)) == 0, "FITPSnapshotBuffer::Capacity must be a power of two");
+
+void FITPSnapshotBuffer::Reset()
+{
+	*this = FITPSnapshotBuffer();
+}
+
+void FITPSnapshotBuffer::Add(const FITPSnapshot& Snapshot, double LocalTime, const FITPInterpolationSettings& Settings)
+{
+	if (Count > 0 && Snapshot.ServerTime <= GetNewestTime())
+	{
+		return;
+	}
+
+	// Jitter is the change in transit time between consecutive snapshots, as in RFC 3550; clock offset cancels out
+	const double Transit = LocalTime - Snapshot.ServerTime;
+	if (Count > 0)
+	{
+		const float NewInterval = (float)(Snapshot.ServerTime - GetNewestTime());
+		const float Alpha = Settings.JitterSmoothing;
+		Jitter += Alpha * ((float)FMath::Abs(Transit - LastTransit) - Jitter);
+		Interval = Count == 1 ? NewInterval : Interval + Alpha * (NewInterval - Interval);
+	}
+	LastTransit = Transit;
+	NewestArrival = LocalTime;
+
+	Snapshots[Head] = Snapshot;
+	Head = (Head + 1) & (Capacity - 1);
+	Count = FMath::Min(Count + 1, Capacity);
+
+	TargetDelay = FMath::Clamp(Interval + Settings.JitterMultiplier * Jitter, Settings.MinDelay, FMath::Max(Settings.MinDelay, Settings.MaxDelay));
+}
+
+bool FITPSnapshotBuffer::Sample(double LocalTime, float DescendingRate, const FITPInterpolationSettings& Settings, FITPSnapshot& OutSnapshot)
+{
+	if (Count == 0)
+	{
+		return false;
+	}
+
+	// Server time now, as far as the newest snapshot tells
+	const double LatestServerTime = GetNewestTime() + (LocalTime - NewestArrival);
+
+	if (!bPlaying || FMath::Abs(LatestServerTime - PlayoutTime - TargetDelay) > Settings.MaxDelay)
+	{
+		// First snapshot, or after a stall: jump straight to the target instead of racing to catch up
+		PlayoutTime = LatestServerTime - TargetDelay;
+		bPlaying = true;
+	}
+	else
+	{
+		// Positive error = too far behind; play slightly faster until the delay matches again
+		const double Error = LatestServerTime - PlayoutTime - TargetDelay;
+		const double Scale = 1.0 + FMath::Clamp(Error / FMath::Max(TargetDelay, UE_KINDA_SMALL_NUMBER), -Settings.MaxTimeScale, Settings.MaxTimeScale);
+		PlayoutTime += (LocalTime - LastSampleTime) * Scale;
+	}
+	LastSampleTime = LocalTime;
+	CurrentDelay = (float)(LatestServerTime - PlayoutTime);
+
+	const FITPSnapshot& Oldest = At(0);
+	const FITPSnapshot& Newest = At(Count - 1);
+	if (PlayoutTime <= Oldest.ServerTime)
+	{
+		OutSnapshot = Oldest;
+		return true;
+	}
+	if (PlayoutTime >= Newest.ServerTime)
+	{
+		OutSnapshot = Extrapolate(Newest, (float)FMath::Min(PlayoutTime - Newest.ServerTime, (double)Settings.MaxExtrapolation), DescendingRate);
+		++NumExtrapolated;
+		return true;
+	}
+
+	// The playout clock sits near the newest end, so search backwards
+	int32 Index = Count - 2;
+	while (Index > 0 && At(Index).ServerTime > PlayoutTime)
+	{
+		--Index;
+	}
+
+	const FITPSnapshot& A = At(Index);
+	const FITPSnapshot& B = At(Index + 1);
+	const double Span = B.ServerTime - A.ServerTime;
+	const float Alpha = (float)((PlayoutTime - A.ServerTime) / Span);
+
+	// Hermite through both velocities keeps the curve smooth across snapshots
+	OutSnapshot.ServerTime = PlayoutTime;
+	OutSnapshot.Location = FMath::CubicInterp(A.Location, A.Velocity * Span, B.Location, B.Velocity * Span, Alpha);
+	OutSnapshot.Velocity = FMath::Lerp(A.Velocity, B.Velocity, Alpha);
+	OutSnapshot.bGliding = A.bGliding;
+	return true;
+}
+
+FITPSnapshot FITPSnapshotBuffer::Extrapolate(const FITPSnapshot& From, float Seconds, float DescendingRate)
+{
+	FITPSnapshot Result = From;
+
+	// Same rule as DescendPlayer: a glide holds the vertical velocity at -DescendingRate
+	if (From.bGliding)
+	{
+		Result.Velocity.Z = -DescendingRate;
+	}
+
+	Result.ServerTime += Seconds;
+	Result.Location += Result.Velocity * Seconds;
+	return Result;
+}
+
+namespace ITPSnapshotBufferTest
+{
+	struct FPhaseDelays
+	{
+		float Target = 0.f;
+		float Current = 0.f;
+	};
+
+	/**
+	 * Feeds 30 Hz snapshots through calm, jittered and calm again arrival times while sampling at 60 Hz, and returns
+	 * the target and current delay averaged over the last second of each phase. Arrival jitter is uniform in
+	 * +-JitterSeconds on top of a fixed 100 ms transit, so snapshots may also arrive out of order.
+	 */
+	static void RunPhases(float JitterSeconds, FPhaseDelays OutDelays[3])
+	{
+		constexpr double SendInterval = 1.0 / 30.0;
+		constexpr double SampleInterval = 1.0 / 60.0;
+		constexpr double Transit = 0.1;
+		constexpr double PhaseSeconds = 4.0;
+
+		const FITPInterpolationSettings Settings;
+		FRandomStream Random(0x17B);
+
+		TArray<TPair<double, FITPSnapshot>> Arrivals;
+		for (double ServerTime = SendInterval; ServerTime < 3.0 * PhaseSeconds; ServerTime += SendInterval)
+		{
+			const bool bJittered = ServerTime >= PhaseSeconds && ServerTime < 2.0 * PhaseSeconds;
+			FITPSnapshot Snapshot;
+			Snapshot.ServerTime = ServerTime;
+			Snapshot.Location = FVector(0.0, 500.0 * ServerTime, 0.0);
+			Snapshot.Velocity = FVector(0.0, 500.0, 0.0);
+			Arrivals.Emplace(ServerTime + Transit + (bJittered ? Random.FRandRange(-JitterSeconds, JitterSeconds) : 0.0), Snapshot);
+		}
+		Arrivals.Sort([](const TPair<double, FITPSnapshot>& A, const TPair<double, FITPSnapshot>& B) { return A.Key < B.Key; });
+
+		FITPSnapshotBuffer Buffer;
+		int32 NextArrival = 0;
+		int32 NumSamples[3] = { 0, 0, 0 };
+		for (double LocalTime = Transit; LocalTime < 3.0 * PhaseSeconds + Transit; LocalTime += SampleInterval)
+		{
+			while (NextArrival < Arrivals.Num() && Arrivals[NextArrival].Key <= LocalTime)
+			{
+				Buffer.Add(Arrivals[NextArrival].Value, Arrivals[NextArrival].Key, Settings);
+				++NextArrival;
+			}
+
+			FITPSnapshot Presented;
+			if (!Buffer.Sample(LocalTime, 0.f, Settings, Presented))
+			{
+				continue;
+			}
+
+			// Only the last second of each phase, once the delay had time to settle
+			const int32 Phase = FMath::Min((int32)((LocalTime - Transit) / PhaseSeconds), 2);
+			if (LocalTime - Transit >= (Phase + 1) * PhaseSeconds - 1.0)
+			{
+				OutDelays[Phase].Target += Buffer.GetTargetDelay();
+				OutDelays[Phase].Current += Buffer.GetCurrentDelay();
+				++NumSamples[Phase];
+			}
+		}
+
+		for (int32 Phase = 0; Phase < 3; ++Phase)
+		{
+			OutDelays[Phase].Target /= FMath::Max(NumSamples[Phase], 1);
+			OutDelays[Phase].Current /= FMath::Max(NumSamples[Phase], 1);
+		}
+	}
+
+	/** The playout delay must grow while arrivals jitter, and shrink again once they are calm */
+	static void SelfTest(const TArray<FString>& Args)
+	{
+		const float JitterMs = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 40.f;
+
+		FPhaseDelays Delays[3];
+		RunPhases(JitterMs / 1000.f, Delays);
+
+		const bool bGrew = Delays[1].Target > Delays[0].Target * 1.5f && Delays[1].Current > Delays[0].Current * 1.5f;
+		const bool bShrank = Delays[2].Current < Delays[1].Current;
+		UE_LOG(LogITP, Display, TEXT("Snapshot buffer self test %s: +-%.0f ms jitter, target / current delay %.1f / %.1f ms calm, %.1f / %.1f ms jittered, %.1f / %.1f ms calm again"),
+			bGrew && bShrank ? TEXT("passed") : TEXT("FAILED"), JitterMs,
+			Delays[0].Target * 1000.f, Delays[0].Current * 1000.f,
+			Delays[1].Target * 1000.f, Delays[1].Current * 1000.f,
+			Delays[2].Target * 1000.f, Delays[2].Current * 1000.f);
+	}
+
+	static FAutoConsoleCommand SelfTestCommand(
+		TEXT("ITP.Interp.SelfTest"),
+		TEXT("ITP.Interp.SelfTest [JitterMs=40]: feeds an FITPSnapshotBuffer calm, jittered and calm snapshot arrivals and checks that the playout delay follows."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&SelfTest));
+}
@@ -0,0 +1,103 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ITPSnapshotBuffer.generated.h"
+
+/** How a character class presents remote copies of itself. Set per class in the character's defaults. */
+USTRUCT(BlueprintType)
+struct FITPInterpolationSettings
+{
+	GENERATED_BODY()
+
+	/** Off = engine CMC smoothing for simulated proxies */
+	UPROPERTY(EditDefaultsOnly, Category = Interpolation)
+	bool bEnabled = true;
+
+	/** Playout delay bounds in seconds */
+	UPROPERTY(EditDefaultsOnly, Category = Interpolation, meta = (ClampMin = "0"))
+	float MinDelay = 0.05f;
+
+	UPROPERTY(EditDefaultsOnly, Category = Interpolation, meta = (ClampMin = "0"))
+	float MaxDelay = 0.3f;
+
+	/** Target delay is one snapshot interval plus this many times the measured jitter */
+	UPROPERTY(EditDefaultsOnly, Category = Interpolation, meta = (ClampMin = "0"))
+	float JitterMultiplier = 3.f;
+
+	/** Weight of each new sample in the jitter and interval averages */
+	UPROPERTY(EditDefaultsOnly, Category = Interpolation, meta = (ClampMin = "0", ClampMax = "1"))
+	float JitterSmoothing = 0.1f;
+
+	/** Largest playback speed change used to move towards a new delay, as a fraction of real time */
+	UPROPERTY(EditDefaultsOnly, Category = Interpolation, meta = (ClampMin = "0", ClampMax = "1"))
+	float MaxTimeScale = 0.1f;
+
+	/** How far past the newest snapshot the glide model may extrapolate, in seconds */
+	UPROPERTY(EditDefaultsOnly, Category = Interpolation, meta = (ClampMin = "0"))
+	float MaxExtrapolation = 0.2f;
+};
+
+/** One received movement state of a remote character, stamped with the server time it was taken at */
+struct FITPSnapshot
+{
+	double ServerTime = 0.0;
+	FVector Location = FVector::ZeroVector;
+	FVector Velocity = FVector::ZeroVector;
+	bool bGliding = false;
+};
+
+/**
+ * Snapshot interpolation for simulated proxies.
+ * Snapshots are played back on a clock running a little behind the newest one. The lag of that clock follows
+ * the measured arrival jitter: Add keeps an average of the snapshot interval and of the change in transit time,
+ * and Sample speeds playback up or down by at most MaxTimeScale to reach the target delay without jumps.
+ * When the clock passes the newest snapshot the glide model extrapolates, for at most MaxExtrapolation.
+ */
+class ITP_API FITPSnapshotBuffer
+{
+public:
+	static constexpr int32 Capacity = 32;
+
+	void Reset();
+
+	/** LocalTime is the client clock at arrival. Snapshots older than the newest are dropped. */
+	void Add(const FITPSnapshot& Snapshot, double LocalTime, const FITPInterpolationSettings& Settings);
+
+	/** Advances the playout clock to LocalTime and returns the state to present. False until a snapshot arrived. */
+	bool Sample(double LocalTime, float DescendingRate, const FITPInterpolationSettings& Settings, FITPSnapshot& OutSnapshot);
+
+	bool IsEmpty() const { return Count == 0; }
+	double GetNewestTime() const { return Count > 0 ? At(Count - 1).ServerTime : 0.0; }
+	float GetJitter() const { return Jitter; }
+	float GetTargetDelay() const { return TargetDelay; }
+	float GetCurrentDelay() const { return CurrentDelay; }
+	/** Server time of the state last returned by Sample */
+	double GetPlayoutTime() const { return PlayoutTime; }
+	int32 GetNumExtrapolated() const { return NumExtrapolated; }
+
+	/** Moves a snapshot forward by Seconds: horizontal velocity is kept, a glide descends at DescendingRate */
+	static FITPSnapshot Extrapolate(const FITPSnapshot& From, float Seconds, float DescendingRate);
+
+private:
+	const FITPSnapshot& At(int32 Logical) const { return Snapshots[(Head - Count + Logical) & (Capacity - 1)]; }
+
+	FITPSnapshot Snapshots[Capacity];
+	int32 Head = 0;
+	int32 Count = 0;
+
+	/** Arrival of the newest snapshot, to estimate the current server time between arrivals */
+	double NewestArrival = 0.0;
+	double LastTransit = 0.0;
+	float Jitter = 0.f;
+	float Interval = 0.f;
+	float TargetDelay = 0.f;
+	float CurrentDelay = 0.f;
+
+	/** Server time being presented */
+	double PlayoutTime = 0.0;
+	double LastSampleTime = 0.0;
+	bool bPlaying = false;
+	int32 NumExtrapolated = 0;
+};
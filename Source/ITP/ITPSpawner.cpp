@@ -0,0 +1,80 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPSpawner.h"
+#include "ITPActorPoolSubsystem.h"
+#include "ITPSpawnerSubsystem.h"
+#include "Engine/World.h"
+
+AITPSpawner::AITPSpawner()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+	RootComponent->SetMobility(EComponentMobility::Static);
+}
+
+void AITPSpawner::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UITPSpawnerSubsystem* Spawners = GetWorld()->GetSubsystem<UITPSpawnerSubsystem>())
+	{
+		SweepId = Spawners->Register(this);
+	}
+}
+
+void AITPSpawner::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UITPSpawnerSubsystem* Spawners = GetWorld()->GetSubsystem<UITPSpawnerSubsystem>())
+	{
+		Spawners->Unregister(SweepId);
+	}
+
+	// The world tears down its own actors
+	if (EndPlayReason == EEndPlayReason::Destroyed || EndPlayReason == EEndPlayReason::RemovedFromWorld)
+	{
+		Deactivate();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AITPSpawner::Activate()
+{
+	if (!SpawnClass || Spawned.IsValid() || (bHasSpawned && !bRespawn))
+	{
+		return;
+	}
+
+	// Pooled, so actors a warp prewarmed for its destination are the ones used here
+	if (UITPActorPoolSubsystem* Pool = GetWorld()->GetSubsystem<UITPActorPoolSubsystem>())
+	{
+		Spawned = Pool->Acquire(SpawnClass, GetActorTransform());
+	}
+	else
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+		Spawned = GetWorld()->SpawnActor<AActor>(SpawnClass, GetActorTransform(), SpawnParams);
+	}
+	bHasSpawned = Spawned.IsValid();
+}
+
+void AITPSpawner::Deactivate()
+{
+	if (bDespawnWhenInactive && Spawned.IsValid())
+	{
+		if (UITPActorPoolSubsystem* Pool = GetWorld()->GetSubsystem<UITPActorPoolSubsystem>())
+		{
+			Pool->Release(Spawned.Get());
+		}
+		else
+		{
+			Spawned->Destroy();
+		}
+
+		// Despawned, not defeated: spawn again next time the window comes back
+		bHasSpawned = false;
+	}
+	Spawned.Reset();
+}
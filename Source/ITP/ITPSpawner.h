@@ -0,0 +1,44 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ITPSpawner.generated.h"
+
+/**
+ * Spawns SpawnClass while the camera's activation window (see UITPSpawnerSubsystem) covers it.
+ * Spawners have no tick, overlap volume or distance check of their own. Actors come from and go back to
+ * UITPActorPoolSubsystem, which warps prewarm for their destination.
+ */
+UCLASS()
+class AITPSpawner : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AITPSpawner();
+
+	UPROPERTY(EditAnywhere, Category = Spawner)
+	TSubclassOf<AActor> SpawnClass;
+
+	/** Return the spawned actor to the actor pool when the window leaves the spawner */
+	UPROPERTY(EditAnywhere, Category = Spawner)
+	bool bDespawnWhenInactive = true;
+
+	/** Spawn again on re-entering the window after the previous actor was destroyed (e.g. killed) */
+	UPROPERTY(EditAnywhere, Category = Spawner)
+	bool bRespawn = false;
+
+	void Activate();
+	void Deactivate();
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	TWeakObjectPtr<AActor> Spawned;
+	bool bHasSpawned = false;
+	int32 SweepId = INDEX_NONE;
+};
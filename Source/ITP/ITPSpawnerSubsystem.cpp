@@ -0,0 +1,207 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPSpawnerSubsystem.h"
+#include "ITP.h"
+#include "ITPMath2D.h"
+#include "ITPSpawner.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+
+DECLARE_CYCLE_STAT(TEXT("Spawner Sweep"), STAT_ITPSpawnerSweep, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spawner Changes"), STAT_ITPSpawnerChanges, STATGROUP_ITP);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Spawners Active"), STAT_ITPSpawnersActive, STATGROUP_ITP);
+
+static float GITPSpawnerActivationDistance = 2500.f;
+static FAutoConsoleVariableRef CVarITPSpawnerActivationDistance(
+	TEXT("ITP.Spawner.ActivationDistance"),
+	GITPSpawnerActivationDistance,
+	TEXT("Spawners within this distance of any player's view along the scroll axis are active."));
+
+void UITPSpawnerSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ITPSpawnerSweep);
+
+	// Spawned actors, coins included, replicate; a client activating its own spawners would duplicate them
+	if (GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (!PlayerController)
+		{
+			continue;
+		}
+
+		// The server's copy of a remote player's view, as used for relevancy
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+		const double Scroll = ViewLocation | ITP2D::ScrollAxis;
+		UpdateView(FindOrAddView(PlayerController), Scroll - GITPSpawnerActivationDistance, Scroll + GITPSpawnerActivationDistance);
+	}
+
+	// A player that left releases everything its window held
+	for (int32 Index = Views.Num() - 1; Index >= 0; --Index)
+	{
+		if (!Views[Index].PlayerController.IsValid())
+		{
+			UpdateView(Views[Index], TNumericLimits<double>::Lowest(), TNumericLimits<double>::Lowest());
+			Views.RemoveAtSwap(Index, 1, false);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_ITPSpawnersActive, NumActive);
+}
+
+UITPSpawnerSubsystem::FView& UITPSpawnerSubsystem::FindOrAddView(const APlayerController* PlayerController)
+{
+	for (FView& View : Views)
+	{
+		if (View.PlayerController == PlayerController)
+		{
+			return View;
+		}
+	}
+
+	// Added in id order, removed ones included, so ids match the other views' sweeps
+	FView& View = Views.AddDefaulted_GetRef();
+	View.PlayerController = PlayerController;
+	for (int32 Id = 0; Id < Positions.Num(); ++Id)
+	{
+		View.Sweep.Add(Positions[Id]);
+		if (Removed[Id])
+		{
+			View.Sweep.Remove(Id);
+		}
+	}
+	return View;
+}
+
+void UITPSpawnerSubsystem::UpdateView(FView& View, double Min, double Max)
+{
+	int32 NumChanges = 0;
+	View.Sweep.Update(Min, Max,
+		[this, &NumChanges](int32 Id)
+		{
+			if (NumViewsActive[Id]++ == 0)
+			{
+				++NumChanges;
+				++NumActive;
+				if (AITPSpawner* Spawner = Spawners[Id].Get())
+				{
+					Spawner->Activate();
+				}
+			}
+		},
+		[this, &NumChanges](int32 Id)
+		{
+			if (--NumViewsActive[Id] == 0)
+			{
+				++NumChanges;
+				--NumActive;
+				if (AITPSpawner* Spawner = Spawners[Id].Get())
+				{
+					Spawner->Deactivate();
+				}
+			}
+		});
+
+	INC_DWORD_STAT_BY(STAT_ITPSpawnerChanges, NumChanges);
+}
+
+TStatId UITPSpawnerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UITPSpawnerSubsystem, STATGROUP_ITP);
+}
+
+bool UITPSpawnerSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+int32 UITPSpawnerSubsystem::Register(AITPSpawner* Spawner)
+{
+	const double Position = Spawner->GetActorLocation() | ITP2D::ScrollAxis;
+	const int32 Id = Spawners.Add(Spawner);
+	Positions.Add(Position);
+	NumViewsActive.Add(0);
+	Removed.Add(false);
+	for (FView& View : Views)
+	{
+		View.Sweep.Add(Position);
+	}
+	return Id;
+}
+
+void UITPSpawnerSubsystem::Unregister(int32 SweepId)
+{
+	if (Spawners.IsValidIndex(SweepId) && !Removed[SweepId])
+	{
+		Removed[SweepId] = true;
+		Spawners[SweepId].Reset();
+		for (FView& View : Views)
+		{
+			View.Sweep.Remove(SweepId);
+		}
+	}
+}
+
+/**
+ * Scrolls a window across a level of synthetic spawners and checks the sweep against a brute-force scan.
+ * Reports the average update cost and changes per update; the cost should track changes, not Count.
+ */
+static FAutoConsoleCommand CmdITPSpawnerBenchmark(
+	TEXT("ITP.Spawner.Benchmark"),
+	TEXT("ITP.Spawner.Benchmark [Count=50000] [Updates=10000]: validates and times the spawner sweep line."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 50000;
+		const int32 Updates = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 10000;
+		const double LevelLength = Count * 40.0;
+		const double HalfWindow = GITPSpawnerActivationDistance;
+
+		FRandomStream Random(Count);
+		FITPSweepLine Sweep;
+		TArray<double> Positions;
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			Positions.Add(Random.FRandRange(0.0, LevelLength));
+			Sweep.Add(Positions.Last());
+		}
+
+		int64 NumChanges = 0;
+		const auto CountChange = [&NumChanges](int32) { ++NumChanges; };
+
+		// First update sorts; not part of the per-frame cost
+		Sweep.Update(-HalfWindow, HalfWindow, CountChange, CountChange);
+		NumChanges = 0;
+
+		int32 NumErrors = 0;
+		uint64 Cycles = 0;
+		for (int32 Step = 1; Step <= Updates; ++Step)
+		{
+			// Mostly smooth scrolling with occasional warps, as in play
+			const double Scroll = Step % 1000 == 0 ? Random.FRandRange(0.0, LevelLength) : LevelLength * Step / Updates;
+
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			Sweep.Update(Scroll - HalfWindow, Scroll + HalfWindow, CountChange, CountChange);
+			Cycles += FPlatformTime::Cycles64() - StartCycles;
+
+			if (Step % 997 == 0)
+			{
+				for (int32 Id = 0; Id < Count; ++Id)
+				{
+					NumErrors += Sweep.IsActive(Id) != (FMath::Abs(Positions[Id] - Scroll) <= HalfWindow);
+				}
+			}
+		}
+
+		UE_LOG(LogITP, Log, TEXT("Spawner sweep: %d spawners, %d updates, %.3f us/update, %.2f changes/update, %d mismatches"),
+			Count, Updates, FPlatformTime::ToMilliseconds64(Cycles) * 1000.0 / FMath::Max(Updates, 1), (double)NumChanges / FMath::Max(Updates, 1), NumErrors);
+	}));
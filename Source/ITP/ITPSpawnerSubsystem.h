@@ -0,0 +1,54 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ITPSweepLine.h"
+#include "ITPSpawnerSubsystem.generated.h"
+
+class AITPSpawner;
+class APlayerController;
+
+/**
+ * Activates spawners inside a window around each player's view along the scroll axis
+ * (ITP.Spawner.ActivationDistance) and deactivates them once no window covers them. Runs on the server or in
+ * standalone only; clients receive what the server spawned. Every view has its own FITPSweepLine and a spawner
+ * is active while at least one of them holds it, so the per-frame cost follows the number of spawners crossing
+ * window edges, not the number in the level, and players far apart do not activate the level between them.
+ */
+UCLASS()
+class ITP_API UITPSpawnerSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	int32 Register(AITPSpawner* Spawner);
+	void Unregister(int32 SweepId);
+
+	int32 GetNumActive() const { return NumActive; }
+
+private:
+	struct FView
+	{
+		TWeakObjectPtr<const APlayerController> PlayerController;
+		FITPSweepLine Sweep;
+	};
+
+	FView& FindOrAddView(const APlayerController* PlayerController);
+	void UpdateView(FView& View, double Min, double Max);
+
+	TArray<FView> Views;
+
+	/** Indexed by sweep id, which is the same in every view's sweep */
+	TArray<TWeakObjectPtr<AITPSpawner>> Spawners;
+	TArray<double> Positions;
+	TArray<int32> NumViewsActive;
+	TBitArray<> Removed;
+
+	int32 NumActive = 0;
+};
@@ -0,0 +1,94 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPSpriteCharacter.h"
+#include "ITPAnimationClockSubsystem.h"
+#include "ITPMath2D.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "PaperFlipbookComponent.h"
+
+AITPSpriteCharacter::AITPSpriteCharacter()
+{
+	Sprite = CreateDefaultSubobject<UPaperFlipbookComponent>(TEXT("Sprite"));
+	Sprite->SetupAttachment(GetCapsuleComponent());
+	Sprite->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	// Sprites lie in their local XZ plane; turn them so local X runs along the scroll axis
+	Sprite->SetUsingAbsoluteRotation(true);
+	Sprite->SetWorldRotation(FRotator(0.f, 90.f, 0.f));
+
+	// The animation clock drives the frames
+	Sprite->PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	// The skeletal mesh stays as an attachment point but is never drawn or animated
+	GetMesh()->SetVisibility(false);
+	GetMesh()->PrimaryComponentTick.bStartWithTickEnabled = false;
+	GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+}
+
+void AITPSpriteCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UITPAnimationClockSubsystem* Clock = GetWorld()->GetSubsystem<UITPAnimationClockSubsystem>())
+	{
+		Clock->Register(Sprite);
+	}
+	UpdateFlipbook();
+}
+
+void AITPSpriteCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UITPAnimationClockSubsystem* Clock = GetWorld()->GetSubsystem<UITPAnimationClockSubsystem>())
+	{
+		Clock->Unregister(Sprite);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AITPSpriteCharacter::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	UpdateFlipbook();
+}
+
+void AITPSpriteCharacter::UpdateFlipbook()
+{
+	UITPAnimationClockSubsystem* Clock = GetWorld()->GetSubsystem<UITPAnimationClockSubsystem>();
+	if (!Clock)
+	{
+		return;
+	}
+
+	const FVector2f Velocity = ITP2D::FromWorldDirection(GetVelocity());
+	const bool bFalling = GetCharacterMovement()->IsFalling();
+
+	UPaperFlipbook* Flipbook = IdleFlipbook;
+	float PlayRate = 1.f;
+	if (IsGliding())
+	{
+		Flipbook = GlideFlipbook;
+	}
+	else if (bFalling)
+	{
+		Flipbook = Velocity.Y > 0.f ? JumpFlipbook : FallFlipbook;
+	}
+	else if (FMath::Abs(Velocity.X) > UE_KINDA_SMALL_NUMBER)
+	{
+		Flipbook = RunFlipbook;
+
+		// Quantized so the rate isn't rewritten every frame
+		PlayRate = FMath::RoundToFloat(FMath::Abs(Velocity.X) / RunAnimationSpeed * 4.f) / 4.f;
+	}
+
+	Clock->Play(Sprite, Flipbook, !bFalling || IsGliding(), FMath::Max(PlayRate, 0.25f));
+
+	// Face the direction of travel; keep the last facing while standing still
+	if (!FMath::IsNearlyZero(Velocity.X))
+	{
+		Sprite->SetRelativeScale3D(FVector(Velocity.X < 0.f ? -1.f : 1.f, 1.f, 1.f));
+	}
+}
@@ -0,0 +1,53 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ITPCharacter.h"
+#include "ITPSpriteCharacter.generated.h"
+
+class UPaperFlipbook;
+class UPaperFlipbookComponent;
+
+/**
+ * AITPCharacter drawn with Paper2D flipbooks instead of the skeletal mesh.
+ * The flipbook is picked from the movement and glide state; frames are advanced by UITPAnimationClockSubsystem.
+ */
+UCLASS(config=Game)
+class AITPSpriteCharacter : public AITPCharacter
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Sprite, meta = (AllowPrivateAccess = "true"))
+	TObjectPtr<UPaperFlipbookComponent> Sprite;
+
+public:
+	AITPSpriteCharacter();
+
+	UPROPERTY(EditAnywhere, Category = Sprite)
+	TObjectPtr<UPaperFlipbook> IdleFlipbook;
+
+	UPROPERTY(EditAnywhere, Category = Sprite)
+	TObjectPtr<UPaperFlipbook> RunFlipbook;
+
+	UPROPERTY(EditAnywhere, Category = Sprite)
+	TObjectPtr<UPaperFlipbook> JumpFlipbook;
+
+	UPROPERTY(EditAnywhere, Category = Sprite)
+	TObjectPtr<UPaperFlipbook> FallFlipbook;
+
+	UPROPERTY(EditAnywhere, Category = Sprite)
+	TObjectPtr<UPaperFlipbook> GlideFlipbook;
+
+	/** Ground speed at which RunFlipbook plays at rate 1 */
+	UPROPERTY(EditAnywhere, Category = Sprite)
+	float RunAnimationSpeed = 500.f;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+
+private:
+	void UpdateFlipbook();
+};
@@ -0,0 +1,127 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPSweepLine.h"
+#include "Algo/BinarySearch.h"
+#include "Algo/Sort.h"
+
+int32 FITPSweepLine::Add(double Position)
+{
+	const int32 Id = PositionById.Add(Position);
+	Active.Add(false);
+	Removed.Add(false);
+	bDirty = true;
+	return Id;
+}
+
+void FITPSweepLine::Remove(int32 Id)
+{
+	if (Removed.IsValidIndex(Id) && !Removed[Id])
+	{
+		Removed[Id] = true;
+		bDirty = true;
+	}
+}
+
+void FITPSweepLine::Reset()
+{
+	Positions.Reset();
+	Ids.Reset();
+	Active.Reset();
+	PositionById.Reset();
+	Removed.Reset();
+	Begin = End = 0;
+	bDirty = false;
+}
+
+void FITPSweepLine::Update(double Min, double Max, TFunctionRef<void(int32)> OnEnter, TFunctionRef<void(int32)> OnExit)
+{
+	if (bDirty)
+	{
+		Rebuild(Min, Max, OnEnter, OnExit);
+		return;
+	}
+
+	const auto Enter = [&](int32 Index)
+	{
+		if (!Active[Ids[Index]])
+		{
+			Active[Ids[Index]] = true;
+			OnEnter(Ids[Index]);
+		}
+	};
+	const auto Exit = [&](int32 Index)
+	{
+		if (Active[Ids[Index]])
+		{
+			Active[Ids[Index]] = false;
+			OnExit(Ids[Index]);
+		}
+	};
+
+	// Right edge first, so the left edge below can rely on End being final
+	while (End < Positions.Num() && Positions[End] <= Max)
+	{
+		if (Positions[End] >= Min)
+		{
+			Enter(End);
+		}
+		++End;
+	}
+	while (End > 0 && Positions[End - 1] > Max)
+	{
+		Exit(--End);
+	}
+
+	while (Begin < Positions.Num() && Positions[Begin] < Min)
+	{
+		Exit(Begin++);
+	}
+	while (Begin > 0 && Positions[Begin - 1] >= Min)
+	{
+		if (--Begin < End)
+		{
+			Enter(Begin);
+		}
+	}
+}
+
+void FITPSweepLine::Rebuild(double Min, double Max, TFunctionRef<void(int32)> OnEnter, TFunctionRef<void(int32)> OnExit)
+{
+	bDirty = false;
+
+	Ids.Reset();
+	for (int32 Id = 0; Id < PositionById.Num(); ++Id)
+	{
+		if (!Removed[Id])
+		{
+			Ids.Add(Id);
+		}
+		else if (Active[Id])
+		{
+			Active[Id] = false;
+			OnExit(Id);
+		}
+	}
+	Algo::SortBy(Ids, [this](int32 Id) { return PositionById[Id]; });
+
+	Positions.SetNumUninitialized(Ids.Num());
+	for (int32 Index = 0; Index < Ids.Num(); ++Index)
+	{
+		Positions[Index] = PositionById[Ids[Index]];
+	}
+
+	Begin = Algo::LowerBound(Positions, Min);
+	End = FMath::Max(Algo::UpperBound(Positions, Max), Begin);
+
+	// Only here does the whole set get visited, to carry over which points were already active
+	for (int32 Index = 0; Index < Ids.Num(); ++Index)
+	{
+		const bool bInside = Index >= Begin && Index < End;
+		const int32 Id = Ids[Index];
+		if (bInside != Active[Id])
+		{
+			Active[Id] = bInside;
+			bInside ? OnEnter(Id) : OnExit(Id);
+		}
+	}
+}
@@ -0,0 +1,44 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Points on the scroll axis with an activation window [Min, Max] that follows the camera.
+ * Points are kept sorted by position; the window edges are two indices into that order that only step over
+ * the points they pass, so an update costs O(points entering or leaving) rather than O(points).
+ * Adding or removing points re-sorts once on the next update.
+ */
+class ITP_API FITPSweepLine
+{
+public:
+	/** Returns an id for OnEnter / OnExit; ids are stable until Reset */
+	int32 Add(double Position);
+	void Remove(int32 Id);
+	void Reset();
+
+	/** Moves the window, calling OnEnter / OnExit with the id of every point whose state changed */
+	void Update(double Min, double Max, TFunctionRef<void(int32)> OnEnter, TFunctionRef<void(int32)> OnExit);
+
+	bool IsActive(int32 Id) const { return Active.IsValidIndex(Id) && Active[Id]; }
+	int32 Num() const { return Positions.Num(); }
+	int32 NumActive() const { return FMath::Max(End - Begin, 0); }
+
+private:
+	void Rebuild(double Min, double Max, TFunctionRef<void(int32)> OnEnter, TFunctionRef<void(int32)> OnExit);
+
+	/** Sorted; Ids[i] belongs to Positions[i] */
+	TArray<double> Positions;
+	TArray<int32> Ids;
+
+	/** Indexed by id */
+	TBitArray<> Active;
+	TArray<double> PositionById;
+	TBitArray<> Removed;
+
+	/** Window edges: points [Begin, End) are inside */
+	int32 Begin = 0;
+	int32 End = 0;
+	bool bDirty = false;
+};
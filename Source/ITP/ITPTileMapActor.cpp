@@ -0,0 +1,263 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPTileMapActor.h"
+#include "ITPCollision.h"
+#include "ITPCollisionSubsystem.h"
+#include "ITPGameData.h"
+#include "ITPLevelStateSubsystem.h"
+#include "ITPOriginSubsystem.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/GameInstance.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+
+AITPTileMapActor::AITPTileMapActor()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+	RootComponent->SetMobility(EComponentMobility::Static);
+}
+
+void AITPTileMapActor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UITPOriginSubsystem* OriginSubsystem = GetWorld()->GetSubsystem<UITPOriginSubsystem>();
+	RebaseTiles(OriginSubsystem ? OriginSubsystem->GetOrigin() : ITP2D::FPlaneOrigin());
+	if (OriginSubsystem)
+	{
+		OriginShiftedHandle = OriginSubsystem->OnOriginShifted.AddUObject(this, &AITPTileMapActor::HandleOriginShifted);
+	}
+}
+
+void AITPTileMapActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UITPOriginSubsystem* OriginSubsystem = GetWorld()->GetSubsystem<UITPOriginSubsystem>())
+	{
+		OriginSubsystem->OnOriginShifted.Remove(OriginShiftedHandle);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AITPTileMapActor::LoadLevel(const UITPChunkedLevel& Level)
+{
+	ClearChunks();
+	TileSize = Level.TileSize;
+	SizeInTiles = Level.SizeInTiles;
+
+	FITPLevelChunk Chunk;
+	for (int32 Index = 0; Index < Level.Chunks.Num(); ++Index)
+	{
+		if (Level.LoadChunk(Index, Chunk))
+		{
+			RebuildChunk(Chunk);
+		}
+	}
+
+	if (UITPLevelStateSubsystem* LevelState = GetWorld()->GetSubsystem<UITPLevelStateSubsystem>())
+	{
+		LevelState->SetTileMap(this);
+	}
+}
+
+void AITPTileMapActor::RebuildChunk(const FITPLevelChunk& Chunk)
+{
+	TArray<uint16>& Layer = SolidLayers.FindOrAdd(Chunk.Coord);
+	Layer.Reset();
+	if (!Chunk.Tiles.IsEmpty())
+	{
+		Layer.Append(Chunk.Tiles.GetData(), FITPLevelChunk::TilesPerLayer);
+	}
+
+	BuildChunkInstances(Chunk.Coord);
+}
+
+void AITPTileMapActor::BuildChunkInstances(const FIntPoint& Coord)
+{
+	const TArray<uint16>& Layer = SolidLayers.FindChecked(Coord);
+
+	TObjectPtr<UInstancedStaticMeshComponent>& Component = ChunkComponents.FindOrAdd(Coord);
+	if (!Component)
+	{
+		Component = NewObject<UInstancedStaticMeshComponent>(this);
+		Component->SetupAttachment(RootComponent);
+		Component->SetMobility(EComponentMobility::Stationary);
+		Component->SetStaticMesh(TileMesh);
+		Component->SetCollisionProfileName(ITPCollision::GroundProfile);
+		Component->RegisterComponent();
+	}
+
+	const UITPGameData* GameData = GetGameData();
+	TArray<FTransform> Instances;
+	const FVector Scale(TileSize / 100.f);
+	for (int32 LocalY = 0; LocalY < FITPLevelChunk::ChunkSize; ++LocalY)
+	{
+		for (int32 LocalX = 0; LocalX < FITPLevelChunk::ChunkSize; ++LocalX)
+		{
+			const uint16 TileId = Layer.IsEmpty() ? 0 : Layer[FITPLevelChunk::GetTileIndex(0, LocalX, LocalY)];
+			if (IsSolidTile(TileId, GameData))
+			{
+				const FIntPoint Tile(Coord.X * FITPLevelChunk::ChunkSize + LocalX, Coord.Y * FITPLevelChunk::ChunkSize + LocalY);
+				Instances.Emplace(FQuat::Identity, ITP2D::ToWorld(ITP2D::TileCenter(Tile, TileSize)), Scale);
+			}
+		}
+	}
+
+	// Collision and render data are rebuilt once for the whole batch
+	Component->ClearInstances();
+	Component->AddInstances(Instances, false, false);
+
+	// Cached ground probes over this chunk may now be wrong
+	if (UITPCollisionSubsystem* Collision = GetWorld()->GetSubsystem<UITPCollisionSubsystem>())
+	{
+		const FVector2f ChunkMin = ITP2D::TileBounds(Coord * FITPLevelChunk::ChunkSize, TileSize).Min;
+		const FVector2f ChunkMax = ChunkMin + FVector2f(TileSize * FITPLevelChunk::ChunkSize);
+		FBox ChunkBounds(ForceInit);
+		ChunkBounds += PlaneToWorld(ChunkMin);
+		ChunkBounds += PlaneToWorld(ChunkMax);
+
+		// Depth is irrelevant for plane gameplay, so cover it entirely
+		Collision->InvalidateProbes(ChunkBounds.ExpandBy(FVector(UE_OLD_HALF_WORLD_MAX, TileSize, TileSize)));
+	}
+}
+
+void AITPTileMapActor::RemoveChunk(const FIntPoint& Coord)
+{
+	SolidLayers.Remove(Coord);
+
+	TObjectPtr<UInstancedStaticMeshComponent> Component;
+	if (ChunkComponents.RemoveAndCopyValue(Coord, Component) && Component)
+	{
+		Component->DestroyComponent();
+	}
+}
+
+void AITPTileMapActor::ClearChunks()
+{
+	for (const TPair<FIntPoint, TObjectPtr<UInstancedStaticMeshComponent>>& Pair : ChunkComponents)
+	{
+		if (Pair.Value)
+		{
+			Pair.Value->DestroyComponent();
+		}
+	}
+	ChunkComponents.Reset();
+	SolidLayers.Reset();
+}
+
+uint16 AITPTileMapActor::GetTile(const FIntPoint& Tile) const
+{
+	const FIntPoint Coord = FITPLevelChunk::TileToChunk(Tile);
+	const TArray<uint16>* Layer = SolidLayers.Find(Coord);
+	if (!Layer || Layer->IsEmpty())
+	{
+		return 0;
+	}
+
+	const FIntPoint Local = Tile - Coord * FITPLevelChunk::ChunkSize;
+	return (*Layer)[FITPLevelChunk::GetTileIndex(0, Local.X, Local.Y)];
+}
+
+int32 AITPTileMapActor::ClearTiles(TConstArrayView<FIntPoint> Tiles)
+{
+	TSet<FIntPoint, DefaultKeyFuncs<FIntPoint>, TInlineSetAllocator<8>> Touched;
+	int32 NumChanged = 0;
+	for (const FIntPoint& Tile : Tiles)
+	{
+		const FIntPoint Coord = FITPLevelChunk::TileToChunk(Tile);
+		TArray<uint16>* Layer = SolidLayers.Find(Coord);
+		if (!Layer || Layer->IsEmpty())
+		{
+			continue;
+		}
+
+		const FIntPoint Local = Tile - Coord * FITPLevelChunk::ChunkSize;
+		uint16& TileId = (*Layer)[FITPLevelChunk::GetTileIndex(0, Local.X, Local.Y)];
+		if (TileId != 0)
+		{
+			TileId = 0;
+			Touched.Add(Coord);
+			++NumChanged;
+		}
+	}
+
+	// Each chunk's instances and collision are rebuilt once however many of its tiles changed
+	for (const FIntPoint& Coord : Touched)
+	{
+		BuildChunkInstances(Coord);
+	}
+	return NumChanged;
+}
+
+FIntPoint AITPTileMapActor::WorldToTile(const FVector& WorldLocation) const
+{
+	return PlaneToTile(ITP2D::FromWorld(WorldLocation, PlaneOrigin));
+}
+
+FIntPoint AITPTileMapActor::PlaneToTile(const FVector2f& PlaneLocation) const
+{
+	return ITP2D::LocationToTile(PlaneLocation - OriginRemainder, TileSize) + FIntPoint(OriginTile, 0);
+}
+
+FVector2f AITPTileMapActor::TileToPlane(const FIntPoint& Tile) const
+{
+	return ITP2D::TileCenter(Tile - FIntPoint(OriginTile, 0), TileSize) + OriginRemainder;
+}
+
+void AITPTileMapActor::RebaseTiles(const ITP2D::FPlaneOrigin& Origin)
+{
+	// Only this step is done in double: the scroll distance from tile column 0 to the origin
+	const FVector Corner = GetActorLocation();
+	const double OriginScroll = Origin.Scroll - Corner.Y;
+	OriginTile = FMath::FloorToInt32(OriginScroll / TileSize);
+	OriginRemainder = FVector2f((float)((double)OriginTile * TileSize - OriginScroll), (float)Corner.Z);
+	PlaneOrigin = Origin;
+}
+
+void AITPTileMapActor::HandleOriginShifted(const FITPOriginShift& Shift)
+{
+	RebaseTiles(Shift.NewOrigin);
+}
+
+FVector AITPTileMapActor::TileToWorld(const FIntPoint& Tile) const
+{
+	return ITP2D::ToWorld(TileToPlane(Tile), GetActorLocation().X, PlaneOrigin);
+}
+
+FVector AITPTileMapActor::PlaneToWorld(const FVector2f& LevelLocation) const
+{
+	return GetActorTransform().TransformPosition(ITP2D::ToWorld(LevelLocation));
+}
+
+bool AITPTileMapActor::IsSolidTile(uint16 TileId) const
+{
+	return IsSolidTile(TileId, GetGameData());
+}
+
+bool AITPTileMapActor::IsSolidTile(uint16 TileId, const UITPGameData* GameData)
+{
+	if (TileId == 0)
+	{
+		return false;
+	}
+	return GameData ? GameData->GetTileById(TileId).bSolid : true;
+}
+
+const UITPGameData* AITPTileMapActor::GetGameData() const
+{
+	const UITPGameDataSubsystem* GameDataSubsystem = GetGameInstance() ? GetGameInstance()->GetSubsystem<UITPGameDataSubsystem>() : nullptr;
+	return GameDataSubsystem ? GameDataSubsystem->GetData() : nullptr;
+}
+
+bool AITPTileMapActor::IsBreakableTile(uint16 TileId) const
+{
+	if (TileId == 0)
+	{
+		return false;
+	}
+
+	const UITPGameData* GameData = GetGameData();
+	return GameData && GameData->GetTileById(TileId).bBreakable;
+}
@@ -0,0 +1,102 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ITPChunkedLevel.h"
+#include "ITPTileMapActor.generated.h"
+
+struct FITPOriginShift;
+class UInstancedStaticMeshComponent;
+class UITPGameData;
+class UStaticMesh;
+
+/**
+ * Renders and collides an ITP tile level, one instanced mesh component per chunk.
+ * Tiles are laid out in the actor's local space: tile (X, Y) spans [X, X+1) * TileSize along the scroll axis
+ * and [Y, Y+1) * TileSize up. Only layer 0 is treated as solid.
+ * Tile lookups run in the float plane relative to UITPOriginSubsystem's origin: the actor keeps the tile at the
+ * origin as an integer plus a small float remainder and rebases both on every origin shift, so lookups stay exact
+ * however far along the level the player is. The actor is assumed unrotated and unscaled.
+ */
+UCLASS()
+class ITP_API AITPTileMapActor : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AITPTileMapActor();
+
+	/** Mesh for one solid tile, sized 100 cm and scaled to TileSize */
+	UPROPERTY(EditAnywhere, Category = Tiles)
+	TObjectPtr<UStaticMesh> TileMesh;
+
+	UPROPERTY(EditAnywhere, Category = Tiles)
+	float TileSize = ITP2D::DefaultTileSize;
+
+	/** Builds every chunk of Level */
+	void LoadLevel(const UITPChunkedLevel& Level);
+
+	/** Replaces the instances of one chunk */
+	void RebuildChunk(const FITPLevelChunk& Chunk);
+
+	void RemoveChunk(const FIntPoint& Coord);
+	void ClearChunks();
+
+	FIntPoint WorldToTile(const FVector& WorldLocation) const;
+	FVector TileToWorld(const FIntPoint& Tile) const;
+
+	/** Tile under a plane location relative to the current ITP origin, and back to the tile's center */
+	FIntPoint PlaneToTile(const FVector2f& PlaneLocation) const;
+	FVector2f TileToPlane(const FIntPoint& Tile) const;
+
+	FVector PlaneToWorld(const FVector2f& LevelLocation) const;
+
+	/** Whether a tile id blocks movement, via the cooked tile table when available */
+	bool IsSolidTile(uint16 TileId) const;
+
+	/** Same, for loops over many tiles that resolve GetGameData once */
+	static bool IsSolidTile(uint16 TileId, const UITPGameData* GameData);
+
+	/** Cooked game data of the owning game instance, null if none is configured */
+	const UITPGameData* GetGameData() const;
+
+	/** Whether a tile id can be knocked out at runtime */
+	bool IsBreakableTile(uint16 TileId) const;
+
+	/** Layer 0 tile id at Tile, 0 if its chunk is not built */
+	uint16 GetTile(const FIntPoint& Tile) const;
+
+	/** Empties layer 0 at each tile, rebuilding every touched chunk once. Returns the number of tiles changed. */
+	int32 ClearTiles(TConstArrayView<FIntPoint> Tiles);
+
+	/** Size of the level passed to LoadLevel, zero otherwise */
+	FIntPoint GetSizeInTiles() const { return SizeInTiles; }
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	void BuildChunkInstances(const FIntPoint& Coord);
+
+	/** Recomputes OriginTile and OriginRemainder for Origin, in double precision */
+	void RebaseTiles(const ITP2D::FPlaneOrigin& Origin);
+	void HandleOriginShifted(const FITPOriginShift& Shift);
+
+	UPROPERTY(Transient)
+	TMap<FIntPoint, TObjectPtr<UInstancedStaticMeshComponent>> ChunkComponents;
+
+	/** Layer 0 of every built chunk, kept so single tiles can change without the source level */
+	TMap<FIntPoint, TArray<uint16>> SolidLayers;
+
+	FIntPoint SizeInTiles = FIntPoint::ZeroValue;
+
+	/** Current plane origin, the scroll column of the tile it lies in, and that tile's corner in the plane */
+	ITP2D::FPlaneOrigin PlaneOrigin;
+	int32 OriginTile = 0;
+	FVector2f OriginRemainder = FVector2f::ZeroVector;
+
+	FDelegateHandle OriginShiftedHandle;
+};
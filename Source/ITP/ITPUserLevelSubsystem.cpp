@@ -0,0 +1,324 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPUserLevelSubsystem.h"
+#include "ITP.h"
+#include "ITPChunkedLevel.h"
+#include "ITPGameData.h"
+#include "ITPLevelFile.h"
+#include "Algo/Sort.h"
+#include "Engine/GameInstance.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Hash/CityHash.h"
+#include "Misc/Compression.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DECLARE_CYCLE_STAT(TEXT("User Level Validate"), STAT_ITPUserLevelValidate, STATGROUP_ITP);
+DECLARE_CYCLE_STAT(TEXT("User Level Load Cached"), STAT_ITPUserLevelLoadCached, STATGROUP_ITP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("User Level Cache Hits"), STAT_ITPUserLevelCacheHits, STATGROUP_ITP);
+
+namespace ITPUserLevel
+{
+	const TCHAR* Extension = TEXT("itpl");
+
+	/** Generous upper bound for one serialized FITPSpawnEntry, archetype name included */
+	constexpr int32 MaxSpawnEntryBytes = 256;
+
+	/** Memory reader that also caps string and array sizes read from untrusted data */
+	class FBoundedReader : public FMemoryReader
+	{
+	public:
+		FBoundedReader(const TArray<uint8>& InBytes)
+			: FMemoryReader(InBytes)
+		{
+			ArMaxSerializeSize = InBytes.Num();
+		}
+	};
+
+	static int32 GetSerializedTilesSize(int32 NumLayers)
+	{
+		return sizeof(FIntPoint) + sizeof(int32) + NumLayers * FITPLevelChunk::TilesPerLayer * sizeof(uint16) + sizeof(int32);
+	}
+
+	static bool IsHeaderWithinBudget(const ITPLevelFile::FHeader& Header, const FITPUserLevelBudget& Budget, int64 FileSize)
+	{
+		return Header.SizeInTiles.X > 0 && Header.SizeInTiles.Y > 0
+			&& Header.SizeInTiles.X <= Budget.MaxSizeInTiles.X && Header.SizeInTiles.Y <= Budget.MaxSizeInTiles.Y
+			&& Header.NumLayers > 0 && Header.NumLayers <= Budget.MaxLayers
+			&& Header.NumChunks >= 0 && Header.NumChunks <= Budget.MaxChunks
+			&& FMath::IsFinite(Header.TileSize) && Header.TileSize > 0.f
+			&& Header.ChunkTableOffset >= ITPLevelFile::FHeader::Size
+			&& Header.ChunkTableOffset + (int64)Header.NumChunks * ITPLevelFile::FChunkEntry::Size <= FileSize;
+	}
+
+	static void SortChunks(TArray<FITPCookedChunk>& Chunks)
+	{
+		Algo::Sort(Chunks, [](const FITPCookedChunk& A, const FITPCookedChunk& B)
+		{
+			return A.Coord.Y != B.Coord.Y ? A.Coord.Y < B.Coord.Y : A.Coord.X < B.Coord.X;
+		});
+	}
+}
+
+void UITPUserLevelSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	MountDirectory(FPaths::ProjectSavedDir() / TEXT("UserLevels"));
+}
+
+void UITPUserLevelSubsystem::MountDirectory(const FString& Directory)
+{
+	MountedDirectories.AddUnique(FPaths::ConvertRelativePathToFull(Directory));
+}
+
+TArray<FString> UITPUserLevelSubsystem::FindUserLevels() const
+{
+	TArray<FString> Result;
+	for (const FString& Directory : MountedDirectories)
+	{
+		TArray<FString> Found;
+		IFileManager::Get().FindFiles(Found, *(Directory / TEXT("*.") + ITPUserLevel::Extension), true, false);
+		for (const FString& File : Found)
+		{
+			Result.Add(Directory / File);
+		}
+	}
+	return Result;
+}
+
+UITPChunkedLevel* UITPUserLevelSubsystem::LoadUserLevel(const FString& Filename, EITPUserLevelError& OutError)
+{
+	UITPChunkedLevel* Level = NewObject<UITPChunkedLevel>(this, NAME_None, RF_Transient);
+
+	const FString CacheFilename = GetCacheFilename(Filename);
+	if (!CacheFilename.IsEmpty() && IFileManager::Get().FileExists(*CacheFilename))
+	{
+		if (LoadCached(CacheFilename, *Level))
+		{
+			INC_DWORD_STAT(STAT_ITPUserLevelCacheHits);
+			OutError = EITPUserLevelError::None;
+			return Level;
+		}
+		IFileManager::Get().Delete(*CacheFilename);
+		Level->Chunks.Reset();
+	}
+
+	OutError = Validate(Filename, Level);
+	if (OutError != EITPUserLevelError::None)
+	{
+		UE_LOG(LogITP, Warning, TEXT("Rejected user level '%s': %s"), *Filename, *UEnum::GetValueAsString(OutError));
+		Level->MarkAsGarbage();
+		return nullptr;
+	}
+
+	// The cached copy has no dead space and is only ever written from validated data
+	if (!CacheFilename.IsEmpty())
+	{
+		ITPLevelFile::FHeader Header;
+		Header.SizeInTiles = Level->SizeInTiles;
+		Header.TileSize = Level->TileSize;
+		Header.NumLayers = Level->LayerNames.Num();
+		ITPLevelFile::WriteFull(CacheFilename, Header, Level->Chunks);
+	}
+	return Level;
+}
+
+EITPUserLevelError UITPUserLevelSubsystem::ValidateFile(const FString& Filename) const
+{
+	return Validate(Filename, nullptr);
+}
+
+FString UITPUserLevelSubsystem::GetCacheFilename(const FString& Filename) const
+{
+	const FFileStatData Stat = IFileManager::Get().GetStatData(*Filename);
+	if (!Stat.bIsValid)
+	{
+		return FString();
+	}
+
+	// Anything that could change the validation outcome goes into the key
+	TArray<uint8> KeyBytes;
+	FMemoryWriter Writer(KeyBytes);
+	FString FullPath = FPaths::ConvertRelativePathToFull(Filename).ToLower();
+	int64 FileSize = Stat.FileSize;
+	int64 Timestamp = Stat.ModificationTime.GetTicks();
+	FITPUserLevelBudget KeyBudget = Budget;
+	uint32 FormatVersion = ITPLevelFile::Version;
+	Writer << FullPath << FileSize << Timestamp << FormatVersion;
+	Writer << KeyBudget.MaxFileBytes << KeyBudget.MaxSizeInTiles << KeyBudget.MaxLayers << KeyBudget.MaxChunks;
+	Writer << KeyBudget.MaxCompressedChunkBytes << KeyBudget.MaxSpawnsPerChunk << KeyBudget.MaxEnemies << KeyBudget.MaxSpawns;
+
+	const uint64 Key = CityHash64(reinterpret_cast<const char*>(KeyBytes.GetData()), KeyBytes.Num());
+	return FPaths::ProjectSavedDir() / TEXT("ITP/LevelCache") / FString::Printf(TEXT("%016llx.%s"), Key, ITPUserLevel::Extension);
+}
+
+EITPUserLevelError UITPUserLevelSubsystem::Validate(const FString& Filename, UITPChunkedLevel* OutLevel) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ITPUserLevelValidate);
+
+	TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Filename));
+	if (!File)
+	{
+		return EITPUserLevelError::NotFound;
+	}
+
+	const int64 FileSize = File->Size();
+	if (FileSize > Budget.MaxFileBytes)
+	{
+		return EITPUserLevelError::TooLarge;
+	}
+
+	// Header: fixed size, so reading it allocates nothing the file controls
+	ITPLevelFile::FHeader Header;
+	if (FileSize < ITPLevelFile::FHeader::Size || !ITPLevelFile::ReadHeader(*File, Header))
+	{
+		return EITPUserLevelError::BadHeader;
+	}
+	if (!ITPUserLevel::IsHeaderWithinBudget(Header, Budget, FileSize))
+	{
+		return EITPUserLevelError::OverBudget;
+	}
+
+	// Table: size is now bounded by MaxChunks and known to lie inside the file
+	TArray<ITPLevelFile::FChunkEntry> Table;
+	if (!ITPLevelFile::ReadTable(*File, Header, Table))
+	{
+		return EITPUserLevelError::CorruptTable;
+	}
+
+	const FIntPoint MaxCoord = (Header.SizeInTiles - 1) / FITPLevelChunk::ChunkSize;
+	const int32 TilesSize = ITPUserLevel::GetSerializedTilesSize(Header.NumLayers);
+	const int32 MaxUncompressed = TilesSize + Budget.MaxSpawnsPerChunk * ITPUserLevel::MaxSpawnEntryBytes;
+
+	TSet<FIntPoint> SeenCoords;
+	SeenCoords.Reserve(Table.Num());
+	for (const ITPLevelFile::FChunkEntry& Entry : Table)
+	{
+		bool bDuplicate = false;
+		SeenCoords.Add(Entry.Coord, &bDuplicate);
+		if (bDuplicate || Entry.Coord.X < 0 || Entry.Coord.Y < 0 || Entry.Coord.X > MaxCoord.X || Entry.Coord.Y > MaxCoord.Y
+			|| Entry.Offset < ITPLevelFile::FHeader::Size || Entry.CompressedSize <= 0 || Entry.Offset + Entry.CompressedSize > FileSize)
+		{
+			return EITPUserLevelError::CorruptTable;
+		}
+		if (Entry.CompressedSize > Budget.MaxCompressedChunkBytes || Entry.UncompressedSize < TilesSize || Entry.UncompressedSize > MaxUncompressed)
+		{
+			return EITPUserLevelError::OverBudget;
+		}
+	}
+
+	const UITPGameDataSubsystem* GameDataSubsystem = GetGameInstance()->GetSubsystem<UITPGameDataSubsystem>();
+	const UITPGameData* GameData = GameDataSubsystem ? GameDataSubsystem->GetData() : nullptr;
+	const FBox2f LevelBounds(FVector2f::ZeroVector, FVector2f(Header.SizeInTiles) * Header.TileSize);
+
+	// Chunks, one at a time through buffers bounded by the checks above
+	FITPCookedChunk Cooked;
+	TArray<uint8> Uncompressed;
+	FITPLevelChunk Chunk;
+	int32 NumEnemies = 0;
+	int32 NumSpawns = 0;
+	for (const ITPLevelFile::FChunkEntry& Entry : Table)
+	{
+		Uncompressed.SetNumUninitialized(Entry.UncompressedSize, false);
+		if (!ITPLevelFile::ReadChunk(*File, Entry, Cooked)
+			|| !FCompression::UncompressMemory(NAME_LZ4, Uncompressed.GetData(), Uncompressed.Num(), Cooked.CompressedData.GetData(), Cooked.CompressedData.Num()))
+		{
+			return EITPUserLevelError::CorruptChunk;
+		}
+
+		// Check the array counts in place before FITPLevelChunk's serializer allocates from them
+		ITPUserLevel::FBoundedReader Reader(Uncompressed);
+		FIntPoint Coord;
+		int32 NumTiles = 0;
+		Reader << Coord << NumTiles;
+		if (Coord != Entry.Coord || NumTiles != Header.NumLayers * FITPLevelChunk::TilesPerLayer)
+		{
+			return EITPUserLevelError::CorruptChunk;
+		}
+		Reader.Seek(TilesSize - sizeof(int32));
+		int32 NumChunkSpawns = 0;
+		Reader << NumChunkSpawns;
+		if (Reader.IsError() || NumChunkSpawns < 0)
+		{
+			return EITPUserLevelError::CorruptChunk;
+		}
+		NumSpawns += NumChunkSpawns;
+		if (NumChunkSpawns > Budget.MaxSpawnsPerChunk || NumSpawns > Budget.MaxSpawns)
+		{
+			return EITPUserLevelError::OverBudget;
+		}
+
+		Reader.Seek(0);
+		Reader << Chunk;
+		if (Reader.IsError() || Reader.Tell() != Uncompressed.Num())
+		{
+			return EITPUserLevelError::CorruptChunk;
+		}
+
+		if (GameData && Chunk.Tiles.ContainsByPredicate([GameData](uint16 TileId) { return !GameData->IsKnownTileId(TileId); }))
+		{
+			return EITPUserLevelError::UnknownTile;
+		}
+
+		for (const FITPSpawnEntry& Spawn : Chunk.Spawns)
+		{
+			if ((uint8)Spawn.Type > (uint8)EITPSpawnType::Other || !LevelBounds.IsInside(Spawn.Location)
+				|| FITPLevelChunk::TileToChunk(ITP2D::LocationToTile(Spawn.Location, Header.TileSize)) != Chunk.Coord)
+			{
+				return EITPUserLevelError::BadSpawn;
+			}
+			if (Spawn.Type == EITPSpawnType::Enemy && ++NumEnemies > Budget.MaxEnemies)
+			{
+				return EITPUserLevelError::OverBudget;
+			}
+		}
+
+		if (OutLevel)
+		{
+			OutLevel->Chunks.Add(MoveTemp(Cooked));
+			Cooked = FITPCookedChunk();
+		}
+	}
+
+	if (OutLevel)
+	{
+		OutLevel->SizeInTiles = Header.SizeInTiles;
+		OutLevel->TileSize = Header.TileSize;
+		OutLevel->LayerNames.SetNum(Header.NumLayers);
+		ITPUserLevel::SortChunks(OutLevel->Chunks);
+	}
+	return EITPUserLevelError::None;
+}
+
+bool UITPUserLevelSubsystem::LoadCached(const FString& CacheFilename, UITPChunkedLevel& OutLevel) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ITPUserLevelLoadCached);
+
+	TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*CacheFilename));
+	ITPLevelFile::FHeader Header;
+	TArray<ITPLevelFile::FChunkEntry> Table;
+	if (!File || !ITPLevelFile::ReadHeader(*File, Header) || !ITPUserLevel::IsHeaderWithinBudget(Header, Budget, File->Size())
+		|| !ITPLevelFile::ReadTable(*File, Header, Table))
+	{
+		return false;
+	}
+
+	// Chunks were validated before the cache was written, so they are taken as-is without decompressing
+	OutLevel.Chunks.SetNum(Table.Num());
+	for (int32 Index = 0; Index < Table.Num(); ++Index)
+	{
+		if (!ITPLevelFile::ReadChunk(*File, Table[Index], OutLevel.Chunks[Index]))
+		{
+			return false;
+		}
+	}
+
+	OutLevel.SizeInTiles = Header.SizeInTiles;
+	OutLevel.TileSize = Header.TileSize;
+	OutLevel.LayerNames.SetNum(Header.NumLayers);
+	ITPUserLevel::SortChunks(OutLevel.Chunks);
+	return true;
+}
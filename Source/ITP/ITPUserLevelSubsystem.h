@@ -0,0 +1,100 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "ITPUserLevelSubsystem.generated.h"
+
+class UITPChunkedLevel;
+
+/** Limits a user level must stay within to be loaded at all */
+USTRUCT()
+struct FITPUserLevelBudget
+{
+	GENERATED_BODY()
+
+	UPROPERTY(config)
+	int64 MaxFileBytes = 16 * 1024 * 1024;
+
+	UPROPERTY(config)
+	FIntPoint MaxSizeInTiles = FIntPoint(8192, 512);
+
+	UPROPERTY(config)
+	int32 MaxLayers = 4;
+
+	UPROPERTY(config)
+	int32 MaxChunks = 2048;
+
+	UPROPERTY(config)
+	int32 MaxCompressedChunkBytes = 64 * 1024;
+
+	UPROPERTY(config)
+	int32 MaxSpawnsPerChunk = 256;
+
+	UPROPERTY(config)
+	int32 MaxEnemies = 512;
+
+	UPROPERTY(config)
+	int32 MaxSpawns = 8192;
+};
+
+UENUM()
+enum class EITPUserLevelError : uint8
+{
+	None,
+	NotFound,
+	TooLarge,
+	BadHeader,
+	OverBudget,
+	CorruptTable,
+	CorruptChunk,
+	UnknownTile,
+	BadSpawn,
+};
+
+/**
+ * Finds and loads user levels (ITPLevelFile format) from Saved/UserLevels and any mounted directories.
+ *
+ * Files are untrusted: a streaming pass checks the header, chunk table and then each chunk against
+ * FITPUserLevelBudget, reading sizes before anything sized by them is allocated. Levels that pass are rewritten
+ * compacted into Saved/ITP/LevelCache, and later loads of the unchanged file skip straight to the cached copy.
+ */
+UCLASS(config = Game)
+class ITP_API UITPUserLevelSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Adds a directory searched by FindUserLevels, e.g. a downloaded level pack */
+	void MountDirectory(const FString& Directory);
+
+	/** Level files in every mounted directory */
+	TArray<FString> FindUserLevels() const;
+
+	/** Validates Filename and builds a transient level asset from it. Returns null and sets OutError on rejection. */
+	UITPChunkedLevel* LoadUserLevel(const FString& Filename, EITPUserLevelError& OutError);
+
+	/** Validation only; nothing proportional to the file's claimed sizes is allocated before it is checked */
+	EITPUserLevelError ValidateFile(const FString& Filename) const;
+
+	const FITPUserLevelBudget& GetBudget() const { return Budget; }
+
+private:
+	/** Cache entry for the current contents of Filename, keyed by path, size, timestamp and budget */
+	FString GetCacheFilename(const FString& Filename) const;
+
+	/** Full streaming validation. Fills OutLevel when given. */
+	EITPUserLevelError Validate(const FString& Filename, UITPChunkedLevel* OutLevel) const;
+
+	/** Reads an already validated cache file; only the header is re-checked */
+	bool LoadCached(const FString& CacheFilename, UITPChunkedLevel& OutLevel) const;
+
+	/** Set in DefaultGame.ini under [/Script/ITP.ITPUserLevelSubsystem] */
+	UPROPERTY(config)
+	FITPUserLevelBudget Budget;
+
+	TArray<FString> MountedDirectories;
+};
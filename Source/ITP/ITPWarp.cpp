@@ -0,0 +1,335 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPWarp.h"
+#include "ITP.h"
+#include "ITPActorPoolSubsystem.h"
+#include "ITPCharacter.h"
+#include "ITPCollision.h"
+#include "ITPTileMapActor.h"
+#include "Components/BoxComponent.h"
+#include "Components/SphereComponent.h"
+#include "Engine/AssetManager.h"
+#include "Engine/LevelStreamingDynamic.h"
+#include "Engine/StreamableManager.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Warp Prefetch Hits"), STAT_ITPWarpHits, STATGROUP_ITP);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Warp Prefetch Misses"), STAT_ITPWarpMisses, STATGROUP_ITP);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Warp Fallbacks"), STAT_ITPWarpFallbacks, STATGROUP_ITP);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Warp Latency Ms"), STAT_ITPWarpLatency, STATGROUP_ITP);
+
+namespace ITPWarp
+{
+	/** Process-wide metrics for ITP.Warp.Report */
+	static int32 NumWarps = 0;
+	static int32 NumHits = 0;
+	static int32 NumFallbacks = 0;
+	static double TotalLatencySeconds = 0.0;
+	static double MaxLatencySeconds = 0.0;
+}
+
+AITPWarp::AITPWarp()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	Entrance = CreateDefaultSubobject<UBoxComponent>(TEXT("Entrance"));
+	Entrance->InitBoxExtent(FVector(50.f, 50.f, 20.f));
+	Entrance->SetCollisionProfileName(ITPCollision::PickupProfile);
+	RootComponent = Entrance;
+
+	// Large enough that the prefetch usually finishes before the character reaches the entrance
+	PrefetchZone = CreateDefaultSubobject<USphereComponent>(TEXT("PrefetchZone"));
+	PrefetchZone->InitSphereRadius(1500.f);
+	PrefetchZone->SetCollisionProfileName(ITPCollision::PickupProfile);
+	PrefetchZone->SetupAttachment(Entrance);
+}
+
+void AITPWarp::BeginPlay()
+{
+	Super::BeginPlay();
+
+	PrefetchZone->OnComponentBeginOverlap.AddDynamic(this, &AITPWarp::OnPrefetchZoneOverlap);
+	Entrance->OnComponentBeginOverlap.AddDynamic(this, &AITPWarp::OnEntranceOverlap);
+}
+
+void AITPWarp::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (AssetHandle)
+	{
+		AssetHandle->CancelHandle();
+		AssetHandle.Reset();
+	}
+	if (ChunkTask.IsValid())
+	{
+		ChunkTask.Wait();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AITPWarp::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	// Decompressed chunks become instances on the game thread once the tile map exists; it may live in the sub-level
+	AITPTileMapActor* TileMap = DestinationTileMap.Get();
+	if (!bChunksBuilt && ChunkTask.IsValid() && ChunkTask.IsCompleted() && TileMap)
+	{
+		for (const FITPLevelChunk& Chunk : ChunkTask.GetResult())
+		{
+			TileMap->RebuildChunk(Chunk);
+		}
+		bChunksBuilt = true;
+	}
+
+	if (IsPrefetched())
+	{
+		ReleaseWaiting();
+		SetActorTickEnabled(false);
+		return;
+	}
+
+	// Never leave a character stuck hidden in the pipe
+	const bool bTimedOut = !Waiting.IsEmpty() && FPlatformTime::Seconds() - Waiting[0].Value >= MaxWaitSeconds;
+	if (bPrefetchFailed || bTimedOut)
+	{
+		if (!Waiting.IsEmpty())
+		{
+			UE_LOG(LogITP, Warning, TEXT("%s: %s, teleporting %d waiting character(s) without it"),
+				*GetName(), bPrefetchFailed ? TEXT("prefetch failed") : TEXT("prefetch timed out"), Waiting.Num());
+			INC_DWORD_STAT_BY(STAT_ITPWarpFallbacks, Waiting.Num());
+			ITPWarp::NumFallbacks += Waiting.Num();
+		}
+		ReleaseWaiting();
+
+		// A failed prefetch never completes; a slow one keeps going for the next character
+		SetActorTickEnabled(!bPrefetchFailed);
+	}
+}
+
+void AITPWarp::ReleaseWaiting()
+{
+	// Copied out: teleporting can overlap the entrance again
+	TArray<TPair<TWeakObjectPtr<AITPCharacter>, double>> Released = MoveTemp(Waiting);
+	Waiting.Reset();
+	for (const TPair<TWeakObjectPtr<AITPCharacter>, double>& Entry : Released)
+	{
+		if (AITPCharacter* Character = Entry.Key.Get())
+		{
+			const double Latency = FPlatformTime::Seconds() - Entry.Value;
+			ITPWarp::TotalLatencySeconds += Latency;
+			ITPWarp::MaxLatencySeconds = FMath::Max(ITPWarp::MaxLatencySeconds, Latency);
+			SET_FLOAT_STAT(STAT_ITPWarpLatency, Latency * 1000.0);
+			CompleteWarp(Character);
+		}
+	}
+}
+
+bool AITPWarp::IsPrefetched() const
+{
+	if (!bPrefetchStarted || bPrefetchFailed || (AssetHandle && !AssetHandle->HasLoadCompleted()))
+	{
+		return false;
+	}
+	if (!DestinationSubLevel.IsNull() && (!StreamedLevel || !StreamedLevel->IsLevelVisible()))
+	{
+		return false;
+	}
+	if (!DestinationTiles.IsNull() && !DestinationTileMap.IsNull() && !bChunksBuilt)
+	{
+		return false;
+	}
+
+	const UITPActorPoolSubsystem* Pool = GetWorld()->GetSubsystem<UITPActorPoolSubsystem>();
+	for (const TPair<TSoftClassPtr<AActor>, int32>& Pair : PooledActors)
+	{
+		if (Pool && Pair.Key.Get() && !Pool->IsWarm(Pair.Key.Get(), Pair.Value))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void AITPWarp::OnPrefetchZoneOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+	if (!bPrefetchStarted && Cast<AITPCharacter>(OtherActor))
+	{
+		StartPrefetch();
+	}
+}
+
+void AITPWarp::OnEntranceOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+	AITPCharacter* Character = Cast<AITPCharacter>(OtherActor);
+	if (!Character || Waiting.ContainsByPredicate([Character](const auto& Entry) { return Entry.Key == Character; }))
+	{
+		return;
+	}
+
+	if (!bPrefetchStarted)
+	{
+		StartPrefetch();
+	}
+
+	// Clients only warm their own caches; the authority moves the character and its movement replicates
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	if (IsPrefetched())
+	{
+		INC_DWORD_STAT(STAT_ITPWarpHits);
+		++ITPWarp::NumHits;
+		SET_FLOAT_STAT(STAT_ITPWarpLatency, 0.f);
+		CompleteWarp(Character);
+		return;
+	}
+
+	if (bPrefetchFailed)
+	{
+		INC_DWORD_STAT(STAT_ITPWarpMisses);
+		INC_DWORD_STAT(STAT_ITPWarpFallbacks);
+		++ITPWarp::NumFallbacks;
+		CompleteWarp(Character);
+		return;
+	}
+
+	// Not ready: park the character in the pipe until the prefetch completes
+	INC_DWORD_STAT(STAT_ITPWarpMisses);
+	Character->GetCharacterMovement()->DisableMovement();
+	Character->SetActorHiddenInGame(true);
+	Waiting.Emplace(Character, FPlatformTime::Seconds());
+	SetActorTickEnabled(true);
+}
+
+void AITPWarp::StartPrefetch()
+{
+	bPrefetchStarted = true;
+	SetActorTickEnabled(true);
+
+	if (!DestinationSubLevel.IsNull())
+	{
+		bool bSuccess = false;
+		StreamedLevel = ULevelStreamingDynamic::LoadLevelInstanceBySoftObjectPtr(this, DestinationSubLevel, FVector::ZeroVector, FRotator::ZeroRotator, bSuccess);
+		if (!bSuccess || !StreamedLevel)
+		{
+			FailPrefetch(*FString::Printf(TEXT("could not stream %s"), *DestinationSubLevel.ToString()));
+		}
+	}
+
+	TArray<FSoftObjectPath> Assets;
+	if (!DestinationTiles.IsNull())
+	{
+		Assets.Add(DestinationTiles.ToSoftObjectPath());
+	}
+	for (const TPair<TSoftClassPtr<AActor>, int32>& Pair : PooledActors)
+	{
+		Assets.Add(Pair.Key.ToSoftObjectPath());
+	}
+
+	if (Assets.IsEmpty())
+	{
+		OnAssetsLoaded();
+	}
+	else
+	{
+		AssetHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Assets, FStreamableDelegate::CreateUObject(this, &AITPWarp::OnAssetsLoaded));
+	}
+}
+
+void AITPWarp::OnAssetsLoaded()
+{
+	if (UITPActorPoolSubsystem* Pool = GetWorld()->GetSubsystem<UITPActorPoolSubsystem>())
+	{
+		for (const TPair<TSoftClassPtr<AActor>, int32>& Pair : PooledActors)
+		{
+			Pool->Prewarm(Pair.Key.Get(), Pair.Value);
+		}
+	}
+
+	const UITPChunkedLevel* Level = DestinationTiles.Get();
+	if (!Level)
+	{
+		if (!DestinationTiles.IsNull())
+		{
+			FailPrefetch(*FString::Printf(TEXT("could not load %s"), *DestinationTiles.ToString()));
+		}
+		return;
+	}
+
+	// Chunks around the destination. The map actor may only arrive with the sub-level, in which case its
+	// transform is assumed to be identity.
+	const FVector DestinationLocation = (Destination * GetActorTransform()).GetLocation();
+	const AITPTileMapActor* TileMap = DestinationTileMap.Get();
+	const FIntPoint Tile = TileMap ? TileMap->WorldToTile(DestinationLocation) : ITP2D::LocationToTile(ITP2D::FromWorld(DestinationLocation), Level->TileSize);
+	const FIntPoint Center = FITPLevelChunk::TileToChunk(Tile);
+
+	TArray<int32> Indices;
+	for (int32 Y = Center.Y - ChunkRadius; Y <= Center.Y + ChunkRadius; ++Y)
+	{
+		for (int32 X = Center.X - ChunkRadius; X <= Center.X + ChunkRadius; ++X)
+		{
+			const int32 Index = Level->FindChunk(FIntPoint(X, Y));
+			if (Index != INDEX_NONE)
+			{
+				Indices.Add(Index);
+			}
+		}
+	}
+
+	// The asset is held by AssetHandle and not modified while the task reads it
+	// Corrupt chunks are left out; the tile map then simply lacks them, as it would without the prefetch.
+	ChunkTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Level, Indices = MoveTemp(Indices)]()
+	{
+		TArray<FITPLevelChunk> Chunks;
+		Chunks.Reserve(Indices.Num());
+		for (const int32 Index : Indices)
+		{
+			if (!Level->LoadChunk(Index, Chunks.AddDefaulted_GetRef()))
+			{
+				UE_LOG(LogITP, Warning, TEXT("%s: chunk %d is corrupt"), *Level->GetName(), Index);
+				Chunks.Pop(false);
+			}
+		}
+		return Chunks;
+	});
+}
+
+void AITPWarp::FailPrefetch(const TCHAR* Reason)
+{
+	UE_LOG(LogITP, Warning, TEXT("%s: %s, warps will teleport without prefetching"), *GetName(), Reason);
+	bPrefetchFailed = true;
+	SetActorTickEnabled(true);
+}
+
+void AITPWarp::CompleteWarp(AITPCharacter* Character)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	const FTransform DestinationWorld = Destination * GetActorTransform();
+	Character->TeleportTo(DestinationWorld.GetLocation(), DestinationWorld.Rotator());
+	Character->SetActorHiddenInGame(false);
+	Character->GetCharacterMovement()->SetMovementMode(MOVE_Falling);
+	++ITPWarp::NumWarps;
+}
+
+static FAutoConsoleCommand CmdITPWarpReport(
+	TEXT("ITP.Warp.Report"),
+	TEXT("Logs warp prefetch hit rate and the latency of warps that had to wait."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		const int32 NumMisses = ITPWarp::NumWarps - ITPWarp::NumHits;
+		UE_LOG(LogITP, Log, TEXT("Warps: %d, prefetch hit rate %.1f%%, waited %d time(s), avg wait %.1f ms, max wait %.1f ms, %d fallback teleport(s)"),
+			ITPWarp::NumWarps,
+			ITPWarp::NumWarps > 0 ? 100.0 * ITPWarp::NumHits / ITPWarp::NumWarps : 0.0,
+			NumMisses,
+			NumMisses > 0 ? ITPWarp::TotalLatencySeconds * 1000.0 / NumMisses : 0.0,
+			ITPWarp::MaxLatencySeconds * 1000.0,
+			ITPWarp::NumFallbacks);
+	}));
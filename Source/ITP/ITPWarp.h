@@ -0,0 +1,106 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Tasks/Task.h"
+#include "ITPChunkedLevel.h"
+#include "ITPWarp.generated.h"
+
+class AITPCharacter;
+class AITPTileMapActor;
+class UBoxComponent;
+class ULevelStreamingDynamic;
+class USphereComponent;
+struct FStreamableHandle;
+
+/**
+ * Warp pipe / teleporter.
+ * When an ITP character enters PrefetchZone, everything the destination needs is prepared in the background:
+ * the sub-level is streamed in, the destination tile chunks are loaded and decompressed on a worker, and pooled
+ * actors are prewarmed. Entering the pipe then only teleports. If the prefetch hasn't finished, the character
+ * waits inside the pipe rather than the game thread waiting on I/O; both cases feed the hit rate and latency
+ * reported by ITP.Warp.Report. If part of the prefetch fails, or the wait exceeds MaxWaitSeconds, waiting
+ * characters are released with a plain teleport instead.
+ */
+UCLASS()
+class AITPWarp : public AActor
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, Category = Warp)
+	TObjectPtr<UBoxComponent> Entrance;
+
+	UPROPERTY(VisibleAnywhere, Category = Warp)
+	TObjectPtr<USphereComponent> PrefetchZone;
+
+public:
+	AITPWarp();
+
+	/** Where the character comes out */
+	UPROPERTY(EditAnywhere, Category = Warp, meta = (MakeEditWidget))
+	FTransform Destination;
+
+	/** Optional sub-area level streamed in around the destination */
+	UPROPERTY(EditAnywhere, Category = Warp)
+	TSoftObjectPtr<UWorld> DestinationSubLevel;
+
+	/** Optional tile level to build around the destination */
+	UPROPERTY(EditAnywhere, Category = Warp)
+	TSoftObjectPtr<UITPChunkedLevel> DestinationTiles;
+
+	UPROPERTY(EditAnywhere, Category = Warp)
+	TSoftObjectPtr<AITPTileMapActor> DestinationTileMap;
+
+	/** Chunks around the destination chunk to prepare, 1 = 3x3 */
+	UPROPERTY(EditAnywhere, Category = Warp)
+	int32 ChunkRadius = 1;
+
+	/** Actors the destination's spawners will need right away (enemies, pickups), prewarmed in the actor pool */
+	UPROPERTY(EditAnywhere, Category = Warp)
+	TMap<TSoftClassPtr<AActor>, int32> PooledActors;
+
+	/** Longest a character waits in the pipe before it is teleported without the prefetch */
+	UPROPERTY(EditAnywhere, Category = Warp)
+	float MaxWaitSeconds = 3.f;
+
+	bool IsPrefetched() const;
+
+	/** A part of the prefetch could not be loaded; warps fall back to a plain teleport */
+	bool HasPrefetchFailed() const { return bPrefetchFailed; }
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+
+private:
+	UFUNCTION()
+	void OnPrefetchZoneOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+	UFUNCTION()
+	void OnEntranceOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+	void StartPrefetch();
+	void OnAssetsLoaded();
+	void FailPrefetch(const TCHAR* Reason);
+	void CompleteWarp(AITPCharacter* Character);
+
+	/** Teleports everyone waiting, whether or not the prefetch finished */
+	void ReleaseWaiting();
+
+	bool bPrefetchStarted = false;
+	bool bPrefetchFailed = false;
+	TSharedPtr<FStreamableHandle> AssetHandle;
+
+	UPROPERTY(Transient)
+	TObjectPtr<ULevelStreamingDynamic> StreamedLevel;
+
+	/** Destination chunks decompressed off the game thread */
+	UE::Tasks::TTask<TArray<FITPLevelChunk>> ChunkTask;
+	bool bChunksBuilt = false;
+
+	/** Characters waiting inside the pipe for the prefetch, with the time they entered */
+	TArray<TPair<TWeakObjectPtr<AITPCharacter>, double>> Waiting;
+};
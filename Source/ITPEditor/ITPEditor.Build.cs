@@ -0,0 +1,15 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class ITPEditor : ModuleRules
+{
+	public ITPEditor(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "ITP" });
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "UnrealEd", "Json", "XmlParser" });
+	}
+}
@@ -0,0 +1,8 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPEditor.h"
+#include "Modules/ModuleManager.h"
+
+DEFINE_LOG_CATEGORY(LogITPEditor);
+
+IMPLEMENT_MODULE(FDefaultModuleImpl, ITPEditor);
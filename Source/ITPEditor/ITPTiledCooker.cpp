@@ -0,0 +1,164 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPTiledCooker.h"
+#include "ITPChunkedLevel.h"
+#include "ITPEditor.h"
+#include "ITPTiledMap.h"
+#include "Async/ParallelFor.h"
+#include "Hash/CityHash.h"
+#include "HAL/PlatformTime.h"
+#include "Serialization/MemoryWriter.h"
+#include <atomic>
+
+namespace ITPTiled
+{
+	static EITPSpawnType ClassifyObject(const FITPTiledObject& Object)
+	{
+		const FString* Override = Object.Properties.Find(TEXT("ITPType"));
+		const FString Class = (Override ? *Override : Object.Class).ToLower();
+
+		if (Class == TEXT("coin")) { return EITPSpawnType::Coin; }
+		if (Class == TEXT("enemy")) { return EITPSpawnType::Enemy; }
+		if (Class == TEXT("checkpoint")) { return EITPSpawnType::Checkpoint; }
+		if (Class == TEXT("playerstart") || Class == TEXT("spawn")) { return EITPSpawnType::PlayerStart; }
+		return EITPSpawnType::Other;
+	}
+
+	void CookMap(const FITPTiledMap& Map, UITPChunkedLevel& Level, FITPTiledCookStats& OutStats)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		constexpr int32 ChunkSize = FITPLevelChunk::ChunkSize;
+
+		const float TileSize = Level.TileSize;
+		const int32 NumLayers = Map.TileLayers.Num();
+		const FIntPoint NumChunks((Map.Width + ChunkSize - 1) / ChunkSize, (Map.Height + ChunkSize - 1) / ChunkSize);
+
+		// Bucket objects into chunks. Tiled is y-down in pixels; the plane is y-up in cm.
+		TArray<TArray<FITPSpawnEntry>> SpawnsPerChunk;
+		SpawnsPerChunk.SetNum(NumChunks.X * NumChunks.Y);
+		for (const FITPTiledObjectGroup& Group : Map.ObjectGroups)
+		{
+			for (const FITPTiledObject& Object : Group.Objects)
+			{
+				const float CenterX = Object.X + Object.Width * 0.5f;
+				const float CenterY = Object.bIsTileObject ? Object.Y - Object.Height * 0.5f : Object.Y + Object.Height * 0.5f;
+
+				FITPSpawnEntry Entry;
+				Entry.Type = ClassifyObject(Object);
+				Entry.SourceId = Object.Id;
+				Entry.Location = FVector2f(CenterX / Map.TileWidth * TileSize, ((float)Map.Height - CenterY / Map.TileHeight) * TileSize);
+				Entry.Archetype = FName(Object.Name.IsEmpty() ? *Object.Class : *Object.Name);
+
+				const FIntPoint Chunk = FITPLevelChunk::TileToChunk(ITP2D::LocationToTile(Entry.Location, TileSize));
+				if (Chunk.X >= 0 && Chunk.Y >= 0 && Chunk.X < NumChunks.X && Chunk.Y < NumChunks.Y)
+				{
+					SpawnsPerChunk[Chunk.Y * NumChunks.X + Chunk.X].Add(Entry);
+				}
+			}
+		}
+
+		// Previously cooked chunks, looked up by hash so they can be reused as-is
+		TMap<FIntPoint, const FITPCookedChunk*> Previous;
+		for (const FITPCookedChunk& Cooked : Level.Chunks)
+		{
+			Previous.Add(Cooked.Coord, &Cooked);
+		}
+
+		TArray<FITPCookedChunk> NewChunks;
+		NewChunks.SetNum(NumChunks.X * NumChunks.Y);
+		TArray<bool> bKeep;
+		bKeep.SetNumZeroed(NewChunks.Num());
+		std::atomic<int32> NumCooked = 0;
+		std::atomic<int32> NumReused = 0;
+
+		ParallelFor(NewChunks.Num(), [&](int32 ChunkIndex)
+		{
+			FITPLevelChunk Chunk;
+			Chunk.Coord = FIntPoint(ChunkIndex % NumChunks.X, ChunkIndex / NumChunks.X);
+			Chunk.Tiles.SetNumZeroed(NumLayers * FITPLevelChunk::TilesPerLayer);
+			Chunk.Spawns = MoveTemp(SpawnsPerChunk[ChunkIndex]);
+			Chunk.Spawns.StableSort([](const FITPSpawnEntry& A, const FITPSpawnEntry& B) { return A.Type < B.Type; });
+
+			bool bAnyTile = false;
+			for (int32 Layer = 0; Layer < NumLayers; ++Layer)
+			{
+				const FITPTiledTileLayer& Source = Map.TileLayers[Layer];
+				for (int32 LocalY = 0; LocalY < ChunkSize; ++LocalY)
+				{
+					const int32 TileY = Chunk.Coord.Y * ChunkSize + LocalY;
+					if (TileY >= Source.Height)
+					{
+						break;
+					}
+					const int32 Row = Source.Height - 1 - TileY;
+					for (int32 LocalX = 0; LocalX < ChunkSize; ++LocalX)
+					{
+						const int32 TileX = Chunk.Coord.X * ChunkSize + LocalX;
+						if (TileX >= Source.Width)
+						{
+							break;
+						}
+						const uint32 Gid = Source.Gids[Row * Source.Width + TileX];
+						Chunk.Tiles[FITPLevelChunk::GetTileIndex(Layer, LocalX, LocalY)] = (uint16)Gid;
+						bAnyTile |= Gid != 0;
+					}
+				}
+			}
+
+			if (!bAnyTile && Chunk.Spawns.Num() == 0)
+			{
+				return;
+			}
+
+			// Same bytes CookChunk hashes into SourceHash
+			TArray<uint8> Content;
+			FMemoryWriter Writer(Content);
+			Writer << Chunk;
+			const uint64 Hash = CityHash64((const char*)Content.GetData(), Content.Num());
+
+			FITPCookedChunk& Cooked = NewChunks[ChunkIndex];
+			const FITPCookedChunk* const* Existing = Previous.Find(Chunk.Coord);
+			if (Existing && (*Existing)->SourceHash == Hash)
+			{
+				Cooked = **Existing;
+				++NumReused;
+			}
+			else if (UITPChunkedLevel::CookChunk(Chunk, Cooked))
+			{
+				++NumCooked;
+			}
+			else
+			{
+				UE_LOG(LogITPEditor, Error, TEXT("Chunk (%d, %d) failed to compress and was left out"), Chunk.Coord.X, Chunk.Coord.Y);
+				return;
+			}
+			bKeep[ChunkIndex] = true;
+		});
+
+		// Chunk index order is Y-major, which is the order FindChunk expects
+		Level.Chunks.Reset();
+		for (int32 ChunkIndex = 0; ChunkIndex < NewChunks.Num(); ++ChunkIndex)
+		{
+			if (bKeep[ChunkIndex])
+			{
+				Level.Chunks.Add(MoveTemp(NewChunks[ChunkIndex]));
+			}
+		}
+
+		Level.SizeInTiles = FIntPoint(Map.Width, Map.Height);
+		Level.LayerNames.Reset();
+		for (const FITPTiledTileLayer& Layer : Map.TileLayers)
+		{
+			Level.LayerNames.Add(FName(*Layer.Name));
+		}
+
+		for (const FITPTiledObjectGroup& Group : Map.ObjectGroups)
+		{
+			OutStats.NumSpawns += Group.Objects.Num();
+		}
+		OutStats.NumChunks = Level.Chunks.Num();
+		OutStats.NumCooked = NumCooked;
+		OutStats.NumReused = NumReused;
+		OutStats.Seconds = FPlatformTime::Seconds() - StartTime;
+	}
+}
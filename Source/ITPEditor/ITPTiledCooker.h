@@ -0,0 +1,26 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FITPTiledMap;
+class UITPChunkedLevel;
+
+struct FITPTiledCookStats
+{
+	int32 NumChunks = 0;
+	int32 NumCooked = 0;
+	int32 NumReused = 0;
+	int32 NumSpawns = 0;
+	double Seconds = 0.0;
+};
+
+namespace ITPTiled
+{
+	/**
+	 * Cooks Map into Level's chunk format. Chunks whose source content hash matches a chunk already in Level
+	 * keep their compressed data, so re-importing a large map only compresses what changed.
+	 */
+	void CookMap(const FITPTiledMap& Map, UITPChunkedLevel& Level, FITPTiledCookStats& OutStats);
+}
@@ -0,0 +1,101 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPTiledLevelFactory.h"
+#include "ITPChunkedLevel.h"
+#include "ITPEditor.h"
+#include "ITPTiledCooker.h"
+#include "ITPTiledMap.h"
+#include "EditorFramework/AssetImportData.h"
+#include "Misc/FeedbackContext.h"
+
+UITPTiledLevelFactory::UITPTiledLevelFactory()
+{
+	SupportedClass = UITPChunkedLevel::StaticClass();
+	bCreateNew = false;
+	bEditorImport = true;
+	bText = false;
+
+	Formats.Add(TEXT("tmx;Tiled Map"));
+	Formats.Add(TEXT("tmj;Tiled JSON Map"));
+}
+
+UObject* UITPTiledLevelFactory::FactoryCreateFile(UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags, const FString& Filename, const TCHAR* Parms, FFeedbackContext* Warn, bool& bOutOperationCanceled)
+{
+	// Importing over an existing level keeps its chunks so unchanged ones are not re-cooked
+	UITPChunkedLevel* Level = FindObject<UITPChunkedLevel>(InParent, *InName.ToString());
+	if (!Level)
+	{
+		Level = NewObject<UITPChunkedLevel>(InParent, InClass, InName, Flags);
+	}
+
+	if (!ImportInto(*Level, Filename, Warn))
+	{
+		return nullptr;
+	}
+	return Level;
+}
+
+bool UITPTiledLevelFactory::CanReimport(UObject* Obj, TArray<FString>& OutFilenames)
+{
+	const UITPChunkedLevel* Level = Cast<UITPChunkedLevel>(Obj);
+	if (Level && Level->AssetImportData)
+	{
+		Level->AssetImportData->ExtractFilenames(OutFilenames);
+		return true;
+	}
+	return false;
+}
+
+void UITPTiledLevelFactory::SetReimportPaths(UObject* Obj, const TArray<FString>& NewReimportPaths)
+{
+	UITPChunkedLevel* Level = Cast<UITPChunkedLevel>(Obj);
+	if (Level && Level->AssetImportData && NewReimportPaths.Num() == 1)
+	{
+		Level->AssetImportData->UpdateFilenameOnly(NewReimportPaths[0]);
+	}
+}
+
+EReimportResult::Type UITPTiledLevelFactory::Reimport(UObject* Obj)
+{
+	UITPChunkedLevel* Level = Cast<UITPChunkedLevel>(Obj);
+	if (!Level || !Level->AssetImportData)
+	{
+		return EReimportResult::Failed;
+	}
+
+	const FString Filename = Level->AssetImportData->GetFirstFilename();
+	if (!ImportInto(*Level, Filename, GWarn))
+	{
+		return EReimportResult::Failed;
+	}
+
+	Level->MarkPackageDirty();
+	return EReimportResult::Succeeded;
+}
+
+int32 UITPTiledLevelFactory::GetPriority() const
+{
+	return ImportPriority;
+}
+
+bool UITPTiledLevelFactory::ImportInto(UITPChunkedLevel& Level, const FString& Filename, FFeedbackContext* Warn)
+{
+	FITPTiledMap Map;
+	FString Error;
+	if (!ITPTiled::ParseFile(Filename, Map, Error))
+	{
+		Warn->Logf(ELogVerbosity::Error, TEXT("Failed to import '%s': %s"), *Filename, *Error);
+		return false;
+	}
+
+	Level.Modify();
+
+	FITPTiledCookStats Stats;
+	ITPTiled::CookMap(Map, Level, Stats);
+
+	Level.AssetImportData->Update(Filename);
+
+	UE_LOG(LogITPEditor, Log, TEXT("Imported '%s': %d chunks (%d cooked, %d unchanged), %d objects in %.2fs"),
+		*Filename, Stats.NumChunks, Stats.NumCooked, Stats.NumReused, Stats.NumSpawns, Stats.Seconds);
+	return true;
+}
@@ -0,0 +1,32 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EditorReimportHandler.h"
+#include "Factories/Factory.h"
+#include "ITPTiledLevelFactory.generated.h"
+
+class UITPChunkedLevel;
+
+/** Imports Tiled .tmx/.tmj maps as UITPChunkedLevel assets and re-imports them incrementally */
+UCLASS()
+class UITPTiledLevelFactory : public UFactory, public FReimportHandler
+{
+	GENERATED_BODY()
+
+public:
+	UITPTiledLevelFactory();
+
+	// UFactory interface
+	virtual UObject* FactoryCreateFile(UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags, const FString& Filename, const TCHAR* Parms, FFeedbackContext* Warn, bool& bOutOperationCanceled) override;
+
+	// FReimportHandler interface
+	virtual bool CanReimport(UObject* Obj, TArray<FString>& OutFilenames) override;
+	virtual void SetReimportPaths(UObject* Obj, const TArray<FString>& NewReimportPaths) override;
+	virtual EReimportResult::Type Reimport(UObject* Obj) override;
+	virtual int32 GetPriority() const override;
+
+private:
+	static bool ImportInto(UITPChunkedLevel& Level, const FString& Filename, FFeedbackContext* Warn);
+};
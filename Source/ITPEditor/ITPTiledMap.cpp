@@ -0,0 +1,563 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "ITPTiledMap.h"
+#include "ITPEditor.h"
+#include "FastXml.h"
+#include "HAL/FileManager.h"
+#include "Misc/Base64.h"
+#include "Misc/Compression.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+
+namespace ITPTiled
+{
+	/** Decodes a layer's "data" in any non-XML encoding into gids with flip flags removed */
+	static bool DecodeLayerData(const FString& Encoding, const FString& Compression, const FString& Data, int32 NumTiles, TArray<uint32>& OutGids, FString& OutError)
+	{
+		OutGids.Reset(NumTiles);
+
+		if (Encoding == TEXT("csv"))
+		{
+			uint32 Value = 0;
+			bool bInNumber = false;
+			for (const TCHAR Char : Data)
+			{
+				if (FChar::IsDigit(Char))
+				{
+					Value = Value * 10 + (uint32)(Char - TEXT('0'));
+					bInNumber = true;
+				}
+				else if (bInNumber)
+				{
+					OutGids.Add(Value & GidMask);
+					Value = 0;
+					bInNumber = false;
+				}
+			}
+			if (bInNumber)
+			{
+				OutGids.Add(Value & GidMask);
+			}
+		}
+		else if (Encoding == TEXT("base64"))
+		{
+			TArray<uint8> Bytes;
+			if (!FBase64::Decode(Data.TrimStartAndEnd(), Bytes))
+			{
+				OutError = TEXT("invalid base64 layer data");
+				return false;
+			}
+
+			const int32 RawSize = NumTiles * (int32)sizeof(uint32);
+			if (!Compression.IsEmpty())
+			{
+				const FName Format = Compression == TEXT("zlib") ? NAME_Zlib : Compression == TEXT("gzip") ? NAME_Gzip : NAME_None;
+				if (Format.IsNone())
+				{
+					OutError = FString::Printf(TEXT("unsupported layer compression '%s'"), *Compression);
+					return false;
+				}
+
+				TArray<uint8> Raw;
+				Raw.SetNumUninitialized(RawSize);
+				if (!FCompression::UncompressMemory(Format, Raw.GetData(), RawSize, Bytes.GetData(), Bytes.Num()))
+				{
+					OutError = TEXT("layer data failed to decompress");
+					return false;
+				}
+				Bytes = MoveTemp(Raw);
+			}
+
+			if (Bytes.Num() != RawSize)
+			{
+				OutError = TEXT("layer data size does not match the layer dimensions");
+				return false;
+			}
+
+			// Little endian uint32 per tile
+			for (int32 Index = 0; Index < NumTiles; ++Index)
+			{
+				const uint8* Bytes4 = Bytes.GetData() + Index * 4;
+				const uint32 Gid = (uint32)Bytes4[0] | ((uint32)Bytes4[1] << 8) | ((uint32)Bytes4[2] << 16) | ((uint32)Bytes4[3] << 24);
+				OutGids.Add(Gid & GidMask);
+			}
+		}
+		else
+		{
+			OutError = FString::Printf(TEXT("unsupported layer encoding '%s'"), *Encoding);
+			return false;
+		}
+
+		if (OutGids.Num() != NumTiles)
+		{
+			OutError = FString::Printf(TEXT("layer has %d tiles, expected %d"), OutGids.Num(), NumTiles);
+			return false;
+		}
+		return true;
+	}
+
+	/** FFastXml callbacks for .tmx. Elements are handled as they stream past; only the open element chain is kept. */
+	class FTmxParser : public IFastXmlCallback
+	{
+	public:
+		explicit FTmxParser(FITPTiledMap& InMap) : Map(InMap) {}
+
+		FString Error;
+
+		virtual bool ProcessXmlDeclaration(const TCHAR* ElementData, int32 XmlFileLineNumber) override { return true; }
+		virtual bool ProcessComment(const TCHAR* Comment) override { return true; }
+
+		virtual bool ProcessElement(const TCHAR* ElementName, const TCHAR* ElementData, int32 XmlFileLineNumber) override
+		{
+			const FString Parent = Stack.Num() > 0 ? Stack.Last() : FString();
+			Stack.Add(ElementName);
+			LineNumber = XmlFileLineNumber;
+
+			if (Stack.Last() == TEXT("layer"))
+			{
+				Layer = &Map.TileLayers.AddDefaulted_GetRef();
+			}
+			else if (Stack.Last() == TEXT("data"))
+			{
+				Data = ElementData ? ElementData : TEXT("");
+				Encoding.Reset();
+				Compression.Reset();
+			}
+			else if (Stack.Last() == TEXT("tile") && Parent == TEXT("data") && Layer)
+			{
+				// <tile/> without a gid is an empty cell
+				Layer->Gids.Add(0);
+			}
+			else if (Stack.Last() == TEXT("chunk"))
+			{
+				return Fail(TEXT("infinite maps are not supported"));
+			}
+			else if (Stack.Last() == TEXT("objectgroup"))
+			{
+				Group = &Map.ObjectGroups.AddDefaulted_GetRef();
+			}
+			else if (Stack.Last() == TEXT("object") && Group)
+			{
+				Object = &Group->Objects.AddDefaulted_GetRef();
+			}
+			else if (Stack.Last() == TEXT("property"))
+			{
+				PropertyName.Reset();
+				PropertyValue = ElementData ? ElementData : TEXT("");
+			}
+			return true;
+		}
+
+		virtual bool ProcessAttribute(const TCHAR* AttributeName, const TCHAR* AttributeValue) override
+		{
+			const FString& Element = Stack.Last();
+			const FStringView Name(AttributeName);
+
+			if (Element == TEXT("map"))
+			{
+				if (Name == TEXT("width")) { Map.Width = FCString::Atoi(AttributeValue); }
+				else if (Name == TEXT("height")) { Map.Height = FCString::Atoi(AttributeValue); }
+				else if (Name == TEXT("tilewidth")) { Map.TileWidth = FCString::Atoi(AttributeValue); }
+				else if (Name == TEXT("tileheight")) { Map.TileHeight = FCString::Atoi(AttributeValue); }
+				else if (Name == TEXT("infinite") && FCString::Atoi(AttributeValue) != 0) { return Fail(TEXT("infinite maps are not supported")); }
+			}
+			else if (Element == TEXT("layer") && Layer)
+			{
+				if (Name == TEXT("name")) { Layer->Name = AttributeValue; }
+				else if (Name == TEXT("width")) { Layer->Width = FCString::Atoi(AttributeValue); }
+				else if (Name == TEXT("height")) { Layer->Height = FCString::Atoi(AttributeValue); }
+			}
+			else if (Element == TEXT("data"))
+			{
+				if (Name == TEXT("encoding")) { Encoding = AttributeValue; }
+				else if (Name == TEXT("compression")) { Compression = AttributeValue; }
+			}
+			else if (Element == TEXT("tile") && Stack.Num() >= 2 && Stack[Stack.Num() - 2] == TEXT("data") && Layer)
+			{
+				if (Name == TEXT("gid")) { Layer->Gids.Last() = (uint32)FCString::Strtoui64(AttributeValue, nullptr, 10) & GidMask; }
+			}
+			else if (Element == TEXT("objectgroup") && Group)
+			{
+				if (Name == TEXT("name")) { Group->Name = AttributeValue; }
+			}
+			else if (Element == TEXT("object") && Object)
+			{
+				if (Name == TEXT("id")) { Object->Id = FCString::Atoi(AttributeValue); }
+				else if (Name == TEXT("name")) { Object->Name = AttributeValue; }
+				else if (Name == TEXT("type") || Name == TEXT("class")) { Object->Class = AttributeValue; }
+				else if (Name == TEXT("x")) { Object->X = FCString::Atof(AttributeValue); }
+				else if (Name == TEXT("y")) { Object->Y = FCString::Atof(AttributeValue); }
+				else if (Name == TEXT("width")) { Object->Width = FCString::Atof(AttributeValue); }
+				else if (Name == TEXT("height")) { Object->Height = FCString::Atof(AttributeValue); }
+				else if (Name == TEXT("gid")) { Object->bIsTileObject = true; }
+			}
+			else if (Element == TEXT("property"))
+			{
+				if (Name == TEXT("name")) { PropertyName = AttributeValue; }
+				else if (Name == TEXT("value")) { PropertyValue = AttributeValue; }
+			}
+			return true;
+		}
+
+		virtual bool ProcessClose(const TCHAR* Element) override
+		{
+			const FStringView Name(Element);
+
+			if (Name == TEXT("data") && Layer && !Encoding.IsEmpty())
+			{
+				FString DecodeError;
+				if (!DecodeLayerData(Encoding, Compression, Data, Layer->Width * Layer->Height, Layer->Gids, DecodeError))
+				{
+					return Fail(DecodeError);
+				}
+			}
+			else if (Name == TEXT("property") && Stack.Num() >= 3)
+			{
+				// property -> properties -> owner
+				const FString& Owner = Stack[Stack.Num() - 3];
+				if (Owner == TEXT("map"))
+				{
+					Map.Properties.Add(PropertyName, PropertyValue);
+				}
+				else if (Owner == TEXT("object") && Object)
+				{
+					Object->Properties.Add(PropertyName, PropertyValue);
+				}
+			}
+			else if (Name == TEXT("layer"))
+			{
+				Layer = nullptr;
+			}
+			else if (Name == TEXT("object"))
+			{
+				Object = nullptr;
+			}
+			else if (Name == TEXT("objectgroup"))
+			{
+				Group = nullptr;
+			}
+
+			Stack.Pop(false);
+			return true;
+		}
+
+	private:
+		bool Fail(const FString& Message)
+		{
+			Error = FString::Printf(TEXT("line %d: %s"), LineNumber, *Message);
+			return false;
+		}
+
+		FITPTiledMap& Map;
+		TArray<FString> Stack;
+		int32 LineNumber = 0;
+
+		FITPTiledTileLayer* Layer = nullptr;
+		FITPTiledObjectGroup* Group = nullptr;
+		FITPTiledObject* Object = nullptr;
+
+		FString Data;
+		FString Encoding;
+		FString Compression;
+		FString PropertyName;
+		FString PropertyValue;
+	};
+
+	static bool ParseTmx(const FString& Filename, FITPTiledMap& OutMap, FString& OutError)
+	{
+		FTmxParser Parser(OutMap);
+		FText XmlError;
+		int32 XmlErrorLine = 0;
+		if (!FFastXml::ParseXmlFile(&Parser, *Filename, nullptr, nullptr, false, false, XmlError, XmlErrorLine))
+		{
+			OutError = !Parser.Error.IsEmpty() ? Parser.Error : FString::Printf(TEXT("line %d: %s"), XmlErrorLine, *XmlError.ToString());
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Token-level walker for .tmj. Nothing but the current layer/object is held in memory; Tiled does not
+	 * guarantee key order, so each layer is classified by its "type" when its object closes.
+	 */
+	class FTmjParser
+	{
+	public:
+		explicit FTmjParser(FITPTiledMap& InMap) : Map(InMap) {}
+
+		bool Parse(FArchive& Archive, FString& OutError)
+		{
+			TSharedRef<TJsonReader<UTF8CHAR>> Reader = TJsonReader<UTF8CHAR>::Create(&Archive);
+
+			EJsonNotation Notation;
+			while (Reader->ReadNext(Notation))
+			{
+				const FString& Identifier = Reader->GetIdentifier();
+				switch (Notation)
+				{
+				case EJsonNotation::ObjectStart:
+					OpenScope(EScope::Object, Identifier);
+					break;
+				case EJsonNotation::ArrayStart:
+					OpenScope(EScope::Array, Identifier);
+					break;
+				case EJsonNotation::ObjectEnd:
+				case EJsonNotation::ArrayEnd:
+					if (!CloseScope(OutError))
+					{
+						return false;
+					}
+					break;
+				case EJsonNotation::Number:
+					HandleValue(Identifier, Reader->GetValueAsNumberString(), Reader->GetValueAsNumber());
+					break;
+				case EJsonNotation::String:
+					HandleValue(Identifier, Reader->GetValueAsString(), 0.0);
+					break;
+				case EJsonNotation::Boolean:
+					HandleValue(Identifier, Reader->GetValueAsBoolean() ? TEXT("true") : TEXT("false"), Reader->GetValueAsBoolean() ? 1.0 : 0.0);
+					break;
+				case EJsonNotation::Error:
+					OutError = Reader->GetErrorMessage();
+					return false;
+				default:
+					break;
+				}
+			}
+
+			if (!Reader->GetErrorMessage().IsEmpty())
+			{
+				OutError = Reader->GetErrorMessage();
+				return false;
+			}
+			return true;
+		}
+
+	private:
+		enum class EScope : uint8 { Object, Array };
+		enum class ERole : uint8 { Other, Map, Layer, LayerData, Object, Property, PropertyList };
+
+		struct FScope
+		{
+			EScope Kind;
+			ERole Role;
+			FString Identifier;
+		};
+
+		struct FPendingLayer
+		{
+			FString Type;
+			FString Name;
+			int32 Width = 0;
+			int32 Height = 0;
+			FString Encoding;
+			FString Compression;
+			FString EncodedData;
+			TArray<uint32> Gids;
+			TArray<FITPTiledObject> Objects;
+		};
+
+		ERole ParentRole() const { return Stack.Num() > 0 ? Stack.Last().Role : ERole::Other; }
+
+		void OpenScope(EScope Kind, const FString& Identifier)
+		{
+			ERole Role = ERole::Other;
+			if (Stack.Num() == 0)
+			{
+				Role = ERole::Map;
+			}
+			else if (Kind == EScope::Array && Identifier == TEXT("properties"))
+			{
+				Role = ERole::PropertyList;
+			}
+			else if (Kind == EScope::Array && Identifier == TEXT("data") && ParentRole() == ERole::Layer)
+			{
+				Role = ERole::LayerData;
+			}
+			else if (Kind == EScope::Object && Stack.Num() >= 2 && Stack.Last().Identifier == TEXT("layers"))
+			{
+				Role = ERole::Layer;
+				Layers.AddDefaulted();
+			}
+			else if (Kind == EScope::Object && Stack.Num() >= 2 && Stack.Last().Identifier == TEXT("objects") && Stack[Stack.Num() - 2].Role == ERole::Layer)
+			{
+				Role = ERole::Object;
+				Object = FITPTiledObject();
+			}
+			else if (Kind == EScope::Object && ParentRole() == ERole::PropertyList)
+			{
+				Role = ERole::Property;
+				PropertyName.Reset();
+				PropertyValue.Reset();
+			}
+			Stack.Add({ Kind, Role, Identifier });
+		}
+
+		bool CloseScope(FString& OutError)
+		{
+			const FScope Scope = Stack.Pop(false);
+
+			if (Scope.Role == ERole::Layer)
+			{
+				FPendingLayer Layer = Layers.Pop(false);
+				if (Layer.Type == TEXT("tilelayer"))
+				{
+					FITPTiledTileLayer& TileLayer = Map.TileLayers.AddDefaulted_GetRef();
+					TileLayer.Name = Layer.Name;
+					TileLayer.Width = Layer.Width;
+					TileLayer.Height = Layer.Height;
+					if (!Layer.Encoding.IsEmpty() && Layer.Encoding != TEXT("csv"))
+					{
+						if (!DecodeLayerData(Layer.Encoding, Layer.Compression, Layer.EncodedData, Layer.Width * Layer.Height, TileLayer.Gids, OutError))
+						{
+							return false;
+						}
+					}
+					else
+					{
+						TileLayer.Gids = MoveTemp(Layer.Gids);
+					}
+				}
+				else if (Layer.Type == TEXT("objectgroup"))
+				{
+					FITPTiledObjectGroup& Group = Map.ObjectGroups.AddDefaulted_GetRef();
+					Group.Name = Layer.Name;
+					Group.Objects = MoveTemp(Layer.Objects);
+				}
+			}
+			else if (Scope.Role == ERole::Object)
+			{
+				Layers.Last().Objects.Add(MoveTemp(Object));
+			}
+			else if (Scope.Role == ERole::Property)
+			{
+				// property object -> properties array -> owner
+				const ERole Owner = ParentRole() == ERole::PropertyList && Stack.Num() >= 2 ? Stack[Stack.Num() - 2].Role : ERole::Other;
+				if (Owner == ERole::Map)
+				{
+					Map.Properties.Add(PropertyName, PropertyValue);
+				}
+				else if (Owner == ERole::Object)
+				{
+					Object.Properties.Add(PropertyName, PropertyValue);
+				}
+			}
+			return true;
+		}
+
+		void HandleValue(const FString& Identifier, const FString& String, double Number)
+		{
+			switch (ParentRole())
+			{
+			case ERole::Map:
+				if (Identifier == TEXT("width")) { Map.Width = (int32)Number; }
+				else if (Identifier == TEXT("height")) { Map.Height = (int32)Number; }
+				else if (Identifier == TEXT("tilewidth")) { Map.TileWidth = (int32)Number; }
+				else if (Identifier == TEXT("tileheight")) { Map.TileHeight = (int32)Number; }
+				else if (Identifier == TEXT("infinite") && Number != 0.0) { bInfinite = true; }
+				break;
+			case ERole::Layer:
+			{
+				FPendingLayer& Layer = Layers.Last();
+				if (Identifier == TEXT("type")) { Layer.Type = String; }
+				else if (Identifier == TEXT("name")) { Layer.Name = String; }
+				else if (Identifier == TEXT("width")) { Layer.Width = (int32)Number; }
+				else if (Identifier == TEXT("height")) { Layer.Height = (int32)Number; }
+				else if (Identifier == TEXT("encoding")) { Layer.Encoding = String; }
+				else if (Identifier == TEXT("compression")) { Layer.Compression = String; }
+				else if (Identifier == TEXT("data")) { Layer.EncodedData = String; }
+				break;
+			}
+			case ERole::LayerData:
+				Layers.Last().Gids.Add((uint32)Number & GidMask);
+				break;
+			case ERole::Object:
+				if (Identifier == TEXT("id")) { Object.Id = (int32)Number; }
+				else if (Identifier == TEXT("name")) { Object.Name = String; }
+				else if (Identifier == TEXT("type") || Identifier == TEXT("class")) { Object.Class = String; }
+				else if (Identifier == TEXT("x")) { Object.X = (float)Number; }
+				else if (Identifier == TEXT("y")) { Object.Y = (float)Number; }
+				else if (Identifier == TEXT("width")) { Object.Width = (float)Number; }
+				else if (Identifier == TEXT("height")) { Object.Height = (float)Number; }
+				else if (Identifier == TEXT("gid")) { Object.bIsTileObject = true; }
+				break;
+			case ERole::Property:
+				if (Identifier == TEXT("name")) { PropertyName = String; }
+				else if (Identifier == TEXT("value")) { PropertyValue = String; }
+				break;
+			default:
+				break;
+			}
+		}
+
+	public:
+		bool bInfinite = false;
+
+	private:
+		FITPTiledMap& Map;
+		TArray<FScope> Stack;
+
+		/** Group layers nest, so pending layers form a stack too */
+		TArray<FPendingLayer> Layers;
+
+		FITPTiledObject Object;
+		FString PropertyName;
+		FString PropertyValue;
+	};
+
+	static bool ParseTmj(const FString& Filename, FITPTiledMap& OutMap, FString& OutError)
+	{
+		TUniquePtr<FArchive> FileReader(IFileManager::Get().CreateFileReader(*Filename));
+		if (!FileReader)
+		{
+			OutError = TEXT("could not open file");
+			return false;
+		}
+
+		FTmjParser Parser(OutMap);
+		if (!Parser.Parse(*FileReader, OutError))
+		{
+			return false;
+		}
+		if (Parser.bInfinite)
+		{
+			OutError = TEXT("infinite maps are not supported");
+			return false;
+		}
+		return true;
+	}
+
+	bool ParseFile(const FString& Filename, FITPTiledMap& OutMap, FString& OutError)
+	{
+		const FString Extension = FPaths::GetExtension(Filename).ToLower();
+		const bool bParsed = Extension == TEXT("tmx") ? ParseTmx(Filename, OutMap, OutError) : ParseTmj(Filename, OutMap, OutError);
+		if (!bParsed)
+		{
+			return false;
+		}
+
+		if (OutMap.Width <= 0 || OutMap.Height <= 0 || OutMap.TileWidth <= 0 || OutMap.TileHeight <= 0)
+		{
+			OutError = TEXT("map has no size");
+			return false;
+		}
+
+		for (const FITPTiledTileLayer& Layer : OutMap.TileLayers)
+		{
+			if (Layer.Gids.Num() != Layer.Width * Layer.Height)
+			{
+				OutError = FString::Printf(TEXT("layer '%s' has %d tiles, expected %d"), *Layer.Name, Layer.Gids.Num(), Layer.Width * Layer.Height);
+				return false;
+			}
+
+			const int32 TooLarge = Layer.Gids.IndexOfByPredicate([](uint32 Gid) { return Gid > MaxGid; });
+			if (TooLarge != INDEX_NONE)
+			{
+				OutError = FString::Printf(TEXT("layer '%s' tile (%d, %d) has gid %u, cooked levels store at most %u"),
+					*Layer.Name, TooLarge % Layer.Width, TooLarge / Layer.Width, Layer.Gids[TooLarge], MaxGid);
+				return false;
+			}
+		}
+		return true;
+	}
+}
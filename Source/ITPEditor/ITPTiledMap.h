@@ -0,0 +1,65 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Tiled map contents the cooker needs. Flip flags are already stripped from tile gids. */
+struct FITPTiledObject
+{
+	int32 Id = 0;
+	FString Name;
+
+	/** "class" in Tiled 1.9+, "type" before that */
+	FString Class;
+
+	float X = 0.f;
+	float Y = 0.f;
+	float Width = 0.f;
+	float Height = 0.f;
+
+	/** Tile objects are anchored bottom-left instead of top-left */
+	bool bIsTileObject = false;
+
+	TMap<FString, FString> Properties;
+};
+
+struct FITPTiledTileLayer
+{
+	FString Name;
+	int32 Width = 0;
+	int32 Height = 0;
+
+	/** Row-major from the top row, 0 is empty */
+	TArray<uint32> Gids;
+};
+
+struct FITPTiledObjectGroup
+{
+	FString Name;
+	TArray<FITPTiledObject> Objects;
+};
+
+struct FITPTiledMap
+{
+	int32 Width = 0;
+	int32 Height = 0;
+	int32 TileWidth = 0;
+	int32 TileHeight = 0;
+
+	TArray<FITPTiledTileLayer> TileLayers;
+	TArray<FITPTiledObjectGroup> ObjectGroups;
+	TMap<FString, FString> Properties;
+};
+
+namespace ITPTiled
+{
+	/** Mask removing the flip/rotation flags from a gid */
+	constexpr uint32 GidMask = 0x0FFFFFFF;
+
+	/** Largest gid a cooked chunk can hold; FITPLevelChunk stores tiles as uint16 */
+	constexpr uint32 MaxGid = MAX_uint16;
+
+	/** Streams a .tmx (XML) or .tmj/.json (JSON) map. Group layers are flattened. Infinite maps and gids above MaxGid are rejected. */
+	bool ParseFile(const FString& Filename, FITPTiledMap& OutMap, FString& OutError);
+}